@@ -0,0 +1,251 @@
+/***************************************************************************//**
+ * @file async_log.c
+ * @brief Asynchronous debug log, drained to the VCOM by a low priority task
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "em_core.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "async_log.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define ASYNC_LOG_RING_MASK (ASYNC_LOG_RING_LENGTH - 1)
+#define ASYNC_LOG_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+///Drain task notification bits
+#define ASYNC_LOG_NOTIFY_RECORD    (1UL << 0)
+#define ASYNC_LOG_NOTIFY_UART_DONE (1UL << 1)
+
+///Wait before handing a batch the UART driver refused to it again
+#define ASYNC_LOG_RETRY_MS 10
+
+typedef struct
+{
+  uint8_t length;
+  uint8_t data[ASYNC_LOG_RECORD_SIZE - 1];
+} async_log_record_t;
+
+/// Single producer, single consumer ring: head is only written by the
+/// producer, tail only by the drain task.
+typedef struct
+{
+  async_log_record_t records[ASYNC_LOG_RING_LENGTH];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+} async_log_ring_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static async_log_record_t *reserveRecord(async_log_producer_t producer);
+static void commitRecord(async_log_producer_t producer);
+static void drainTaskFunction(void *parameters);
+static uint32_t fillBatch(void);
+static void commitBatch(void);
+static void uartTxCallback(UARTDRV_Handle_t handle, Ecode_t transferStatus,
+                           uint8_t *data, UARTDRV_Count_t transferCount);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static async_log_ring_t rings[ASYNC_LOG_PRODUCER_COUNT];
+static async_log_stats_t stats;
+
+///Contiguous copy of the records handed to the UART DMA
+static uint8_t batch[ASYNC_LOG_BATCH_SIZE];
+///Ring tails once the records of the batch are handed back
+static uint32_t batchTails[ASYNC_LOG_PRODUCER_COUNT];
+
+static UARTDRV_Handle_t uartHandle;
+static volatile Ecode_t lastTransferStatus;
+
+static StaticTask_t drainTaskTCB;
+static StackType_t drainTaskStack[ASYNC_LOG_STACK_SIZE];
+static TaskHandle_t drainTaskHandle;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+bool async_log_init(UARTDRV_Handle_t uart, uint32_t priority)
+{
+  uartHandle = uart;
+  drainTaskHandle = xTaskCreateStatic(drainTaskFunction, "logTask", ASYNC_LOG_STACK_SIZE, NULL, priority, drainTaskStack, &drainTaskTCB);
+  return drainTaskHandle != NULL;
+}
+
+void async_log_printf(async_log_producer_t producer, const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  async_log_vprintf(producer, format, args);
+  va_end(args);
+}
+
+void async_log_vprintf(async_log_producer_t producer, const char *format, va_list args)
+{
+  async_log_record_t *record = reserveRecord(producer);
+  int length;
+
+  if (record == NULL) {
+    return;
+  }
+  length = vsnprintf((char *)record->data, sizeof(record->data), format, args);
+  if (length < 0) {
+    return;
+  }
+  record->length = (length < (int)sizeof(record->data)) ? (uint8_t)length : (uint8_t)(sizeof(record->data) - 1);
+  commitRecord(producer);
+}
+
+void async_log_write(async_log_producer_t producer, const uint8_t *data, uint32_t length)
+{
+  async_log_record_t *record;
+
+  if (length > sizeof(record->data)) {
+    stats.producers[producer].overflows++;
+    return;
+  }
+  record = reserveRecord(producer);
+  if (record == NULL) {
+    return;
+  }
+  memcpy(record->data, data, length);
+  record->length = (uint8_t)length;
+  commitRecord(producer);
+}
+
+const async_log_stats_t *async_log_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Returns the next free record of the producer's ring, NULL if the ring is full
+async_log_record_t *reserveRecord(async_log_producer_t producer)
+{
+  async_log_ring_t *ring = &rings[producer];
+  uint32_t head = ring->head;
+
+  if (head - ring->tail >= ASYNC_LOG_RING_LENGTH) {
+    stats.producers[producer].overflows++;
+    return NULL;
+  }
+  return &ring->records[head & ASYNC_LOG_RING_MASK];
+}
+
+///Publishes the record returned by reserveRecord() and wakes the drain task up
+void commitRecord(async_log_producer_t producer)
+{
+  async_log_ring_t *ring = &rings[producer];
+
+  //The record must be complete before the drain task can see it
+  __DMB();
+  ring->head = ring->head + 1;
+  stats.producers[producer].written++;
+
+  if (drainTaskHandle != NULL) {
+    if (CORE_InIrqContext()) {
+      BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+      xTaskNotifyFromISR(drainTaskHandle, ASYNC_LOG_NOTIFY_RECORD, eSetBits, &xHigherPriorityTaskWoken);
+      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    } else {
+      xTaskNotify(drainTaskHandle, ASYNC_LOG_NOTIFY_RECORD, eSetBits);
+    }
+  }
+}
+
+///Drain task, sends the queued records in batches while nobody else needs the CPU
+void drainTaskFunction(void *parameters)
+{
+  uint32_t length;
+  uint32_t events;
+  bool retry = false;
+  (void)parameters;
+
+  while (true) {
+    xTaskNotifyWait(0, ASYNC_LOG_NOTIFY_RECORD | ASYNC_LOG_NOTIFY_UART_DONE, NULL,
+                    retry ? pdMS_TO_TICKS(ASYNC_LOG_RETRY_MS) : portMAX_DELAY);
+    retry = false;
+
+    while ((length = fillBatch()) > 0) {
+      if (UARTDRV_Transmit(uartHandle, batch, length, uartTxCallback) != ECODE_EMDRV_UARTDRV_OK) {
+        //The records stay in the rings, the next batch takes them again
+        stats.uartErrors++;
+        retry = true;
+        break;
+      }
+      commitBatch();
+      //Sleep until the DMA is done with the batch buffer, new records are
+      //picked up by the next fillBatch() anyway
+      do {
+        xTaskNotifyWait(0, ASYNC_LOG_NOTIFY_UART_DONE, &events, portMAX_DELAY);
+      } while (!(events & ASYNC_LOG_NOTIFY_UART_DONE));
+      if (lastTransferStatus != ECODE_OK) {
+        stats.uartErrors++;
+      }
+      stats.batches++;
+      stats.bytes += length;
+    }
+  }
+}
+
+///Copies as many whole records as fit from the rings to the batch buffer,
+///the rings keep them until commitBatch()
+uint32_t fillBatch(void)
+{
+  uint32_t length = 0;
+
+  for (uint32_t i = 0; i < ASYNC_LOG_PRODUCER_COUNT; i++) {
+    async_log_ring_t *ring = &rings[i];
+    uint32_t tail = ring->tail;
+
+    while (tail != ring->head) {
+      async_log_record_t *record = &ring->records[tail & ASYNC_LOG_RING_MASK];
+      if (length + record->length > sizeof(batch)) {
+        break;
+      }
+      memcpy(&batch[length], record->data, record->length);
+      length += record->length;
+      tail++;
+    }
+    batchTails[i] = tail;
+  }
+  return length;
+}
+
+///Hands the slots of the batch back to the producers, once the UART took it
+void commitBatch(void)
+{
+  //The records must be copied before a producer reuses their slots
+  __DMB();
+  for (uint32_t i = 0; i < ASYNC_LOG_PRODUCER_COUNT; i++) {
+    rings[i].tail = batchTails[i];
+  }
+}
+
+void uartTxCallback(UARTDRV_Handle_t handle, Ecode_t transferStatus,
+                    uint8_t *data, UARTDRV_Count_t transferCount)
+{
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  (void)handle;
+  (void)data;
+  (void)transferCount;
+
+  lastTransferStatus = transferStatus;
+  xTaskNotifyFromISR(drainTaskHandle, ASYNC_LOG_NOTIFY_UART_DONE, eSetBits, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
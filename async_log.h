@@ -0,0 +1,105 @@
+/***************************************************************************//**
+ * @file async_log.h
+ * @brief Asynchronous debug log, drained to the VCOM by a low priority task
+ ******************************************************************************/
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_uartdrv_instances.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Every producer context owns one ring, a ring must only be written from
+/// that context.
+typedef enum
+{
+  ASYNC_LOG_TRANSMITTER,
+  ASYNC_LOG_RECEIVER,
+  ASYNC_LOG_GENERATOR,
+  ASYNC_LOG_ISR,
+  ASYNC_LOG_PRODUCER_COUNT
+} async_log_producer_t;
+
+typedef struct
+{
+  uint32_t written;
+  uint32_t overflows; //Records dropped because the ring was full
+} async_log_producer_stats_t;
+
+typedef struct
+{
+  async_log_producer_stats_t producers[ASYNC_LOG_PRODUCER_COUNT];
+  uint32_t batches;
+  uint32_t bytes;
+  uint32_t uartErrors; //Batches the driver refused, sent again later, or failed in transfer
+} async_log_stats_t;
+
+#if (ASYNC_LOG_RING_LENGTH & (ASYNC_LOG_RING_LENGTH - 1))
+#error "ASYNC_LOG_RING_LENGTH must be a power of two"
+#endif
+
+#if ASYNC_LOG_BATCH_SIZE < ASYNC_LOG_RECORD_SIZE
+#error "ASYNC_LOG_BATCH_SIZE must hold at least one record"
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Creates the drain task.
+ *
+ * @param uart UART the records are written to
+ * @param priority Priority of the drain task, should be the lowest one in use
+ * @returns true if the task could be created
+ *****************************************************************************/
+bool async_log_init(UARTDRV_Handle_t uart, uint32_t priority);
+
+/**************************************************************************//**
+ * Formats a record into the producer's ring, never blocks.
+ *
+ * @param producer Ring of the calling context
+ * @param format printf style format, the output is truncated to
+ *               ASYNC_LOG_RECORD_SIZE - 1 characters
+ *
+ * If the ring is full the record is dropped and counted as an overflow.
+ *****************************************************************************/
+void async_log_printf(async_log_producer_t producer, const char *format, ...)
+  __attribute__((format(printf, 2, 3)));
+
+/**************************************************************************//**
+ * async_log_printf() taking a va_list.
+ *
+ * @param producer Ring of the calling context
+ * @param format printf style format
+ * @param args Format arguments
+ *****************************************************************************/
+void async_log_vprintf(async_log_producer_t producer, const char *format, va_list args);
+
+/**************************************************************************//**
+ * Queues raw bytes as one record, never blocks.
+ *
+ * @param producer Ring of the calling context
+ * @param data Bytes to send as they are
+ * @param length Number of bytes, at most ASYNC_LOG_RECORD_SIZE - 1
+ *
+ * Records that are too long or don't fit in the ring are dropped and
+ * counted as overflows.
+ *****************************************************************************/
+void async_log_write(async_log_producer_t producer, const uint8_t *data, uint32_t length);
+
+/**************************************************************************//**
+ * Gives access to the logging counters.
+ *
+ * @returns Pointer to the counters
+ *****************************************************************************/
+const async_log_stats_t *async_log_get_stats(void);
+
+#endif  // ASYNC_LOG_H
@@ -112,9 +112,9 @@ static const uint32_t phyInfo_1[] = {
 };
 
 const uint32_t Protocol_Configuration_modemConfigBase[] = {
-  0x00020004UL, 0x00000000UL,
-  /*    0008 */ 0x00000000UL,
-  0x00020018UL, 0x0000000FUL,
+  0x00020004UL, 0x00008001UL,
+  /*    0008 */ 0x000000FFUL,
+  0x00020018UL, 0x00000000UL,
   /*    001C */ 0x00000000UL,
   0x00040028UL, 0x00000000UL,
   /*    002C */ 0x00000000UL,
@@ -123,10 +123,10 @@ const uint32_t Protocol_Configuration_modemConfigBase[] = {
   0x00010048UL, 0x00000000UL,
   0x00020054UL, 0x00000000UL,
   /*    0058 */ 0x00000000UL,
-  0x000400A0UL, 0x00004CFFUL,
-  /*    00A4 */ 0x00000000UL,
-  /*    00A8 */ 0x00004DFFUL,
-  /*    00AC */ 0x00000000UL,
+  0x000400A0UL, 0x00004800UL,
+  /*    00A4 */ 0x00004CFFUL,
+  /*    00A8 */ 0x00004900UL,
+  /*    00AC */ 0x00004DFFUL,
   0x00012000UL, 0x00000744UL,
   0x00012010UL, 0x00000000UL,
   0x00012018UL, 0x0000A001UL,
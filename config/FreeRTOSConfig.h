@@ -69,8 +69,10 @@
 
 //  <o>Kernel tick frequency [Hz] <0-0xFFFFFFFF>
 //  <i> Kernel tick rate in Hz.
-//  <i> Default: 1000
-#define configTICK_RATE_HZ                      1000
+//  <i> With tickless idle the tick is derived from the 32768 Hz sleeptimer,
+//  <i> keep it an exact divisor of that or the kernel time drifts.
+//  <i> Default: 1024
+#define configTICK_RATE_HZ                      1024
 
 //  <o>Timer task stack depth [words] <0-65535>
 //  <i> Stack for timer task in words.
@@ -278,6 +280,9 @@
 #define configUSE_TICKLESS_IDLE                       0
 #endif
 
+/* Shortest idle period, in ticks, worth suppressing the tick for. */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP         2
+
 /* Definition used by Keil to replace default system clock source. */
 #define configOVERRIDE_DEFAULT_TICK_CONFIGURATION     1
 
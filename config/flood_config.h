@@ -0,0 +1,323 @@
+/***************************************************************************//**
+ * @file
+ * @brief Flood sink configuration file.
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+#ifndef FLOOD_CONFIG_H
+#define FLOOD_CONFIG_H
+
+// <h>Packet format
+
+// <o PKT_WIRE_VERSION> Frame layout sent on air
+//   <1=> v1, fixed 16 bytes, 16 bit sequence numbers
+//   <2=> v2, variable length, 24 bit sequence numbers
+// <i> v1 puts the radio in fixed length mode, v2 uses the variable length mode of
+// <i> the radio configuration. Every node must use the same one: keep v1 while
+// <i> legacy relays are deployed.
+// <i> Default: 2
+#ifndef PKT_WIRE_VERSION
+#define PKT_WIRE_VERSION  2
+#endif
+
+// <o PKT_DATA_PAYLOAD_MAX_LENGTH> Largest data frame payload [bytes] <10-250>
+// <i> Sizes the data slots of the packet pool and the receive buffers. v2 frames
+// <i> only send the bytes in use, beacons and retransmission requests are
+// <i> stored in smaller control slots.
+// <i> Default: 64
+#ifndef PKT_DATA_PAYLOAD_MAX_LENGTH
+#define PKT_DATA_PAYLOAD_MAX_LENGTH  64
+#endif
+
+// </h>
+
+// <h>Transmit queue
+
+// <o QUEUE_DEFAULT_LENGTH> Number of packets waiting for transmission, per class <1-64>
+// <i> Beacons, new data and retransmissions are queued separately, each class
+// <i> holds up to this many packets.
+// <i> Default: 16
+#ifndef QUEUE_DEFAULT_LENGTH
+#define QUEUE_DEFAULT_LENGTH  16
+#endif
+
+// <o TX_SCHEDULER_MODE> Service of the transmit classes
+//   <0=> Strict priority: beacons, then data, then retransmissions
+//   <1=> Weighted fair, by the weights below
+// <i> Default: 0
+#ifndef TX_SCHEDULER_MODE
+#define TX_SCHEDULER_MODE  0
+#endif
+
+// <o TX_WEIGHT_BEACON> Beacon class weight <1-255>
+// <i> Share of the transmissions given to a class while all of them have
+// <i> packets queued, weighted fair mode only.
+// <i> Default: 2
+#ifndef TX_WEIGHT_BEACON
+#define TX_WEIGHT_BEACON  2
+#endif
+
+// <o TX_WEIGHT_DATA> Data class weight <1-255>
+// <i> Default: 4
+#ifndef TX_WEIGHT_DATA
+#define TX_WEIGHT_DATA  4
+#endif
+
+// <o TX_WEIGHT_RETRANSMISSION> Retransmission class weight <1-255>
+// <i> Default: 2
+#ifndef TX_WEIGHT_RETRANSMISSION
+#define TX_WEIGHT_RETRANSMISSION  2
+#endif
+
+// </h>
+
+// <h>Transmitter
+
+// <o TX_WUP_DATA_GAP_US> Gap between the end of the WUP and the data frame [us] <0-1000000>
+// <i> Time the relays need to wake up with RFSense and start receiving.
+// <i> Default: 100000
+#ifndef TX_WUP_DATA_GAP_US
+#define TX_WUP_DATA_GAP_US  100000
+#endif
+
+// <q TX_SCHEDULED_DATA_ENABLE> Time the data frame with RAIL scheduled transmit
+// <i> The data frame is scheduled by the radio relative to the WUP TX end timestamp,
+// <i> otherwise the gap is timed by the sleeptimer with millisecond resolution.
+// <i> Default: 1
+#ifndef TX_SCHEDULED_DATA_ENABLE
+#define TX_SCHEDULED_DATA_ENABLE  1
+#endif
+
+// <o TX_BURST_MAX_LENGTH> Most data frames sent after one WUP <1-64>
+// <i> Packets already queued when a data frame ends go out right behind it,
+// <i> without a new WUP, while the relays are still awake. 1 sends a WUP
+// <i> for every packet.
+// <i> Default: 8
+#ifndef TX_BURST_MAX_LENGTH
+#define TX_BURST_MAX_LENGTH  8
+#endif
+
+// <o TX_BURST_WINDOW_US> Time after the WUP end a burst frame may start [us] <0-10000000>
+// <i> Must stay below the RX window the relays open on a WUP (1 s), minus
+// <i> the airtime of a frame.
+// <i> Default: 900000
+#ifndef TX_BURST_WINDOW_US
+#define TX_BURST_WINDOW_US  900000
+#endif
+
+// <q TX_AGGREGATION_ENABLE> Pack queued packets into one radio frame
+// <i> Packets queued together share the preamble, syncword and CRC of one
+// <i> frame, see pkt_agg.h. Needs v2 frames, relays must read aggregates.
+// <i> Default: 0
+#ifndef TX_AGGREGATION_ENABLE
+#define TX_AGGREGATION_ENABLE  0
+#endif
+
+// <o TX_AGGREGATION_FRAME_LENGTH> Longest aggregate frame [bytes] <16-256>
+// <i> Longer frames save more overhead but are lost more often.
+// <i> Default: 128
+#ifndef TX_AGGREGATION_FRAME_LENGTH
+#define TX_AGGREGATION_FRAME_LENGTH  128
+#endif
+
+// </h>
+
+// <h>Forward error correction
+
+// <q FEC_ENABLE> Send FEC parity packets in the data flood
+// <i> After every FEC_BLOCK_LENGTH data packets the sink sends FEC_PARITY_COUNT
+// <i> XOR parity packets (Wp), relays can rebuild one lost packet per parity
+// <i> group without a retransmission request.
+// <i> Default: 0
+#ifndef FEC_ENABLE
+#define FEC_ENABLE  0
+#endif
+
+// <o FEC_BLOCK_LENGTH> Data packets per FEC block <2-32>
+// <i> Relays must use the same value.
+// <i> Default: 4
+#ifndef FEC_BLOCK_LENGTH
+#define FEC_BLOCK_LENGTH  4
+#endif
+
+// <o FEC_PARITY_COUNT> Parity packets per FEC block <1-8>
+// <i> Parity packet r covers the block packets i with i % FEC_PARITY_COUNT == r,
+// <i> so burst losses up to this length can be rebuilt. Must divide FEC_BLOCK_LENGTH.
+// <i> Relays must use the same value.
+// <i> Default: 1
+#ifndef FEC_PARITY_COUNT
+#define FEC_PARITY_COUNT  1
+#endif
+
+// </h>
+
+// <h>Beaconing
+
+// <o BEACON_TRICKLE_IMIN_MS> Shortest beacon interval [ms] <100-60000>
+// <i> The interval goes back to this when an inconsistency is heard.
+// <i> Default: 1000
+#ifndef BEACON_TRICKLE_IMIN_MS
+#define BEACON_TRICKLE_IMIN_MS  1000
+#endif
+
+// <o BEACON_TRICKLE_DOUBLINGS> Times the beacon interval can double <0-16>
+// <i> The longest interval is BEACON_TRICKLE_IMIN_MS * 2^doublings.
+// <i> Default: 8
+#ifndef BEACON_TRICKLE_DOUBLINGS
+#define BEACON_TRICKLE_DOUBLINGS  8
+#endif
+
+// <o BEACON_TRICKLE_K> Consistent packets that suppress a beacon <0-255>
+// <i> 0 sends a beacon in every interval.
+// <i> Default: 2
+#ifndef BEACON_TRICKLE_K
+#define BEACON_TRICKLE_K  2
+#endif
+
+// </h>
+
+// <h>Radio power
+
+// <o RFSENSE_SENSE_TIME_US> RF energy needed to wake up from RFSense [us] <0-1000000>
+// <i> RFSense listens on the sub GHz band while the sink is idle.
+// <i> Default: 50
+#ifndef RFSENSE_SENSE_TIME_US
+#define RFSENSE_SENSE_TIME_US  50
+#endif
+
+// <o WAKE_WINDOW_MS> RX window after an RFSense wake up or a data frame sent [ms] <1-60000>
+// <i> Covers the data frame behind a WUP and the Wr of the relays, every
+// <i> packet received restarts it. The device stays in EM1 while it's open,
+// <i> it must be shorter than the packet generation period.
+// <i> Default: 300
+#ifndef WAKE_WINDOW_MS
+#define WAKE_WINDOW_MS  300
+#endif
+
+// </h>
+
+// <h>Retransmission buffer
+
+// <o RETRANSMISSION_BUFFER_DEFAULT_LENGTH> Number of data packets kept for retransmission <2-64>
+// <i> Must be a power of two, packets are stored at index (pktSeq & (length - 1)).
+// <i> At most 64, the packet history of relay.c.
+// <i> Every stored packet holds a packet pool slot.
+// <i> Default: 16
+#ifndef RETRANSMISSION_BUFFER_DEFAULT_LENGTH
+#define RETRANSMISSION_BUFFER_DEFAULT_LENGTH  16
+#endif
+
+// <o RETRANSMISSION_COALESCE_MS> Window merging retransmission requests [ms] <0-1000>
+// <i> Wr frames received within the window share one resend, each requested
+// <i> packet is sent once per window. 0 resends on every request.
+// <i> Default: 20
+#ifndef RETRANSMISSION_COALESCE_MS
+#define RETRANSMISSION_COALESCE_MS  20
+#endif
+
+// </h>
+
+// <h>Relay
+
+// <o RELAY_WR_DELAY_MS> Wait after a gap shows up before asking for it [ms] <0-60000>
+// <i> Leaves time for the skipped packets to arrive late, from another neighbour.
+// <i> Default: 50
+#ifndef RELAY_WR_DELAY_MS
+#define RELAY_WR_DELAY_MS  50
+#endif
+
+// <o RELAY_WR_RETRY_MS> Wait for the answer to a Wr before asking again [ms] <1-60000>
+// <i> Default: 500
+#ifndef RELAY_WR_RETRY_MS
+#define RELAY_WR_RETRY_MS  500
+#endif
+
+// <o RELAY_WR_ATTEMPTS> Wr sent without progress before giving up on a gap <0-255>
+// <i> Every packet received late starts the count again. 0 never asks.
+// <i> Default: 3
+#ifndef RELAY_WR_ATTEMPTS
+#define RELAY_WR_ATTEMPTS  3
+#endif
+
+// </h>
+
+// <h>Packet pool
+
+// <o PKT_POOL_DEFAULT_LENGTH> Number of data packet slots <1-254>
+// <i> Slots are shared by the transmit queue and the retransmission buffer,
+// <i> the default covers both when full plus the packets being built and sent.
+// <i> Default: RETRANSMISSION_BUFFER_DEFAULT_LENGTH + QUEUE_DEFAULT_LENGTH + 2
+#ifndef PKT_POOL_DEFAULT_LENGTH
+#define PKT_POOL_DEFAULT_LENGTH  (RETRANSMISSION_BUFFER_DEFAULT_LENGTH + QUEUE_DEFAULT_LENGTH + 2)
+#endif
+
+// <o PKT_POOL_CONTROL_LENGTH> Number of control packet slots <1-64>
+// <i> Slots with room for a control frame payload only, used by beacons.
+// <i> Default: 4
+#ifndef PKT_POOL_CONTROL_LENGTH
+#define PKT_POOL_CONTROL_LENGTH  4
+#endif
+
+// </h>
+
+// <h>Activity LEDs
+
+// <o LED_ACTIVITY_PULSE_MS> LED on time per packet [ms] <1-1000>
+// <i> Default: 10
+#ifndef LED_ACTIVITY_PULSE_MS
+#define LED_ACTIVITY_PULSE_MS  10
+#endif
+
+// <o LED_ACTIVITY_HOLDOFF_MS> Minimum LED off time between pulses [ms] <0-1000>
+// <i> Packets arriving sooner don't pulse the LED again.
+// <i> Default: 40
+#ifndef LED_ACTIVITY_HOLDOFF_MS
+#define LED_ACTIVITY_HOLDOFF_MS  40
+#endif
+
+// </h>
+
+// <h>Debug log
+
+// <o ASYNC_LOG_RECORD_SIZE> Size of a log record [bytes] <16-256>
+// <i> Longer messages are truncated.
+// <i> Default: 96
+#ifndef ASYNC_LOG_RECORD_SIZE
+#define ASYNC_LOG_RECORD_SIZE  96
+#endif
+
+// <o ASYNC_LOG_RING_LENGTH> Records buffered per producer <1-64>
+// <i> Must be a power of two, records that don't fit are dropped and counted.
+// <i> Default: 8
+#ifndef ASYNC_LOG_RING_LENGTH
+#define ASYNC_LOG_RING_LENGTH  8
+#endif
+
+// <o ASYNC_LOG_BATCH_SIZE> Largest UART DMA transfer [bytes] <16-1024>
+// <i> Default: 256
+#ifndef ASYNC_LOG_BATCH_SIZE
+#define ASYNC_LOG_BATCH_SIZE  256
+#endif
+
+// <q TRACE_BINARY_ENABLE> Send trace events as binary records
+// <i> Events are sent as raw arguments plus a timestamp, decode the VCOM
+// <i> stream with tools/trace_decode. Otherwise they are printed as text.
+// <i> Default: 0
+#ifndef TRACE_BINARY_ENABLE
+#define TRACE_BINARY_ENABLE  0
+#endif
+
+// <o TRACE_STATS_PERIOD_MS> Period of the TRACE_STATS counter report [ms] <0-3600000>
+// <i> The packet generator sends the counters of every module, at most a
+// <i> ring of records per generation period. 0 turns the report off.
+// <i> Default: 60000
+#ifndef TRACE_STATS_PERIOD_MS
+#define TRACE_STATS_PERIOD_MS  60000
+#endif
+
+// </h>
+
+#endif /* FLOOD_CONFIG_H */
+
+// <<< end of configuration section >>>
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file led_activity.c
+ * @brief Non-blocking LED activity pulses, safe to request from interrupts
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "em_core.h"
+
+#include "led_activity.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+///Sleeptimer callback, ends the pulse
+static void pulseEndCallback(sl_sleeptimer_timer_handle_t *handle, void *data);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void led_activity_init(led_activity_t *activity, const sl_led_t *led)
+{
+  activity->led = led;
+  activity->on = false;
+  activity->lastOffTick = sl_sleeptimer_get_tick_count();
+  activity->pulses = 0;
+  activity->suppressed = 0;
+  sl_led_turn_off(led);
+}
+
+void led_activity_pulse(led_activity_t *activity)
+{
+  uint32_t holdoffTicks = sl_sleeptimer_ms_to_tick(LED_ACTIVITY_HOLDOFF_MS);
+  bool start = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (!activity->on
+      && (uint32_t)(sl_sleeptimer_get_tick_count() - activity->lastOffTick) >= holdoffTicks) {
+    activity->on = true;
+    start = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  if (!start) {
+    activity->suppressed++;
+    return;
+  }
+  activity->pulses++;
+  sl_led_turn_on(activity->led);
+  sl_sleeptimer_start_timer_ms(&activity->timer, LED_ACTIVITY_PULSE_MS, pulseEndCallback, activity, 0, 0);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+void pulseEndCallback(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  led_activity_t *activity = (led_activity_t *)data;
+  (void)handle;
+
+  sl_led_turn_off(activity->led);
+  activity->lastOffTick = sl_sleeptimer_get_tick_count();
+  activity->on = false;
+}
@@ -0,0 +1,53 @@
+/***************************************************************************//**
+ * @file led_activity.h
+ * @brief Non-blocking LED activity pulses, safe to request from interrupts
+ ******************************************************************************/
+#ifndef LED_ACTIVITY_H
+#define LED_ACTIVITY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_led.h"
+#include "sl_sleeptimer.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// One LED driven by the activity service
+typedef struct
+{
+  const sl_led_t *led;
+  sl_sleeptimer_timer_handle_t timer;
+  volatile bool on;
+  uint32_t lastOffTick;
+  uint32_t pulses;
+  uint32_t suppressed; //Requests dropped by the rate limiting
+} led_activity_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Binds an activity indicator to a LED and turns the LED off.
+ *
+ * @param activity Indicator to initialize
+ * @param led LED instance
+ *****************************************************************************/
+void led_activity_init(led_activity_t *activity, const sl_led_t *led);
+
+/**************************************************************************//**
+ * Lights the LED for LED_ACTIVITY_PULSE_MS without waiting.
+ *
+ * @param activity Indicator to pulse
+ *
+ * Can be called from interrupt context. Requests made while the LED is lit
+ * or less than LED_ACTIVITY_HOLDOFF_MS after it went off are dropped, so
+ * the LED still blinks visibly at high packet rates.
+ *****************************************************************************/
+void led_activity_pulse(led_activity_t *activity);
+
+#endif  // LED_ACTIVITY_H
@@ -36,7 +36,6 @@
 #include "task.h"
 #include "queue.h"
 #include "sl_sleeptimer.h"
-#include "sl_udelay.h"
 
 #include "string.h"
 #include "strings.h"
@@ -48,35 +47,88 @@
 #include "sl_power_manager_config.h"
 #include "sl_led.h"
 #include "sl_simple_led_instances.h"
+
+#include "flood_config.h"
+#include "pkt.h"
+#include "led_activity.h"
+#include "async_log.h"
+#include "trace.h"
+#include "wake_window.h"
+#include "sleep_monitor.h"
+#include "radio_power.h"
+#include "trickle.h"
+#include "resend_set.h"
+#include "pkt_agg.h"
+#include "tx_scheduler.h"
+#include "sink.h"
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
 // -----------------------------------------------------------------------------
-#define QUEUE_DEFAULT_LENGTH 16
-#define RETRANSMISSION_BUFFER_DEFAULT_LENGTH 10
 #define STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
-#define SLEEPTIMER_DELAY_MS 1000
+
+///Task priorities, the log drain task runs below every other one
+#define LOG_TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
+#define PKT_GENERATOR_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#define BEACON_TASK_PRIORITY        (tskIDLE_PRIORITY + 3)
+#define TRANSMITTER_TASK_PRIORITY   (tskIDLE_PRIORITY + 4)
+#define RECEIVER_TASK_PRIORITY      (tskIDLE_PRIORITY + 5)
+
 #define PACKET_GENERATION_MS_DELAY 1000
+#define PACKET_GENERATION_PAYLOAD_LENGTH 10
 
-enum wupSequence{
-  Wb,
-  Wd,
-  Wr
-};
+#if WAKE_WINDOW_MS >= PACKET_GENERATION_MS_DELAY
+#error "WAKE_WINDOW_MS must be shorter than PACKET_GENERATION_MS_DELAY, or the sink never leaves EM1"
+#endif
+#if PACKET_GENERATION_PAYLOAD_LENGTH > PKT_DATA_PAYLOAD_MAX_LENGTH
+#error "PACKET_GENERATION_PAYLOAD_LENGTH exceeds PKT_DATA_PAYLOAD_MAX_LENGTH"
+#endif
+#if (PKT_WIRE_VERSION == PKT_VERSION_1) && (PACKET_GENERATION_PAYLOAD_LENGTH > PKT_V1_PAYLOAD_LENGTH)
+#error "PACKET_GENERATION_PAYLOAD_LENGTH exceeds the v1 frame payload"
+#endif
+
+///RAIL fifo sizes, a power of two between 64 and 4096 bytes
+#define RADIO_FIFO_LENGTH 1024
+
+#if RADIO_FIFO_LENGTH < PKT_FRAME_MAX_LENGTH
+#error "RADIO_FIFO_LENGTH can't hold the longest frame"
+#endif
+
+///Transmitter task notification bits
+#define TX_NOTIFY_PACKET_SENT   (1UL << 0)
+#define TX_NOTIFY_ABORTED       (1UL << 1)
+#define TX_NOTIFY_BLOCKED       (1UL << 2)
+#define TX_NOTIFY_CHANNEL_BUSY  (1UL << 3)
+#define TX_NOTIFY_TIMER         (1UL << 4)
+#define TX_NOTIFY_MISSED        (1UL << 5)
+#define TX_NOTIFY_FAILED (TX_NOTIFY_ABORTED | TX_NOTIFY_BLOCKED | TX_NOTIFY_CHANNEL_BUSY)
+#define TX_NOTIFY_ALL    (TX_NOTIFY_PACKET_SENT | TX_NOTIFY_FAILED | TX_NOTIFY_TIMER | TX_NOTIFY_MISSED)
+
+///RAIL events traced from the event handler, on the interrupt ring of the log: the failures and the
+///calibrations, not the packets sent and received of every flood
+#define RAIL_EVENTS_TRACED (RAIL_EVENT_CAL_NEEDED | RAIL_EVENT_TX_ABORTED | RAIL_EVENT_TX_UNDERFLOW \
+                            | RAIL_EVENT_TX_BLOCKED | RAIL_EVENT_TX_CHANNEL_BUSY \
+                            | RAIL_EVENT_TX_SCHEDULED_TX_MISSED | RAIL_EVENT_RX_FIFO_OVERFLOW)
+
+///Most packets the receiver copies out of the RAIL rx fifo before handling them
+#define RX_BATCH_LENGTH QUEUE_DEFAULT_LENGTH
+///The last frame of a batch can be an aggregate, its packets all fit behind the others
+#define RX_BATCH_CAPACITY (RX_BATCH_LENGTH + PKT_AGG_RECORDS_MAX - 1)
 
-#pragma pack(push,1)
 typedef struct
 {
-  uint16_t wupSeq;
-  uint16_t hopCount;
-  uint16_t pktSeq; //Packet Sequence #
-} pkt_header_t;
+  uint32_t received;
+  uint32_t discarded;  //Not a valid v1, v2 or aggregate frame
+  uint32_t batches;    //Receiver wake ups that found packets
+  uint32_t overflows;  //RAIL_EVENT_RX_FIFO_OVERFLOW
+  uint32_t heldPeak;   //Most packets held in the rx fifo at once
+} rx_stats_t;
 
 typedef struct
 {
-  pkt_header_t header;
-  uint8_t payload[10];
-} pkt_t;
-#pragma pack(pop)
+  uint32_t count;
+  uint32_t lastUs;
+  uint32_t maxUs;
+} isr_stats_t;
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
 // -----------------------------------------------------------------------------
@@ -85,42 +137,48 @@ static StaticTask_t transmitterTaskTCB;
 static StackType_t transmitterTaskStack[STACK_SIZE];
 static void transmitterTaskFunction ();
 static TaskHandle_t transmitterTaskHandle;
+static void transmitterHandleEvents(uint32_t events);
+static void transmitterTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data);
+static bool transmitterStartTx(void *context, uint16_t channel, const uint8_t *frame, uint16_t length, const uint32_t *atUs);
+static void transmitterStartTimer(void *context, uint32_t ms);
+static uint32_t transmitterNowUs(void *context);
+static void transmitterBegin(void *context);
+static void transmitterEnd(void *context, bool sent);
+static void transmitterPacketSent(void *context, const pkt_t *packet);
 
 ///Receiver Task
 static StaticTask_t receiverTaskTCB;
 static StackType_t receiverTaskStack[STACK_SIZE];
 static void receiverTaskFunction ();
 static TaskHandle_t receiverTaskHandle;
+static uint32_t receiverDrainFifo(void);
+static void receiverRequestHeard(void *context, const pkt_t *packet);
+static void receiverStartCoalesceTimer(void *context, uint32_t ms);
+static void receiverCoalesceTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data);
 
 ///Beacon Task
 static StaticTask_t beaconTaskTCB;
 static StackType_t beaconTaskStack[STACK_SIZE];
 static void beaconTaskFunction ();
 static TaskHandle_t beaconTaskHandle;
+static bool beaconWaitUntil(TickType_t deadline);
+static void beaconHear(void *context, bool consistent);
 
 ///Packet generator Task
 static StaticTask_t pktGeneratorTaskTCB;
 static StackType_t pktGeneratorTaskStack[STACK_SIZE];
 static void pktGeneratorTaskFunction ();
 static TaskHandle_t pktGeneratorTaskHandle;
+#if TRACE_STATS_PERIOD_MS
+static void pktGeneratorTraceStats(void);
+static uint32_t statsRead(trace_stats_block_t block, uint32_t values[TRACE_STATS_VALUES_MAX]);
+static uint32_t statsCopy(uint32_t *values, const void *stats, size_t size);
+#endif
 
-///Delayer Task
-static StaticTask_t delayerTaskTCB;
-static StackType_t delayerTaskStack[configMINIMAL_STACK_SIZE];
-static void delayerTaskFunction ();
-static TaskHandle_t delayerTaskHandle;
 
 ///RFSense callback
 static void rfSenseCb(void);
 
-///Callback Function
-static void timerCallback(sl_sleeptimer_timer_handle_t *handle, void *data);
-
-
-/// Queue handle and space
-static QueueHandle_t transmitterQueueHandle;
-static StaticQueue_t transmitterQueueDataStruct;
-static uint8_t transmitterQueue[sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH];
 // -----------------------------------------------------------------------------
 //                                Global Variables
 // -----------------------------------------------------------------------------
@@ -132,15 +190,26 @@ static uint8_t transmitterQueue[sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH];
 static RAIL_Handle_t rail_handle;
 
 /// RAIL tx and rx queue
-static uint8_t railTxFifo[sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH];
-static uint8_t railRxFifo[sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH];
-static uint16_t rxFifoSize = sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH;
+static uint8_t railTxFifo[RADIO_FIFO_LENGTH];
+static uint8_t railRxFifo[RADIO_FIFO_LENGTH];
+static uint16_t rxFifoSize = RADIO_FIFO_LENGTH;
+
+///Received packets, drained from the rx fifo in one go and decoded
+static sink_packet_t rxBatch[RX_BATCH_CAPACITY];
+static uint8_t rxFrame[PKT_AGG_FRAME_MAX_LENGTH];
+static rx_stats_t rxStats;
 
-///Dummy packet structs
-static pkt_t generatedPacket, txPacket, rxPacket;
+///Retransmission requests received within RETRANSMISSION_COALESCE_MS share one resend
+static sl_sleeptimer_timer_handle_t coalesceSleeptimerHandle;
+static volatile bool coalesceDue;
+static volatile uint32_t rxHeld;
+
+///TX (led0) and RX (led1) activity indicators
+static led_activity_t txActivity, rxActivity;
+
+///Execution time of the RAIL event handler
+static isr_stats_t railEventStats;
 
-///VCOM Serial print buffer
-static uint8_t transmitterBuffer[100];
 
 ///Rx Packet handle, details and info
 static RAIL_RxPacketHandle_t packet_handle;
@@ -149,18 +218,36 @@ static RAIL_RxPacketInfo_t packet_info;
 /// Pointer used to force context switch from ISR
 static BaseType_t xHigherPriorityTaskWoken;
 
-///Retransmission buffer and index
-static pkt_t retransmissionBuffer[QUEUE_DEFAULT_LENGTH];
-static uint32_t retransmissionBufferIndex = 0;
-static volatile bool found;
+///Beacon Trickle timer, shared by the beacon and receiver tasks under taskENTER_CRITICAL
+static trickle_t beaconTrickle;
 
 ///Sleeptimer handles
-static sl_sleeptimer_timer_handle_t delayerSleeptimerHandle;
+static sl_sleeptimer_timer_handle_t transmitterSleeptimerHandle;
+
+///Platform side of the sink protocol, see sink.h
+static const sink_ops_t sinkOps = {
+  .start_tx = transmitterStartTx,
+  .start_timer = transmitterStartTimer,
+  .now_us = transmitterNowUs,
+  .tx_begin = transmitterBegin,
+  .tx_end = transmitterEnd,
+  .packet_sent = transmitterPacketSent,
+  .hear = beaconHear,
+  .request_heard = receiverRequestHeard,
+  .start_coalesce_timer = receiverStartCoalesceTimer
+};
 
-static volatile bool wait, isTimerRunning;
+///Frame last handed to RAIL, the event handler times its end or its start
+static volatile uint16_t txChannel;
+static volatile uint16_t txFrameLength;
+static volatile RAIL_Time_t txSentTime;
 
-static uint16_t hopCount = 0;
-static uint32_t pktSequenceNumber = 1;
+#if TRACE_STATS_PERIOD_MS
+///TRACE_STATS report in progress: block and counter sent next, TRACE_STATS_BLOCK_COUNT between reports
+static uint32_t statsBlock = TRACE_STATS_BLOCK_COUNT;
+static uint32_t statsIndex;
+static TickType_t statsReportTick;
+#endif
 // -----------------------------------------------------------------------------
 //                          Public Function Definitions
 // -----------------------------------------------------------------------------
@@ -180,50 +267,66 @@ int main(void)
 
 
   //Transmitter Task
-    transmitterTaskHandle = xTaskCreateStatic (transmitterTaskFunction, "transmitterTask", STACK_SIZE, NULL, 3, transmitterTaskStack, &transmitterTaskTCB);
+    transmitterTaskHandle = xTaskCreateStatic (transmitterTaskFunction, "transmitterTask", STACK_SIZE, NULL, TRANSMITTER_TASK_PRIORITY, transmitterTaskStack, &transmitterTaskTCB);
     if (transmitterTaskHandle == NULL)
       {
         return 0;
       }
 
     //Receiver Task
-    receiverTaskHandle = xTaskCreateStatic (receiverTaskFunction, "receiverTask", STACK_SIZE, NULL, 4, receiverTaskStack, &receiverTaskTCB);
+    receiverTaskHandle = xTaskCreateStatic (receiverTaskFunction, "receiverTask", STACK_SIZE, NULL, RECEIVER_TASK_PRIORITY, receiverTaskStack, &receiverTaskTCB);
     if (receiverTaskHandle == NULL)
      {
        return(0);
      }
 
     //Beacon Task
-    beaconTaskHandle = xTaskCreateStatic (beaconTaskFunction, "beaconTask", STACK_SIZE, NULL, 2, beaconTaskStack, &beaconTaskTCB);
+    beaconTaskHandle = xTaskCreateStatic (beaconTaskFunction, "beaconTask", STACK_SIZE, NULL, BEACON_TASK_PRIORITY, beaconTaskStack, &beaconTaskTCB);
     if (beaconTaskHandle == NULL)
      {
        return 0;
      }
 
     //Packet Generator Task
-    pktGeneratorTaskHandle = xTaskCreateStatic (pktGeneratorTaskFunction, "pktGeneratorTask", STACK_SIZE, NULL, 1, pktGeneratorTaskStack, &pktGeneratorTaskTCB);
+    pktGeneratorTaskHandle = xTaskCreateStatic (pktGeneratorTaskFunction, "pktGeneratorTask", STACK_SIZE, NULL, PKT_GENERATOR_TASK_PRIORITY, pktGeneratorTaskStack, &pktGeneratorTaskTCB);
     if (pktGeneratorTaskHandle == NULL)
      {
        return 0;
      }
 
-    //Delayer Task
-    //This task prevents going into sleep mode again after waking up. "Sleep mode" is just the Idle Task running,
+    //Wake window
+    //It prevents going into sleep mode again after waking up. "Sleep mode" is just the Idle Task running,
     //when we wake up with RFSense we would immediately fall back into it after the callback.
-    delayerTaskHandle = xTaskCreateStatic (delayerTaskFunction, "delayerTask", configMINIMAL_STACK_SIZE, NULL, 1, delayerTaskStack, &delayerTaskTCB);
-    if (delayerTaskHandle == NULL)
-     {
-       return(0);
-     }
+    wake_window_init(WAKE_WINDOW_MS);
+
+    //Radio power state, RFSense is armed by the idle hook and wakes us up through rfSenseCb
+    radio_power_init(rail_handle, rfSenseCb);
+
+    //Tickless idle: time spent in EM2 and kernel time accuracy
+    sleep_monitor_init();
+
+    //The radio config reads the frame length from the first v2 byte, v1 frames don't carry one
+#if PKT_WIRE_VERSION == PKT_VERSION_1
+    RAIL_SetFixedLength (rail_handle, PKT_V1_FRAME_LENGTH);
+#endif
 
     //setting tx fifo
-    RAIL_SetTxFifo (rail_handle, railTxFifo, 0, sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH);
+    RAIL_SetTxFifo (rail_handle, railTxFifo, 0, RADIO_FIFO_LENGTH);
 
     //enabling vcom
     GPIO_PinOutSet (SL_BOARD_ENABLE_VCOM_PORT, SL_BOARD_ENABLE_VCOM_PIN);
 
-    //Init Queues
-    transmitterQueueHandle = xQueueCreateStatic(QUEUE_DEFAULT_LENGTH, sizeof(pkt_t), transmitterQueue, &transmitterQueueDataStruct);
+    //Debug output, written to the vcom by the lowest priority task
+    if (!async_log_init(sl_uartdrv_usart_vcom_handle, LOG_TASK_PRIORITY))
+     {
+       return 0;
+     }
+
+    led_activity_init(&txActivity, &sl_led_led0);
+    led_activity_init(&rxActivity, &sl_led_led1);
+
+    //Init the sink protocol, its packet storage and Queues
+    sink_init(&sinkOps, NULL);
 
 
 #if defined(SL_CATALOG_KERNEL_PRESENT)
@@ -249,28 +352,73 @@ int main(void)
 // -----------------------------------------------------------------------------
 //                          Static Function Definitions
 // -----------------------------------------------------------------------------
+///Beacon Task
+///Beacons follow a Trickle timer: the interval doubles while the relays agree with us, and goes back to
+///the minimum when the receiver hears an inconsistency, which also cuts the current wait short.
 void beaconTaskFunction(){
-  int i = 0;
-  while(i<3){
-      generatedPacket.header.hopCount = 0;
-      generatedPacket.header.pktSeq = 0;
-      generatedPacket.header.wupSeq = Wb;
+  TickType_t intervalStart;
+  uint32_t intervals = 0;
+  uint32_t seed = 0;
+  bool fire;
+
+  RAIL_GetRadioEntropy(rail_handle, (uint8_t*) &seed, sizeof(seed));
+  taskENTER_CRITICAL();
+  trickle_init(&beaconTrickle, BEACON_TRICKLE_IMIN_MS, BEACON_TRICKLE_DOUBLINGS, BEACON_TRICKLE_K, seed);
+  taskEXIT_CRITICAL();
+  intervalStart = xTaskGetTickCount();
+  while(true){
+      if(beaconWaitUntil(intervalStart + pdMS_TO_TICKS(trickle_get_fire_ms(&beaconTrickle)))){
+          //Reset by the receiver, a new interval starts now
+          intervalStart = xTaskGetTickCount();
+          continue;
+      }
+      taskENTER_CRITICAL();
+      fire = trickle_fire(&beaconTrickle);
+      taskEXIT_CRITICAL();
+      if(fire){
+          sink_send_beacon();
+      }
+
+      if(beaconWaitUntil(intervalStart + pdMS_TO_TICKS(trickle_get_interval_ms(&beaconTrickle)))){
+          intervalStart = xTaskGetTickCount();
+          continue;
+      }
+      intervalStart += pdMS_TO_TICKS(trickle_get_interval_ms(&beaconTrickle));
+      taskENTER_CRITICAL();
+      trickle_next_interval(&beaconTrickle);
+      taskEXIT_CRITICAL();
+
+      //Start the packet generator task once the startup beacons are out
+      if(++intervals == SINK_STARTUP_BEACON_INTERVALS){
+          xTaskNotifyGive(pktGeneratorTaskHandle);
+      }
+  }
+}
 
-      xQueueSend(transmitterQueueHandle, (void *)&generatedPacket, 0);
+///Sleeps until the deadline, returns true if the receiver reset the Trickle timer in the meantime
+bool beaconWaitUntil(TickType_t deadline){
+  TickType_t remaining = deadline - xTaskGetTickCount();
 
-      i++;
-      vTaskDelay(pdMS_TO_TICKS(1000));
+  if((int32_t) remaining < 0){
+      remaining = 0;
   }
-  //Start the packet generator task
-  xTaskNotifyGive(pktGeneratorTaskHandle);
-  while(true){
-    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+  return ulTaskNotifyTake(pdTRUE, remaining) > 0;
+}
 
-    generatedPacket.header.hopCount = 0;
-    generatedPacket.header.pktSeq = 0;
-    generatedPacket.header.wupSeq = Wb;
+///Called by the receiver task, wakes the beacon task up if the interval was reset
+void beaconHear(void *context, bool consistent){
+  bool reset = false;
+  (void)context;
 
-    xQueueSend(transmitterQueueHandle, (void *)&generatedPacket, 0);
+  taskENTER_CRITICAL();
+  if(consistent){
+      trickle_hear_consistent(&beaconTrickle);
+  }else{
+      reset = trickle_hear_inconsistent(&beaconTrickle);
+  }
+  taskEXIT_CRITICAL();
+  if(reset){
+      xTaskNotifyGive(beaconTaskHandle);
   }
 }
 
@@ -282,144 +430,312 @@ void pktGeneratorTaskFunction (){
     {
       vTaskDelay(pdMS_TO_TICKS(PACKET_GENERATION_MS_DELAY));
       //Start the radio on RX if we've just woken up from idle
-      RAIL_StartRx (rail_handle, 0 , NULL);
+      radio_power_start_rx (0);
+#if TRACE_STATS_PERIOD_MS
+      pktGeneratorTraceStats();
+#endif
 
+      //Skipped if every slot is held by the queue or the retransmission buffer
+      sink_generate(PACKET_GENERATION_PAYLOAD_LENGTH, NULL);
+    }
+}
 
-      generatedPacket.header.pktSeq = pktSequenceNumber;
-      generatedPacket.header.wupSeq = Wd;
-      generatedPacket.header.hopCount = hopCount + 1;
+#if TRACE_STATS_PERIOD_MS
+///Sends the counters of every module as TRACE_STATS, every TRACE_STATS_PERIOD_MS. A report takes as many
+///generation periods as it needs to send at most one log ring of records in each, the drain task empties it
+///in between.
+void pktGeneratorTraceStats(){
+  uint32_t values[TRACE_STATS_VALUES_MAX];
+  uint32_t count;
+  uint32_t records = 0;
+  TickType_t now = xTaskGetTickCount();
+
+  if(statsBlock == TRACE_STATS_BLOCK_COUNT){
+      if((TickType_t)(now - statsReportTick) < pdMS_TO_TICKS(TRACE_STATS_PERIOD_MS)){
+          return;
+      }
+      statsReportTick = now;
+      statsBlock = 0;
+      statsIndex = 0;
+  }
+  while(statsBlock < TRACE_STATS_BLOCK_COUNT && records < ASYNC_LOG_RING_LENGTH){
+      count = statsRead((trace_stats_block_t)statsBlock, values);
+      if(statsIndex >= count){
+          statsBlock++;
+          statsIndex = 0;
+          continue;
+      }
+      trace_event (ASYNC_LOG_GENERATOR, TRACE_STATS, statsBlock, statsIndex, values[statsIndex],
+                   (statsIndex + 1 < count) ? values[statsIndex + 1] : 0);
+      statsIndex += 2;
+      records++;
+  }
+}
 
-      if(retransmissionBufferIndex < QUEUE_DEFAULT_LENGTH){
-          memcpy(&retransmissionBuffer[retransmissionBufferIndex], &generatedPacket, sizeof(pkt_t));
-          retransmissionBufferIndex++;
-      }else{
-          for(int i = 0; i<QUEUE_DEFAULT_LENGTH - 1; i++){
-              memcpy(&retransmissionBuffer[i], &retransmissionBuffer[i+1], sizeof(pkt_t));
-          }
-          memcpy(&retransmissionBuffer[QUEUE_DEFAULT_LENGTH - 1], &generatedPacket, sizeof(pkt_t));
+///Gives the counters of a block, in the order of trace_events.h
+uint32_t statsRead(trace_stats_block_t block, uint32_t values[TRACE_STATS_VALUES_MAX]){
+  const sink_stats_t *sink = sink_get_stats();
+  uint32_t count = 0;
+
+  switch(block){
+    case TRACE_STATS_TX:
+      return statsCopy(values, &sink->tx, sizeof(sink->tx));
+    case TRACE_STATS_RX:
+      return statsCopy(values, &rxStats, sizeof(rxStats));
+    case TRACE_STATS_WR:
+      return statsCopy(values, &sink->wr, sizeof(sink->wr));
+    case TRACE_STATS_RAIL_EVENT:
+      return statsCopy(values, &railEventStats, sizeof(railEventStats));
+    case TRACE_STATS_AIRTIME:
+      return statsCopy(values, sink->airtime, sizeof(sink->airtime));
+    case TRACE_STATS_GOODPUT:
+      return statsCopy(values, &sink->goodput, sizeof(sink->goodput));
+    case TRACE_STATS_TX_SCHEDULER:
+      for(tx_class_t c = TX_CLASS_BEACON; c < TX_CLASS_COUNT; c++){
+          count += statsCopy(&values[count], tx_scheduler_get_stats(c), sizeof(tx_scheduler_stats_t));
+      }
+      return count;
+    case TRACE_STATS_RESEND_SET:
+      return statsCopy(values, resend_set_get_stats(), sizeof(resend_set_stats_t));
+    case TRACE_STATS_WAKE_WINDOW:
+      return statsCopy(values, wake_window_get_stats(), sizeof(wake_window_stats_t));
+    case TRACE_STATS_RADIO_POWER:
+      return statsCopy(values, radio_power_get_stats(), sizeof(radio_power_stats_t));
+    case TRACE_STATS_SLEEP:
+      {
+        const sleep_monitor_stats_t *sleep = sleep_monitor_get_stats();
+        values[count++] = sleep->sleeps;
+        values[count++] = sleep->lastSleepMs;
+        values[count++] = sleep->longestSleepMs;
+        values[count++] = (uint32_t)sleep->totalSleepMs;
+        values[count++] = (uint32_t)sleep->uptimeMs;
+        values[count++] = (uint32_t)sleep->driftMs;
       }
+      return count;
+    case TRACE_STATS_ASYNC_LOG:
+      return statsCopy(values, async_log_get_stats(), sizeof(async_log_stats_t));
+    case TRACE_STATS_FEC:
+      values[count++] = sink->parityDropped;
+      return count;
+    default:
+      return 0;
+  }
+}
+
+///Counter structs are all uint32_t, sent in their field order
+uint32_t statsCopy(uint32_t *values, const void *stats, size_t size){
+  memcpy(values, stats, size);
+  return (uint32_t)(size / sizeof(uint32_t));
+}
+#endif
 
-      pktSequenceNumber++;
+///Transmitter Task
+///Every packet goes out twice: a WUP on the sub GHz channel to wake the relays up with RFSense
+///and, TX_WUP_DATA_GAP_US after the WUP end, the actual flood data packet on the 2.4 GHz channel.
+///Packets queued by then follow the data packet back to back, up to TX_BURST_MAX_LENGTH of them,
+///while the relays are still in the RX window the WUP opened.
+///The task only sleeps on the tx_scheduler queues or on its notifications, RAIL events and the sleeptimer advance it.
+void transmitterTaskFunction(){
+  uint32_t events;
+  while(1){
+      if(sink_tx_is_idle()){
+          sink_tx_start(portMAX_DELAY);
+          continue;
+      }
+      xTaskNotifyWait(0, TX_NOTIFY_ALL, &events, portMAX_DELAY);
+      transmitterHandleEvents(events);
+  }
+}
 
-      xQueueSend(transmitterQueueHandle, (void *)&generatedPacket, 0);
+void transmitterHandleEvents(uint32_t events){
+  uint32_t failures = 0;
+
+  if(events & TX_NOTIFY_PACKET_SENT){
+      sink_tx_done(txSentTime);
+  }else if(events & TX_NOTIFY_MISSED){
+      sink_tx_missed();
+  }else if(events & TX_NOTIFY_FAILED){
+      if(events & TX_NOTIFY_ABORTED)
+        failures |= SINK_TX_ABORTED;
+      if(events & TX_NOTIFY_BLOCKED)
+        failures |= SINK_TX_BLOCKED;
+      if(events & TX_NOTIFY_CHANNEL_BUSY)
+        failures |= SINK_TX_CHANNEL_BUSY;
+      sink_tx_failed(failures);
+  }else if(events & TX_NOTIFY_TIMER){
+      sink_tx_timer();
+  }
+}
 
-      xTaskNotifyGive(delayerTaskHandle);
-    }
+///Starts the frame on RAIL, the first data frame after a WUP at the absolute RAIL time *atUs
+bool transmitterStartTx(void *context, uint16_t channel, const uint8_t *frame, uint16_t length, const uint32_t *atUs){
+  (void)context;
+  txChannel = channel;
+  txFrameLength = length;
+  //Turns RFSense off if the idle hook armed it while we were waiting
+  radio_power_claim_tx();
+  //Only one frame is in flight, start from an empty fifo every time
+  RAIL_WriteTxFifo (rail_handle, frame, length, true);
+  if(atUs != NULL){
+      RAIL_ScheduleTxConfig_t scheduleConfig = {
+        .when = *atUs,
+        .mode = RAIL_TIME_ABSOLUTE,
+        .txDuringRx = RAIL_SCHEDULED_TX_DURING_RX_POSTPONE_TX
+      };
+      return RAIL_StartScheduledTx (rail_handle, channel, RAIL_TX_OPTIONS_DEFAULT, &scheduleConfig, NULL) == RAIL_STATUS_NO_ERROR;
+  }
+  return RAIL_StartTx (rail_handle, channel, RAIL_TX_OPTIONS_DEFAULT, NULL) == RAIL_STATUS_NO_ERROR;
 }
 
+void transmitterStartTimer(void *context, uint32_t ms){
+  (void)context;
+  sl_sleeptimer_restart_timer_ms(&transmitterSleeptimerHandle, ms, transmitterTimerCallback, NULL, 0, 0);
+}
 
-void transmitterTaskFunction(){
-  while(1){
-      xQueueReceive(transmitterQueueHandle, &(txPacket), portMAX_DELAY);
+uint32_t transmitterNowUs(void *context){
+  (void)context;
+  return RAIL_GetTime();
+}
 
-      //Check that we don't overflow the tx buffer
-      while(RAIL_GetTxFifoSpaceAvailable(rail_handle) < sizeof(pkt_t) * 2){
-          sl_sleeptimer_delay_millisecond (100);
-      }
-      //Simulate sending a WUP packet to wake up nodes on the sub GHZ frequency.
-      //In our case we send the actual packet
-      RAIL_WriteTxFifo (rail_handle, (uint8_t*) &txPacket, sizeof(pkt_t), false);
-      while (RAIL_StartTx (rail_handle, 1, 0, NULL) != RAIL_STATUS_NO_ERROR);
-      //Wait for 100ms to be sure that the node have woken up
-      //We are still in the rx wake up window (1sec)
-      sl_sleeptimer_delay_millisecond (100);
-      //Send the actual flood data packet
-      RAIL_WriteTxFifo (rail_handle, (uint8_t*) &txPacket, sizeof(pkt_t), false);
-      while (RAIL_STATUS_NO_ERROR != RAIL_StartTx (rail_handle, 0, 0, NULL));
-
-      //SERIAL OUTPUT FOR DEBUGGING PURPOSES
-      if(txPacket.header.wupSeq == Wb){
-          snprintf ((char*)&transmitterBuffer, 100, "\r\nBeacon update sent!\r\n");
-      }
-      if(txPacket.header.wupSeq == Wd){
-          snprintf ((char*)&transmitterBuffer, 100, "Packet sent:\r\nSequence number: %u\r\nWUP Sequence: %u\r\nHop Count: %u\r\n", txPacket.header.pktSeq, txPacket.header.wupSeq, txPacket.header.hopCount);
-      }
+void transmitterBegin(void *context){
+  (void)context;
+  //The radio and its scheduler timer don't run in EM2, stay in EM1 until the packet is done
+  sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+}
 
+void transmitterEnd(void *context, bool sent){
+  (void)context;
+  sl_sleeptimer_stop_timer(&transmitterSleeptimerHandle);
+  //Stay in RX for the retransmission requests the frame may bring
+  if(sent){
+      wake_window_open();
+  }
+  sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+  //Discard completions of this packet that are still pending
+  xTaskNotifyWait(0, TX_NOTIFY_ALL, NULL, 0);
+}
 
-      while (ECODE_OK != UARTDRV_TransmitB (sl_uartdrv_usart_vcom_handle, &transmitterBuffer[0], strlen ((char*)transmitterBuffer)));
+///Only packets whose data frame went out are traced, dropped ones are counted in the sink stats
+void transmitterPacketSent(void *context, const pkt_t *packet){
+  (void)context;
+  if(packet->header.wupSeq == Wb){
+      trace_event (ASYNC_LOG_TRANSMITTER, TRACE_BEACON_SENT);
+  }
+  if(packet->header.wupSeq == Wd){
+      trace_event (ASYNC_LOG_TRANSMITTER, TRACE_PACKET_SENT, packet->header.pktSeq, packet->header.wupSeq, packet->header.hopCount);
   }
 }
 
+void transmitterTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data){
+  BaseType_t xTimerTaskWoken = pdFALSE;
+  (void)handle;
+  (void)data;
+
+  xTaskNotifyFromISR(transmitterTaskHandle, TX_NOTIFY_TIMER, eSetBits, &xTimerTaskWoken);
+  portYIELD_FROM_ISR(xTimerTaskWoken);
+}
+
 ///Receiver Task
+///One notification can stand for many held packets: every wake up drains all of the completed
+///ones out of the rx fifo first, so RAIL gets the space back, and only then handles them.
 void receiverTaskFunction (){
+  uint32_t count;
   while (true)
     {
-      ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
-      packet_handle = RAIL_GetRxPacketInfo (rail_handle, RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE, &packet_info);
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-      if (packet_handle != RAIL_RX_PACKET_HANDLE_INVALID){
-          sl_sleeptimer_is_timer_running(&delayerSleeptimerHandle, &isTimerRunning);
-          if(isTimerRunning){
-              sl_sleeptimer_restart_timer_ms(&delayerSleeptimerHandle, SLEEPTIMER_DELAY_MS, timerCallback, (void*)&wait, 0, 0);
-          }
+      while ((count = receiverDrainFifo()) > 0){
+          rxStats.batches++;
+          wake_window_extend();
 
-          RAIL_CopyRxPacket (&rxPacket, &packet_info);
-          RAIL_ReleaseRxPacket (rail_handle, packet_handle);
-
-          if(rxPacket.header.wupSeq == Wr){
-              if(rxPacket.header.hopCount == hopCount){
-                  snprintf ((char*)&transmitterBuffer, 100, "\r\nRetransmit Packet received:\r\nPacket Sequence: %u\r\n", rxPacket.header.pktSeq);
-                  while (ECODE_OK != UARTDRV_TransmitB (sl_uartdrv_usart_vcom_handle, &transmitterBuffer[0], strlen ((char*)transmitterBuffer)));
-
-                  for(unsigned int i = 0; i < retransmissionBufferIndex; i++){
-                      if(retransmissionBuffer[i].header.pktSeq == rxPacket.header.pktSeq){
-                          xQueueSend(transmitterQueueHandle, (void *)&retransmissionBuffer[i], 0);
-                          found = true;
-                      }
-                      if(found && retransmissionBuffer[i].header.pktSeq > rxPacket.header.pktSeq)
-                        xQueueSend(transmitterQueueHandle, (void *)&retransmissionBuffer[i], 0);
-                  }
-                  found = false;
-              }
+          for(uint32_t i = 0; i < count; i++){
+              sink_handle_packet((pkt_t *)&rxBatch[i]);
           }
       }
+
+      //Coalescing window over, queue every requested packet once
+      if (coalesceDue){
+          coalesceDue = false;
+          sink_flush_requests();
+      }
     }
 }
 
+uint32_t receiverDrainFifo(){
+  uint32_t count = 0;
+  uint32_t frameStart;
 
-///Delayer task, avoids we immediately go to sleep after waking up with RFSense
-void delayerTaskFunction ()
-{
-  while (1)
-    {
-      ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
-      sl_sleeptimer_is_timer_running(&delayerSleeptimerHandle, &isTimerRunning);
-      if(!isTimerRunning){
-          wait = true;
-          sl_sleeptimer_start_timer_ms(&delayerSleeptimerHandle, SLEEPTIMER_DELAY_MS, timerCallback, (void*)&wait, 0, 0);
-          while(wait);
+  while (count < RX_BATCH_LENGTH){
+      packet_handle = RAIL_GetRxPacketInfo (rail_handle, RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE, &packet_info);
+      if (packet_handle == RAIL_RX_PACKET_HANDLE_INVALID){
+          break;
       }
-      //TODO: remove after finishing the debugging phase
-      if(true)
-        __asm__("nop");
-    }
+
+      frameStart = count;
+      if (packet_info.packetBytes <= sizeof(rxFrame)){
+          RAIL_CopyRxPacket (rxFrame, &packet_info);
+          count += sink_decode_frame (rxFrame, packet_info.packetBytes, &rxBatch[count], RX_BATCH_CAPACITY - count);
+      }
+      if (count == frameStart){
+          rxStats.discarded++;
+      }
+      RAIL_ReleaseRxPacket (rail_handle, packet_handle);
+
+      taskENTER_CRITICAL();
+      if (rxHeld > 0){
+          rxHeld--;
+      }
+      taskEXIT_CRITICAL();
+  }
+  rxStats.received += count;
+
+  return count;
+}
+
+void receiverRequestHeard(void *context, const pkt_t *packet){
+  (void)context;
+  trace_event (ASYNC_LOG_RECEIVER, TRACE_RETRANSMIT_REQUEST, packet->header.pktSeq);
 }
 
-void timerCallback(sl_sleeptimer_timer_handle_t *handle, void *data){
-  volatile bool *wait_flag = (bool*)data;
+///First request of a window, the other relays' ones merge into it until the timer fires
+void receiverStartCoalesceTimer(void *context, uint32_t ms){
+  (void)context;
+  sl_sleeptimer_start_timer_ms(&coalesceSleeptimerHandle, ms, receiverCoalesceTimerCallback, NULL, 0, 0);
+}
+
+void receiverCoalesceTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data){
+  BaseType_t xCoalesceTaskWoken = pdFALSE;
+  (void)handle;
+  (void)data;
 
-  *wait_flag = false;
+  coalesceDue = true;
+  vTaskNotifyGiveFromISR(receiverTaskHandle, &xCoalesceTaskWoken);
+  portYIELD_FROM_ISR(xCoalesceTaskWoken);
 }
 
 
 ///Idle Task Hook, we turn off the radio and start the RFSense peripheral on the Sub GHZ freq before entering "sleep mode"
+///Only the first pass after the radio was used reconfigures it, the next ones find RFSense armed
 void vApplicationIdleHook ()
 {
+  //Don't pull the radio from under a transmission that is waiting for its completion event,
+  //nor out of RX while the wake window is open
+  if (!sink_tx_is_idle () || wake_window_is_open ())
+    {
+      return;
+    }
   // Starting RFSENSE before going to sleep
-  RAIL_Idle (rail_handle, RAIL_IDLE, true);
-  RAIL_StartRfSense (rail_handle, RAIL_RFSENSE_SUBGHZ_LOW_SENSITIVITY, 50, rfSenseCb);
+  radio_power_sleep ();
 }
 
 ///RFSense Callback function
 void rfSenseCb ()
 {
-  //We've woken up with RFSense, now we schedule a receiving window of 1s
-  //and notify the delayer task so we don't immediately go to sleep
-  if (RAIL_StartRx (rail_handle, 0 , NULL) == RAIL_STATUS_NO_ERROR)
+  //We've woken up with RFSense, now we open a receiving window of WAKE_WINDOW_MS
+  //so we don't immediately go to sleep
+  if (radio_power_start_rx (0) == RAIL_STATUS_NO_ERROR)
     {
-      xHigherPriorityTaskWoken = pdFALSE;
-      vTaskNotifyGiveFromISR(delayerTaskHandle, &xHigherPriorityTaskWoken);
-      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+      wake_window_open ();
     }
 }
 
@@ -427,27 +743,87 @@ void rfSenseCb ()
 ///RAIL event handler
 void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events)
 {
+  RAIL_Time_t entryTime = RAIL_GetTime ();
+  uint32_t elapsedUs;
+
+  if (events & RAIL_EVENTS_TRACED)
+    {
+      trace_event (ASYNC_LOG_ISR, TRACE_RAIL_EVENT, (uint32_t)((events & RAIL_EVENTS_TRACED) >> 32),
+                   (uint32_t)(events & RAIL_EVENTS_TRACED));
+    }
   if (events & RAIL_EVENT_CAL_NEEDED)
     {
       RAIL_Calibrate (rail_handle, NULL, RAIL_CAL_ALL_PENDING);
     }
-  if (events & RAIL_EVENT_TX_PACKET_SENT)
+  if (events & RAIL_EVENTS_TX_COMPLETION)
+    {
+      uint32_t txNotification = 0;
+      if (events & RAIL_EVENT_TX_PACKET_SENT)
+        {
+          //Packet details are only available from within this event
+          //totalPacketBytes is read by RAIL, not written: the frame plus its 2 byte CRC
+          RAIL_TxPacketDetails_t txDetails = {
+            .isAck = false,
+            .timeSent.timePosition = (txChannel == SINK_CHANNEL_WUP) ? RAIL_PACKET_TIME_AT_PACKET_END : RAIL_PACKET_TIME_AT_PREAMBLE_START,
+            .timeSent.totalPacketBytes = txFrameLength + 2
+          };
+          if (RAIL_GetTxPacketDetails (rail_handle, &txDetails) == RAIL_STATUS_NO_ERROR)
+            {
+              txSentTime = txDetails.timeSent.packetTime;
+            }
+          led_activity_pulse (&txActivity);
+          txNotification |= TX_NOTIFY_PACKET_SENT;
+        }
+      if (events & (RAIL_EVENT_TX_ABORTED | RAIL_EVENT_TX_UNDERFLOW))
+        {
+          txNotification |= TX_NOTIFY_ABORTED;
+        }
+      if (events & RAIL_EVENT_TX_BLOCKED)
+        {
+          txNotification |= TX_NOTIFY_BLOCKED;
+        }
+      if (events & RAIL_EVENT_TX_CHANNEL_BUSY)
+        {
+          txNotification |= TX_NOTIFY_CHANNEL_BUSY;
+        }
+      if (events & RAIL_EVENT_TX_SCHEDULED_TX_MISSED)
+        {
+          txNotification |= TX_NOTIFY_MISSED;
+        }
+      if (txNotification != 0)
+        {
+          xHigherPriorityTaskWoken = pdFALSE;
+          xTaskNotifyFromISR(transmitterTaskHandle, txNotification, eSetBits, &xHigherPriorityTaskWoken);
+          portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        }
+    }
+  if (events & RAIL_EVENT_RX_FIFO_OVERFLOW)
     {
-      sl_led_toggle (&sl_led_led0);
-      sl_udelay_wait (10000);
-      sl_led_toggle (&sl_led_led0);
+      rxStats.overflows++;
     }
   if (events & RAIL_EVENT_RX_PACKET_RECEIVED)
     {
-      sl_led_toggle (&sl_led_led1);
-      sl_udelay_wait (10000);
-      sl_led_toggle (&sl_led_led1);
+      led_activity_pulse (&rxActivity);
       xHigherPriorityTaskWoken = pdFALSE;
       //new rx -> deferred handler architecture
-      RAIL_HoldRxPacket (rail_handle);
+      if (RAIL_HoldRxPacket (rail_handle) != RAIL_RX_PACKET_HANDLE_INVALID)
+        {
+          if (++rxHeld > rxStats.heldPeak)
+            {
+              rxStats.heldPeak = rxHeld;
+            }
+        }
       vTaskNotifyGiveFromISR(receiverTaskHandle, &xHigherPriorityTaskWoken);
       portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
     }
+
+  elapsedUs = RAIL_GetTime () - entryTime;
+  railEventStats.count++;
+  railEventStats.lastUs = elapsedUs;
+  if (elapsedUs > railEventStats.maxUs)
+    {
+      railEventStats.maxUs = elapsedUs;
+    }
 }
 
 
@@ -455,7 +831,7 @@ void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events)
 RAIL_Status_t RAILCb_SetupRxFifo (RAIL_Handle_t railHandle)
 {
   RAIL_Status_t status = RAIL_SetRxFifo (railHandle, &railRxFifo[0], &rxFifoSize);
-  if (rxFifoSize != sizeof(pkt_t) * QUEUE_DEFAULT_LENGTH)
+  if (rxFifoSize != RADIO_FIFO_LENGTH)
     {
       // We set up an incorrect FIFO size
       return RAIL_STATUS_INVALID_PARAMETER;
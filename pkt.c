@@ -0,0 +1,119 @@
+/***************************************************************************//**
+ * @file pkt.c
+ * @brief Flood packet frame encoding and sequence number arithmetic
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "pkt.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define PKT_V1_HEADER_LENGTH (PKT_V1_FRAME_LENGTH - PKT_V1_PAYLOAD_LENGTH)
+
+///v2 header fields
+#define PKT_V2_TYPE_SHIFT    6
+#define PKT_V2_HOP_MASK      0x3F
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+uint16_t pkt_encode(const pkt_t *packet, uint8_t version, uint8_t *frame)
+{
+  const pkt_header_t *header = &packet->header;
+
+  if (version == PKT_VERSION_1) {
+    if (header->length > PKT_V1_PAYLOAD_LENGTH) {
+      return 0;
+    }
+    frame[0] = header->wupSeq;
+    frame[1] = 0;
+    frame[2] = header->hopCount;
+    frame[3] = 0;
+    frame[4] = (uint8_t)header->pktSeq;
+    frame[5] = (uint8_t)(header->pktSeq >> 8);
+    memcpy(&frame[PKT_V1_HEADER_LENGTH], packet->payload, header->length);
+    memset(&frame[PKT_V1_HEADER_LENGTH + header->length], 0, PKT_V1_PAYLOAD_LENGTH - header->length);
+    return PKT_V1_FRAME_LENGTH;
+  }
+
+  if (version != PKT_VERSION_2
+      || header->wupSeq > Wp
+      || header->hopCount > PKT_V2_HOP_COUNT_MAX
+      || header->length > PKT_DATA_PAYLOAD_MAX_LENGTH) {
+    return 0;
+  }
+  frame[0] = (uint8_t)(PKT_V2_FRAME_LENGTH(header->length) - 1);
+  frame[1] = (uint8_t)((header->wupSeq << PKT_V2_TYPE_SHIFT) | header->hopCount);
+  frame[2] = (uint8_t)header->pktSeq;
+  frame[3] = (uint8_t)(header->pktSeq >> 8);
+  frame[4] = (uint8_t)(header->pktSeq >> 16);
+  memcpy(&frame[PKT_V2_HEADER_LENGTH], packet->payload, header->length);
+  return PKT_V2_FRAME_LENGTH(header->length);
+}
+
+uint8_t pkt_decode(const uint8_t *frame, uint16_t length, pkt_t *packet, uint16_t capacity)
+{
+  pkt_header_t *header = &packet->header;
+
+  //A v1 frame starts with its wupSeq, too small for the length of a v2 one
+  if (length >= PKT_V2_HEADER_LENGTH
+      && length == (uint16_t)frame[0] + 1
+      && (frame[1] & PKT_V2_HOP_MASK) <= PKT_V2_HOP_COUNT_MAX) {
+    uint16_t payloadLength = length - PKT_V2_HEADER_LENGTH;
+    if (payloadLength > capacity) {
+      return 0;
+    }
+    header->wupSeq = frame[1] >> PKT_V2_TYPE_SHIFT;
+    header->hopCount = frame[1] & PKT_V2_HOP_MASK;
+    header->length = (uint8_t)payloadLength;
+    header->pktSeq = frame[2] | ((pkt_seq_t)frame[3] << 8) | ((pkt_seq_t)frame[4] << 16);
+    memcpy(packet->payload, &frame[PKT_V2_HEADER_LENGTH], payloadLength);
+    return PKT_VERSION_2;
+  }
+
+  //v1 hop counts are 16 bit on air but never went past a byte
+  if (length == PKT_V1_FRAME_LENGTH && frame[0] <= Wp && frame[1] == 0 && frame[3] == 0
+      && capacity >= PKT_V1_PAYLOAD_LENGTH) {
+    header->wupSeq = frame[0];
+    header->hopCount = frame[2];
+    header->length = PKT_V1_PAYLOAD_LENGTH;
+    header->pktSeq = frame[4] | ((pkt_seq_t)frame[5] << 8);
+    memcpy(packet->payload, &frame[PKT_V1_HEADER_LENGTH], PKT_V1_PAYLOAD_LENGTH);
+    return PKT_VERSION_1;
+  }
+  return 0;
+}
+
+pkt_seq_t pkt_seq_add(pkt_seq_t pktSeq, uint32_t count)
+{
+  return (pktSeq + count) & PKT_SEQ_MAX;
+}
+
+int32_t pkt_seq_diff(pkt_seq_t a, pkt_seq_t b)
+{
+  //Sign extend the PKT_SEQ_BITS wide difference
+  uint32_t diff = (a - b) & PKT_SEQ_MAX;
+
+  if (diff & (1UL << (PKT_SEQ_BITS - 1))) {
+    return (int32_t)diff - (int32_t)(1UL << PKT_SEQ_BITS);
+  }
+  return (int32_t)diff;
+}
+
+pkt_seq_t pkt_seq_extend(pkt_seq_t reference, pkt_seq_t low, uint8_t bits)
+{
+  uint32_t mask = (1UL << bits) - 1;
+  uint32_t half = 1UL << (bits - 1);
+  //Distance forward from the reference low bits, taken as backward past half the low space
+  uint32_t forward = (low - reference) & mask;
+
+  if (forward < half) {
+    return pkt_seq_add(reference, forward);
+  }
+  return pkt_seq_add(reference, PKT_SEQ_MAX + 1 - (mask + 1 - forward));
+}
@@ -0,0 +1,166 @@
+/***************************************************************************//**
+ * @file pkt.h
+ * @brief Flood packet definitions shared by the sink tasks
+ *
+ * Packets are handled as pkt_t and only turned into on-air frames by
+ * pkt_encode() and pkt_decode(). Two frame layouts exist:
+ *
+ * v1, fixed PKT_V1_FRAME_LENGTH bytes, all fields little endian:
+ *   uint16 wupSeq | uint16 hopCount | uint16 pktSeq |
+ *   PKT_V1_PAYLOAD_LENGTH bytes of payload
+ *
+ * v2, variable length, PKT_V2_HEADER_LENGTH bytes plus the payload:
+ *   length:8 | wupSeq:2 hopCount:6 | pktSeq:24 (little endian) | payload
+ *
+ * The v2 length byte counts the bytes after it, it's the one the radio
+ * reads in variable length mode. It also stands for the version: a v1
+ * frame starts with its wupSeq, at most Wp, a v2 frame with its length,
+ * at least PKT_V2_HEADER_LENGTH - 1. Hop count PKT_V2_HOP_COUNT_MAX + 1 is
+ * kept for the mark of the frames several v2 frames share, see pkt_agg.h.
+ ******************************************************************************/
+#ifndef PKT_H
+#define PKT_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+enum wupSequence{
+  Wb,
+  Wd,
+  Wr,
+  Wp  //FEC parity, see pkt_fec.h
+};
+
+/// Type of the packet sequence number, PKT_SEQ_BITS of it go on air.
+/// Compare and step sequence numbers with the pkt_seq_* helpers, they wrap.
+typedef uint32_t pkt_seq_t;
+#define PKT_SEQ_BITS 24
+#define PKT_SEQ_MAX  ((1UL << PKT_SEQ_BITS) - 1)
+
+/// Frame layouts
+#define PKT_VERSION_1 1
+#define PKT_VERSION_2 2
+#define PKT_V1_PAYLOAD_LENGTH 10
+#define PKT_V1_FRAME_LENGTH (6 + PKT_V1_PAYLOAD_LENGTH)
+#define PKT_V1_SEQ_BITS 16
+#define PKT_V2_HEADER_LENGTH 5
+#define PKT_V2_FRAME_LENGTH(payloadLength) (PKT_V2_HEADER_LENGTH + (payloadLength))
+
+#if PKT_V2_FRAME_LENGTH(PKT_DATA_PAYLOAD_MAX_LENGTH) - 1 > 0xFF
+#error "PKT_DATA_PAYLOAD_MAX_LENGTH doesn't fit the v2 length byte"
+#endif
+
+/// Longest frame of either layout
+#define PKT_FRAME_MAX_LENGTH \
+  ((PKT_V2_FRAME_LENGTH(PKT_DATA_PAYLOAD_MAX_LENGTH) > PKT_V1_FRAME_LENGTH) \
+   ? PKT_V2_FRAME_LENGTH(PKT_DATA_PAYLOAD_MAX_LENGTH) : PKT_V1_FRAME_LENGTH)
+
+/// Largest hop count the v2 header can carry
+#define PKT_V2_HOP_COUNT_MAX 62
+
+typedef struct
+{
+  uint8_t wupSeq;   //Frame type, enum wupSequence
+  uint8_t hopCount;
+  uint8_t length;   //Payload bytes
+  pkt_seq_t pktSeq; //Packet Sequence #
+} pkt_header_t;
+
+/// A packet, the payload capacity depends on where it's stored
+typedef struct
+{
+  pkt_header_t header;
+  uint8_t payload[];
+} pkt_t;
+
+/// Storage for a packet with room for payloadLength bytes, used through a pkt_t pointer
+#define PKT_STORAGE(payloadLength) \
+  struct {                         \
+    pkt_header_t header;           \
+    uint8_t payload[payloadLength]; \
+  }
+
+#pragma pack(push,1)
+/// Payload of a selective Wr: the header pktSeq is the first missing packet and
+/// bit i of lost (lost[i / 8] & (1 << (i % 8))) marks pktSeq + 1 + i as missing too.
+/// Legacy Wr frames don't carry the marker and ask for pktSeq and every newer packet.
+typedef struct
+{
+  uint8_t marker; //PKT_WR_BITMAP_MARKER
+  uint8_t bits;   //Valid bits in lost, up to PKT_WR_BITMAP_BITS
+  uint8_t lost[8];
+} pkt_wr_bitmap_t;
+#pragma pack(pop)
+
+#define PKT_WR_BITMAP_MARKER 0xB5
+#define PKT_WR_BITMAP_BITS   (8 * sizeof(((pkt_wr_bitmap_t *)0)->lost))
+
+/// Payload capacity of control frames: beacons are header only, a retransmission
+/// request carries at most a loss bitmap. Data frames carry up to PKT_DATA_PAYLOAD_MAX_LENGTH.
+#define PKT_CONTROL_PAYLOAD_LENGTH sizeof(pkt_wr_bitmap_t)
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Writes the on-air frame of a packet.
+ *
+ * @param packet Packet to encode
+ * @param version PKT_VERSION_1 or PKT_VERSION_2
+ * @param frame Buffer of at least PKT_FRAME_MAX_LENGTH bytes
+ * @returns Frame length, 0 if the packet doesn't fit the layout
+ *          (e.g. a hop count above PKT_V2_HOP_COUNT_MAX in v2)
+ *
+ * v1 frames carry the low 16 bits of the sequence number only, and their
+ * payload is padded with zeros to PKT_V1_PAYLOAD_LENGTH.
+ *****************************************************************************/
+uint16_t pkt_encode(const pkt_t *packet, uint8_t version, uint8_t *frame);
+
+/**************************************************************************//**
+ * Reads an on-air frame of either layout.
+ *
+ * @param frame Received frame
+ * @param length Frame length
+ * @param packet Decoded packet
+ * @param capacity Payload bytes packet has room for
+ * @returns Layout of the frame, PKT_VERSION_1 or PKT_VERSION_2, 0 if it's
+ *          not a valid frame or its payload doesn't fit. v1 sequence numbers only have their low 16
+ *          bits set, see pkt_seq_extend().
+ *****************************************************************************/
+uint8_t pkt_decode(const uint8_t *frame, uint16_t length, pkt_t *packet, uint16_t capacity);
+
+/**************************************************************************//**
+ * Steps a sequence number, wrapping in the PKT_SEQ_BITS space.
+ *
+ * @param pktSeq Sequence number
+ * @param count Steps forward
+ * @returns pktSeq + count
+ *****************************************************************************/
+pkt_seq_t pkt_seq_add(pkt_seq_t pktSeq, uint32_t count);
+
+/**************************************************************************//**
+ * Signed distance between two sequence numbers (RFC 1982).
+ *
+ * @returns a - b, negative if a is older than b. Only meaningful while the
+ *          two are less than half of the sequence space apart.
+ *****************************************************************************/
+int32_t pkt_seq_diff(pkt_seq_t a, pkt_seq_t b);
+
+/**************************************************************************//**
+ * Rebuilds a full sequence number from its low bits.
+ *
+ * @param reference A recent full sequence number, e.g. the newest sent
+ * @param low Low bits of the sequence number
+ * @param bits Number of bits in low
+ * @returns The sequence number closest to reference with those low bits
+ *****************************************************************************/
+pkt_seq_t pkt_seq_extend(pkt_seq_t reference, pkt_seq_t low, uint8_t bits);
+
+#endif  // PKT_H
@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file pkt_agg.c
+ * @brief Several v2 packets carried in one radio frame
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "pkt_agg.h"
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+uint16_t pkt_agg_encode(const pkt_t *const *packets, uint32_t count, uint8_t *frame, uint16_t capacity)
+{
+  uint32_t length = PKT_AGG_HEADER_LENGTH;
+
+  if (capacity > PKT_AGG_FRAME_MAX_LENGTH) {
+    capacity = PKT_AGG_FRAME_MAX_LENGTH;
+  }
+  if (count == 1) {
+    if (PKT_V2_FRAME_LENGTH(packets[0]->header.length) > capacity) {
+      return 0;
+    }
+    return pkt_encode(packets[0], PKT_VERSION_2, frame);
+  }
+  if (count == 0 || count > PKT_AGG_RECORDS_MAX) {
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t recordLength;
+    if (length + PKT_V2_FRAME_LENGTH(packets[i]->header.length) > capacity) {
+      return 0;
+    }
+    recordLength = pkt_encode(packets[i], PKT_VERSION_2, &frame[length]);
+    if (recordLength == 0) {
+      return 0;
+    }
+    length += recordLength;
+  }
+  frame[0] = (uint8_t)(length - 1);
+  frame[1] = PKT_AGG_MARK;
+  return (uint16_t)length;
+}
+
+void pkt_agg_reader_init(pkt_agg_reader_t *reader, const uint8_t *frame, uint16_t length)
+{
+  reader->frame = frame;
+  reader->length = length;
+  reader->aggregate = length >= PKT_AGG_HEADER_LENGTH
+                      && length == (uint16_t)frame[0] + 1
+                      && frame[1] == PKT_AGG_MARK;
+  if (reader->aggregate) {
+    //The records run to the end of the frame
+    reader->offset = PKT_AGG_HEADER_LENGTH;
+    reader->remaining = PKT_AGG_RECORDS_MAX;
+  } else {
+    //Any other frame is read as a single packet
+    reader->offset = 0;
+    reader->remaining = 1;
+  }
+}
+
+uint8_t pkt_agg_reader_next(pkt_agg_reader_t *reader, pkt_t *packet, uint16_t capacity)
+{
+  uint16_t recordLength;
+  uint8_t version;
+
+  if (reader->remaining == 0) {
+    return 0;
+  }
+  reader->remaining--;
+  if (!reader->aggregate) {
+    return pkt_decode(reader->frame, reader->length, packet, capacity);
+  }
+
+  if (reader->offset >= reader->length) {
+    reader->remaining = 0;
+    return 0;
+  }
+  recordLength = (uint16_t)reader->frame[reader->offset] + 1;
+  if (reader->offset + recordLength > reader->length) {
+    reader->remaining = 0;
+    return 0;
+  }
+  //Records are v2 only
+  version = pkt_decode(&reader->frame[reader->offset], recordLength, packet, capacity);
+  if (version != PKT_VERSION_2) {
+    reader->remaining = 0;
+    return 0;
+  }
+  reader->offset += recordLength;
+  return version;
+}
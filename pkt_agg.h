@@ -0,0 +1,84 @@
+/***************************************************************************//**
+ * @file pkt_agg.h
+ * @brief Several v2 packets carried in one radio frame
+ *
+ * An aggregate frame pays the preamble, syncword, CRC and radio start up
+ * once for up to PKT_AGG_RECORDS_MAX packets:
+ *
+ *   length:8 | PKT_AGG_MARK:8 | v2 frames
+ *
+ * The length byte counts the bytes after it, as in a v2 frame, and every
+ * record is a complete v2 frame, its own length byte included. The mark
+ * sits where a v2 frame has its type and hop count, it's a parity packet
+ * one hop past PKT_V2_HOP_COUNT_MAX, which no v2 frame carries. A frame of
+ * a single packet is sent as a plain v2 frame.
+ *
+ * pkt_agg_reader_next() returns the packets of any received frame in order,
+ * aggregate or not, so the sink, the relays and host tools split frames the
+ * same way.
+ ******************************************************************************/
+#ifndef PKT_AGG_H
+#define PKT_AGG_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "pkt.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define PKT_AGG_MARK          ((Wp << 6) | (PKT_V2_HOP_COUNT_MAX + 1))
+#define PKT_AGG_HEADER_LENGTH 2
+#define PKT_AGG_RECORDS_MAX   15
+
+/// Longest frame the radio takes, its length byte counts up to 255 bytes
+#define PKT_AGG_FRAME_MAX_LENGTH 256
+
+typedef struct
+{
+  const uint8_t *frame;
+  uint16_t length;
+  uint16_t offset;    //Next record
+  uint8_t remaining;  //Records left
+  bool aggregate;
+} pkt_agg_reader_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Writes the frame carrying a set of packets.
+ *
+ * @param packets Packets, in the order they are to be read back
+ * @param count Number of packets, 1 to PKT_AGG_RECORDS_MAX
+ * @param frame Frame buffer
+ * @param capacity Size of the frame buffer, at most PKT_AGG_FRAME_MAX_LENGTH
+ *                 bytes are used
+ * @returns Frame length, 0 if the packets don't fit or one can't be encoded
+ *****************************************************************************/
+uint16_t pkt_agg_encode(const pkt_t *const *packets, uint32_t count, uint8_t *frame, uint16_t capacity);
+
+/**************************************************************************//**
+ * Starts reading the packets of a received frame.
+ *
+ * @param reader Reader
+ * @param frame Received frame, it must stay valid while the reader is used
+ * @param length Frame length
+ *****************************************************************************/
+void pkt_agg_reader_init(pkt_agg_reader_t *reader, const uint8_t *frame, uint16_t length);
+
+/**************************************************************************//**
+ * Decodes the next packet of the frame.
+ *
+ * @param reader Reader
+ * @param packet Decoded packet
+ * @param capacity Payload bytes packet has room for
+ * @returns Layout of the packet as pkt_decode() does, 0 once the frame is
+ *          over or at the first invalid record
+ *****************************************************************************/
+uint8_t pkt_agg_reader_next(pkt_agg_reader_t *reader, pkt_t *packet, uint16_t capacity);
+
+#endif  // PKT_AGG_H
@@ -0,0 +1,98 @@
+/***************************************************************************//**
+ * @file pkt_fec.c
+ * @brief XOR parity packets over blocks of data packets
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "pkt_fec.h"
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void pkt_fec_encoder_reset(pkt_fec_encoder_t *encoder)
+{
+  memset(encoder->parity, 0, sizeof(encoder->parity));
+  memset(encoder->length, 0, sizeof(encoder->length));
+  encoder->count = 0;
+}
+
+bool pkt_fec_encoder_add(pkt_fec_encoder_t *encoder, const pkt_t *packet)
+{
+  uint32_t group = encoder->count % FEC_PARITY_COUNT;
+
+  if (encoder->count == 0) {
+    encoder->firstSeq = packet->header.pktSeq;
+  }
+  //Zero padding doesn't change the XOR, only the parity length grows
+  pkt_fec_xor_payload(encoder->parity[group], packet->payload, packet->header.length);
+  if (packet->header.length > encoder->length[group]) {
+    encoder->length[group] = packet->header.length;
+  }
+  encoder->count++;
+  return encoder->count == FEC_BLOCK_LENGTH;
+}
+
+void pkt_fec_encoder_build(const pkt_fec_encoder_t *encoder, uint32_t group, pkt_t *packet)
+{
+  packet->header.wupSeq = Wp;
+  packet->header.pktSeq = pkt_seq_add(encoder->firstSeq, group);
+  packet->header.length = encoder->length[group];
+  memcpy(packet->payload, encoder->parity[group], encoder->length[group]);
+}
+
+bool pkt_fec_recover(const pkt_t *parity, pkt_fec_lookup_cb_t lookup, void *context, pkt_t *packet)
+{
+  uint32_t missing = 0;
+  pkt_seq_t missingSeq = 0;
+
+  if (parity->header.length > PKT_DATA_PAYLOAD_MAX_LENGTH) {
+    return false;
+  }
+  memcpy(packet->payload, parity->payload, parity->header.length);
+  for (uint32_t i = 0; i < FEC_GROUP_LENGTH; i++) {
+    pkt_seq_t pktSeq = pkt_seq_add(parity->header.pktSeq, i * FEC_PARITY_COUNT);
+    const pkt_t *member = lookup(pktSeq, context);
+
+    if (member == NULL) {
+      if (++missing > 1) {
+        return false;
+      }
+      missingSeq = pktSeq;
+      continue;
+    }
+    //A member longer than the parity doesn't belong to this block
+    if (member->header.length > parity->header.length) {
+      return false;
+    }
+    pkt_fec_xor_payload(packet->payload, member->payload, member->header.length);
+  }
+  if (missing == 0) {
+    return false;
+  }
+  packet->header = parity->header;
+  packet->header.wupSeq = Wd;
+  packet->header.pktSeq = missingSeq;
+  return true;
+}
+
+void pkt_fec_xor_payload(uint8_t *accumulator, const uint8_t *payload, uint32_t length)
+{
+  uint32_t i = 0;
+
+  //Payloads aren't word aligned in the packed packets, memcpy keeps the word accesses legal
+  //and compiles down to single unaligned loads and stores on the Cortex-M4
+  for (; i + sizeof(uint32_t) <= length; i += sizeof(uint32_t)) {
+    uint32_t a, b;
+    memcpy(&a, &accumulator[i], sizeof(a));
+    memcpy(&b, &payload[i], sizeof(b));
+    a ^= b;
+    memcpy(&accumulator[i], &a, sizeof(a));
+  }
+  for (; i < length; i++) {
+    accumulator[i] ^= payload[i];
+  }
+}
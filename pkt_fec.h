@@ -0,0 +1,109 @@
+/***************************************************************************//**
+ * @file pkt_fec.h
+ * @brief XOR parity packets over blocks of data packets
+ *
+ * A block is FEC_BLOCK_LENGTH consecutive data packets. Parity packet r of a
+ * block has wupSeq Wp, pktSeq set to the sequence number of block packet r
+ * and, as payload, the XOR of the payloads of the block packets i with
+ * i % FEC_PARITY_COUNT == r. The groups are all the same size, so the
+ * sequence number alone gives the packets of a group, the v2 header has no
+ * room for a group index. A receiver missing a single packet of a
+ * group rebuilds its payload by XORing the parity with the other packets of
+ * the group, pkt_fec_recover() does that from the packets the receiver kept.
+ *
+ * Payloads of a group may differ in length: the shorter ones count as zero
+ * padded and the parity is as long as the longest. The rebuilt payload then
+ * carries the padding, its real length has to come from the payload itself.
+ ******************************************************************************/
+#ifndef PKT_FEC_H
+#define PKT_FEC_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "pkt.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (FEC_PARITY_COUNT < 1) || (FEC_PARITY_COUNT > FEC_BLOCK_LENGTH)
+#error "FEC_PARITY_COUNT must be between 1 and FEC_BLOCK_LENGTH"
+#endif
+
+#if (FEC_BLOCK_LENGTH % FEC_PARITY_COUNT) != 0
+#error "FEC_PARITY_COUNT must divide FEC_BLOCK_LENGTH"
+#endif
+
+/// Data packets covered by one parity packet
+#define FEC_GROUP_LENGTH (FEC_BLOCK_LENGTH / FEC_PARITY_COUNT)
+
+typedef struct
+{
+  uint8_t parity[FEC_PARITY_COUNT][PKT_DATA_PAYLOAD_MAX_LENGTH];
+  uint8_t length[FEC_PARITY_COUNT]; //Longest payload of each group
+  uint32_t count;     //Data packets added to the current block
+  pkt_seq_t firstSeq; //Sequence number of the first packet of the block
+} pkt_fec_encoder_t;
+
+/// Gives the data packet of a sequence number the receiver holds, NULL if
+/// it's missing
+typedef const pkt_t *(*pkt_fec_lookup_cb_t)(pkt_seq_t pktSeq, void *context);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts an empty block.
+ *
+ * @param encoder Encoder
+ *****************************************************************************/
+void pkt_fec_encoder_reset(pkt_fec_encoder_t *encoder);
+
+/**************************************************************************//**
+ * Adds the next data packet of the flood to the current block.
+ *
+ * @param encoder Encoder
+ * @param packet Data packet, in sequence order
+ * @returns true if the block is complete, the parity packets can be built
+ *          and the encoder must be reset before adding the next packet
+ *****************************************************************************/
+bool pkt_fec_encoder_add(pkt_fec_encoder_t *encoder, const pkt_t *packet);
+
+/**************************************************************************//**
+ * Fills in a parity packet of the completed block.
+ *
+ * @param encoder Encoder holding a complete block
+ * @param group Parity group, below FEC_PARITY_COUNT
+ * @param packet Packet to fill, with room for PKT_DATA_PAYLOAD_MAX_LENGTH
+ *               bytes of payload. The hop count is left to the caller.
+ *****************************************************************************/
+void pkt_fec_encoder_build(const pkt_fec_encoder_t *encoder, uint32_t group, pkt_t *packet);
+
+/**************************************************************************//**
+ * XORs a payload into another one, a word at a time.
+ *
+ * @param accumulator Payload updated in place
+ * @param payload Payload XORed in
+ * @param length Bytes to XOR
+ *****************************************************************************/
+void pkt_fec_xor_payload(uint8_t *accumulator, const uint8_t *payload, uint32_t length);
+
+/**************************************************************************//**
+ * Rebuilds the data packet of a parity group the receiver is missing.
+ *
+ * @param parity Parity packet, wupSeq Wp
+ * @param lookup Called for every data packet of the group
+ * @param context Passed through to lookup
+ * @param packet Packet to fill, with room for PKT_DATA_PAYLOAD_MAX_LENGTH
+ *               bytes of payload. The hop count is the one of the parity.
+ * @returns true if exactly one packet of the group was missing and packet
+ *          now holds it, false if none or several were missing
+ *
+ * The rebuilt payload is as long as the parity, see the zero padding above.
+ *****************************************************************************/
+bool pkt_fec_recover(const pkt_t *parity, pkt_fec_lookup_cb_t lookup, void *context, pkt_t *packet);
+
+#endif  // PKT_FEC_H
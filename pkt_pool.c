@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file pkt_pool.c
+ * @brief Statically allocated, reference counted pool of packets
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pkt_pool.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef PKT_STORAGE(PKT_CONTROL_PAYLOAD_LENGTH) pkt_control_storage_t;
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) pkt_data_storage_t;
+
+typedef struct
+{
+  pkt_pool_index_t first;  //Index of the first slot of the class
+  pkt_pool_index_t length;
+  pkt_pool_index_t *freeList;
+  uint32_t freeCount;
+} pkt_pool_class_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static pkt_control_storage_t controlPackets[PKT_POOL_CONTROL_LENGTH];
+static pkt_data_storage_t dataPackets[PKT_POOL_DEFAULT_LENGTH];
+static uint8_t refCount[PKT_POOL_TOTAL_LENGTH];
+
+///Stacks of free slot indices, one per class
+static pkt_pool_index_t controlFreeList[PKT_POOL_CONTROL_LENGTH];
+static pkt_pool_index_t dataFreeList[PKT_POOL_DEFAULT_LENGTH];
+static pkt_pool_class_t classes[] = {
+  [PKT_CLASS_CONTROL] = { 0, PKT_POOL_CONTROL_LENGTH, controlFreeList, 0 },
+  [PKT_CLASS_DATA] = { PKT_POOL_CONTROL_LENGTH, PKT_POOL_DEFAULT_LENGTH, dataFreeList, 0 }
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void pkt_pool_init(void)
+{
+  for (uint32_t i = 0; i < PKT_POOL_TOTAL_LENGTH; i++) {
+    refCount[i] = 0;
+  }
+  for (uint32_t c = 0; c < sizeof(classes) / sizeof(classes[0]); c++) {
+    pkt_pool_class_t *slotClass = &classes[c];
+    for (uint32_t i = 0; i < slotClass->length; i++) {
+      slotClass->freeList[i] = (pkt_pool_index_t)(slotClass->first + slotClass->length - 1 - i);
+    }
+    slotClass->freeCount = slotClass->length;
+  }
+}
+
+pkt_pool_index_t pkt_pool_alloc(pkt_class_t slotClass)
+{
+  pkt_pool_class_t *pool = &classes[slotClass];
+  pkt_pool_index_t index = PKT_POOL_INVALID_INDEX;
+
+  taskENTER_CRITICAL();
+  if (pool->freeCount > 0) {
+    index = pool->freeList[--pool->freeCount];
+    refCount[index] = 1;
+  }
+  taskEXIT_CRITICAL();
+
+  if (index != PKT_POOL_INVALID_INDEX) {
+    memset(pkt_pool_get(index), 0, sizeof(pkt_header_t) + pkt_pool_capacity(index));
+  }
+  return index;
+}
+
+void pkt_pool_ref(pkt_pool_index_t index)
+{
+  configASSERT(index < PKT_POOL_TOTAL_LENGTH && refCount[index] > 0);
+
+  taskENTER_CRITICAL();
+  refCount[index]++;
+  taskEXIT_CRITICAL();
+}
+
+void pkt_pool_unref(pkt_pool_index_t index)
+{
+  pkt_pool_class_t *pool = &classes[(index < PKT_POOL_CONTROL_LENGTH) ? PKT_CLASS_CONTROL : PKT_CLASS_DATA];
+
+  configASSERT(index < PKT_POOL_TOTAL_LENGTH && refCount[index] > 0);
+
+  taskENTER_CRITICAL();
+  if (--refCount[index] == 0) {
+    pool->freeList[pool->freeCount++] = index;
+  }
+  taskEXIT_CRITICAL();
+}
+
+pkt_t *pkt_pool_get(pkt_pool_index_t index)
+{
+  if (index < PKT_POOL_CONTROL_LENGTH) {
+    return (pkt_t *)&controlPackets[index];
+  }
+  return (pkt_t *)&dataPackets[index - PKT_POOL_CONTROL_LENGTH];
+}
+
+uint16_t pkt_pool_capacity(pkt_pool_index_t index)
+{
+  return (index < PKT_POOL_CONTROL_LENGTH) ? PKT_CONTROL_PAYLOAD_LENGTH : PKT_DATA_PAYLOAD_MAX_LENGTH;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************//**
+ * @file pkt_pool.h
+ * @brief Statically allocated, reference counted pool of packets
+ ******************************************************************************/
+#ifndef PKT_POOL_H
+#define PKT_POOL_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include "pkt.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Index of a packet slot, this is what travels through the queues
+typedef uint8_t pkt_pool_index_t;
+
+#define PKT_POOL_INVALID_INDEX ((pkt_pool_index_t)0xFF)
+
+/// Slot classes, they differ in payload capacity
+typedef enum
+{
+  PKT_CLASS_CONTROL, //PKT_CONTROL_PAYLOAD_LENGTH bytes
+  PKT_CLASS_DATA     //PKT_DATA_PAYLOAD_MAX_LENGTH bytes
+} pkt_class_t;
+
+/// Control slots come first in the index space, then the data ones
+#define PKT_POOL_TOTAL_LENGTH (PKT_POOL_CONTROL_LENGTH + PKT_POOL_DEFAULT_LENGTH)
+
+#if PKT_POOL_TOTAL_LENGTH >= 0xFF
+#error "PKT_POOL_CONTROL_LENGTH + PKT_POOL_DEFAULT_LENGTH must fit in pkt_pool_index_t"
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Marks every slot as free.
+ *****************************************************************************/
+void pkt_pool_init(void);
+
+/**************************************************************************//**
+ * Takes a free slot of a class from the pool, the packet in it is zeroed.
+ *
+ * @param slotClass Class of the slot, pick the smallest the payload fits
+ * @returns Index of the slot holding one reference, PKT_POOL_INVALID_INDEX if
+ *          the slots of that class are exhausted
+ *****************************************************************************/
+pkt_pool_index_t pkt_pool_alloc(pkt_class_t slotClass);
+
+/**************************************************************************//**
+ * Adds a reference to an allocated slot.
+ *
+ * @param index Slot index
+ *****************************************************************************/
+void pkt_pool_ref(pkt_pool_index_t index);
+
+/**************************************************************************//**
+ * Drops a reference, the slot returns to the pool with the last one.
+ *
+ * @param index Slot index
+ *****************************************************************************/
+void pkt_pool_unref(pkt_pool_index_t index);
+
+/**************************************************************************//**
+ * Gives access to the packet stored in a slot.
+ *
+ * @param index Slot index
+ * @returns Pointer to the packet, valid as long as a reference is held
+ *****************************************************************************/
+pkt_t *pkt_pool_get(pkt_pool_index_t index);
+
+/**************************************************************************//**
+ * Gives the payload capacity of a slot.
+ *
+ * @param index Slot index
+ * @returns Payload bytes the packet in the slot has room for
+ *****************************************************************************/
+uint16_t pkt_pool_capacity(pkt_pool_index_t index);
+
+#endif  // PKT_POOL_H
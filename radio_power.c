@@ -0,0 +1,120 @@
+/***************************************************************************//**
+ * @file radio_power.c
+ * @brief Tracked radio power state, RFSense armed once per idle entry
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "em_core.h"
+
+#include "flood_config.h"
+#include "radio_power.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void disarmRfSense(void);
+static void rfSenseCallback(void);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static RAIL_Handle_t rail;
+static radio_power_wakeup_cb_t onWakeup;
+static volatile radio_power_state_t state = RADIO_POWER_IDLE;
+static radio_power_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void radio_power_init(RAIL_Handle_t railHandle, radio_power_wakeup_cb_t wakeupCallback)
+{
+  rail = railHandle;
+  onWakeup = wakeupCallback;
+}
+
+void radio_power_sleep(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  //Already armed, nothing to do until someone uses the radio
+  if (state == RADIO_POWER_RFSENSE_ARMED) {
+    return;
+  }
+  //The state is also changed by the RFSense callback and by higher priority tasks,
+  //check and reconfigure in one go so RFSense can't end up armed under them
+  CORE_ENTER_ATOMIC();
+  if (state != RADIO_POWER_RFSENSE_ARMED) {
+    RAIL_Idle(rail, RAIL_IDLE, true);
+    RAIL_StartRfSense(rail, RAIL_RFSENSE_SUBGHZ_LOW_SENSITIVITY, RFSENSE_SENSE_TIME_US, rfSenseCallback);
+    state = RADIO_POWER_RFSENSE_ARMED;
+    stats.reconfigurations++;
+    stats.rfSenseArms++;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+RAIL_Status_t radio_power_start_rx(uint16_t channel)
+{
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  //The auto transitions may have left RX after a packet, ask the radio
+  if (state != RADIO_POWER_RX
+      || (RAIL_GetRadioState(rail) & RAIL_RF_STATE_RX) != RAIL_RF_STATE_RX) {
+    disarmRfSense();
+    status = RAIL_StartRx(rail, channel, NULL);
+    state = RADIO_POWER_RX;
+    stats.reconfigurations++;
+  }
+  CORE_EXIT_ATOMIC();
+  return status;
+}
+
+void radio_power_claim_tx(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  disarmRfSense();
+  state = RADIO_POWER_TX;
+  CORE_EXIT_ATOMIC();
+}
+
+radio_power_state_t radio_power_get_state(void)
+{
+  return state;
+}
+
+const radio_power_stats_t *radio_power_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Called with interrupts disabled
+void disarmRfSense(void)
+{
+  if (state == RADIO_POWER_RFSENSE_ARMED) {
+    RAIL_StartRfSense(rail, RAIL_RFSENSE_OFF, 0, NULL);
+    state = RADIO_POWER_IDLE;
+    stats.reconfigurations++;
+    stats.rfSenseDisarms++;
+  }
+}
+
+void rfSenseCallback(void)
+{
+  //RFSense is one shot, it's off once it has fired
+  state = RADIO_POWER_IDLE;
+  stats.rfSenseWakeups++;
+  if (onWakeup != NULL) {
+    onWakeup();
+  }
+}
@@ -0,0 +1,88 @@
+/***************************************************************************//**
+ * @file radio_power.h
+ * @brief Tracked radio power state, RFSense armed once per idle entry
+ ******************************************************************************/
+#ifndef RADIO_POWER_H
+#define RADIO_POWER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+#include "rail.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef enum
+{
+  RADIO_POWER_IDLE,         //Radio idle, RFSense off
+  RADIO_POWER_RX,           //Receive requested
+  RADIO_POWER_TX,           //Transmit requested
+  RADIO_POWER_RFSENSE_ARMED //Radio idle, RFSense listening for a wake up
+} radio_power_state_t;
+
+typedef struct
+{
+  uint32_t reconfigurations; //Calls that changed the radio state
+  uint32_t rfSenseArms;
+  uint32_t rfSenseDisarms;   //Armed RFSense turned off because a task needed the radio
+  uint32_t rfSenseWakeups;
+} radio_power_stats_t;
+
+///Called from interrupt context when RFSense detects energy, the radio is idle then
+typedef void (*radio_power_wakeup_cb_t)(void);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets the radio used and the RFSense wake up callback.
+ *
+ * @param railHandle RAIL instance
+ * @param wakeupCallback Called when RFSense fires
+ *****************************************************************************/
+void radio_power_init(RAIL_Handle_t railHandle, radio_power_wakeup_cb_t wakeupCallback);
+
+/**************************************************************************//**
+ * Idles the radio and arms RFSense, unless it's armed already.
+ *
+ * Meant for the idle hook: only the first call after the radio was used
+ * touches the hardware.
+ *****************************************************************************/
+void radio_power_sleep(void);
+
+/**************************************************************************//**
+ * Starts receiving, turning RFSense off first if it's armed.
+ *
+ * Does nothing if the radio is already receiving. Can be called from
+ * interrupt context.
+ *
+ * @param channel Channel to receive on
+ * @returns Status of RAIL_StartRx, or RAIL_STATUS_NO_ERROR if already in RX
+ *****************************************************************************/
+RAIL_Status_t radio_power_start_rx(uint16_t channel);
+
+/**************************************************************************//**
+ * Claims the radio for a transmission, turning RFSense off if it's armed.
+ *
+ * Call it before starting the transmission with RAIL.
+ *****************************************************************************/
+void radio_power_claim_tx(void);
+
+/**************************************************************************//**
+ * Gives the tracked state.
+ *
+ * @returns Last state set through this module
+ *****************************************************************************/
+radio_power_state_t radio_power_get_state(void);
+
+/**************************************************************************//**
+ * Gives access to the counters.
+ *
+ * @returns Pointer to the counters
+ *****************************************************************************/
+const radio_power_stats_t *radio_power_get_stats(void);
+
+#endif  // RADIO_POWER_H
@@ -0,0 +1,328 @@
+/***************************************************************************//**
+ * @file relay.c
+ * @brief Relay side of the flood protocol
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "pkt_agg.h"
+#include "pkt_fec.h"
+#include "relay.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define HISTORY_BITS 64
+
+///History positions a Wr can ask for, the upstream buffer holds the newest ones
+#define REACH_MASK \
+  (((RELAY_BUFFER_LENGTH >= HISTORY_BITS) ? ~(uint64_t)0 : ((uint64_t)1 << RELAY_BUFFER_LENGTH) - 1) & ~(uint64_t)1)
+
+typedef struct
+{
+  const relay_t *relay;
+  bool unavailable;   //A packet of the group was received but isn't kept anymore
+} parity_lookup_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void learnHop(relay_t *relay, const pkt_t *packet);
+static bool handlePacket(relay_t *relay, pkt_t *packet);
+static bool handleData(relay_t *relay, const pkt_t *packet);
+static bool handleParity(relay_t *relay, pkt_t *packet);
+static const pkt_t *lookupKept(pkt_seq_t pktSeq, void *context);
+static void serveRequest(relay_t *relay, const pkt_t *packet);
+static void resend(relay_t *relay, pkt_seq_t pktSeq);
+static bool forward(relay_t *relay, pkt_t *packet, uint8_t hopCount);
+static uint64_t missingInReach(const relay_t *relay);
+static uint64_t validMask(const relay_t *relay);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void relay_init(relay_t *relay, uint8_t hop, relay_send_cb_t send, relay_deliver_cb_t deliver,
+                void *context)
+{
+  memset(relay, 0, sizeof(*relay));
+  relay->hop = hop;
+  relay->send = send;
+  relay->deliver = deliver;
+  relay->context = context;
+}
+
+uint32_t relay_handle_frame(relay_t *relay, const uint8_t *frame, uint16_t length)
+{
+  PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) packet;
+  pkt_agg_reader_t reader;
+  uint8_t version;
+  uint32_t delayMs = RELAY_NO_REQUEST;
+
+  pkt_agg_reader_init(&reader, frame, length);
+  while ((version = pkt_agg_reader_next(&reader, (pkt_t *)&packet, sizeof(packet.payload))) != 0) {
+    if (version == PKT_VERSION_1 && relay->synced) {
+      packet.header.pktSeq = pkt_seq_extend(relay->highest, packet.header.pktSeq, PKT_V1_SEQ_BITS);
+    }
+    if (handlePacket(relay, (pkt_t *)&packet)) {
+      delayMs = RELAY_WR_DELAY_MS;
+    }
+  }
+  return delayMs;
+}
+
+uint32_t relay_request(relay_t *relay)
+{
+  uint64_t missing = missingInReach(relay);
+  PKT_STORAGE(sizeof(pkt_wr_bitmap_t)) request;
+  pkt_wr_bitmap_t bitmap = { .marker = PKT_WR_BITMAP_MARKER };
+  uint32_t oldest;
+
+  if (missing == 0 || relay->wrAttempts >= RELAY_WR_ATTEMPTS) {
+    relay->requesting = false;
+    return RELAY_NO_REQUEST;
+  }
+  oldest = 63 - (uint32_t)__builtin_clzll(missing);
+  bitmap.bits = (uint8_t)(oldest - 1);
+  for (uint32_t i = 0; i < bitmap.bits; i++) {
+    if (missing & ((uint64_t)1 << (oldest - 1 - i))) {
+      bitmap.lost[i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+  }
+  memset(&request.header, 0, sizeof(request.header));
+  request.header.wupSeq = Wr;
+  request.header.pktSeq = pkt_seq_add(relay->highest, PKT_SEQ_MAX + 1 - oldest);
+  request.header.length = sizeof(bitmap);
+  memcpy(request.payload, &bitmap, sizeof(bitmap));
+
+  if (forward(relay, (pkt_t *)&request, relay->hop - 1)) {
+    relay->stats.wrSent++;
+  }
+  relay->wrAttempts++;
+  return RELAY_WR_RETRY_MS;
+}
+
+uint8_t relay_get_hop(const relay_t *relay)
+{
+  return relay->hop;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Upstream nodes are the ones sending beacons one hop below ours and data
+///packets carrying our hop count
+void learnHop(relay_t *relay, const pkt_t *packet)
+{
+  uint32_t hop;
+
+  if (packet->header.wupSeq == Wb) {
+    hop = packet->header.hopCount + 1u;
+  } else if (packet->header.wupSeq == Wd) {
+    hop = packet->header.hopCount;
+  } else {
+    return;
+  }
+  //Our own rebroadcasts must still fit the header
+  if (hop != 0 && hop < relay->hop && hop < PKT_V2_HOP_COUNT_MAX) {
+    relay->hop = (uint8_t)hop;
+  }
+}
+
+///Returns true if a relay_request() call became due
+bool handlePacket(relay_t *relay, pkt_t *packet)
+{
+  learnHop(relay, packet);
+  if (relay->hop == RELAY_HOP_UNKNOWN) {
+    return false;
+  }
+  switch (packet->header.wupSeq) {
+    case Wd:
+      if (packet->header.hopCount == relay->hop) {
+        return handleData(relay, packet);
+      }
+      break;
+    case Wp:
+      if (packet->header.hopCount == relay->hop) {
+        return handleParity(relay, packet);
+      }
+      break;
+    case Wb:
+      if (packet->header.hopCount + 1 == relay->hop && forward(relay, packet, relay->hop)) {
+        relay->stats.forwarded++;
+      }
+      break;
+    case Wr:
+      if (packet->header.hopCount == relay->hop) {
+        serveRequest(relay, packet);
+      }
+      break;
+    default:
+      break;
+  }
+  return false;
+}
+
+///Takes the first copy of a data packet and tracks the sequence numbers skipped
+bool handleData(relay_t *relay, const pkt_t *packet)
+{
+  pkt_seq_t pktSeq = packet->header.pktSeq;
+  relay_packet_t *slot;
+
+  if (!relay->synced) {
+    //Nothing before the first packet heard is missed
+    relay->synced = true;
+    relay->firstSeq = pktSeq;
+    relay->highest = pktSeq;
+    relay->history = 1;
+  } else {
+    int32_t distance = pkt_seq_diff(pktSeq, relay->highest);
+
+    if (distance > 0) {
+      uint64_t missing = ~relay->history & validMask(relay);
+
+      //Missing ones pushed out of the history are given up on
+      if (distance < HISTORY_BITS) {
+        missing &= ~(uint64_t)0 << (HISTORY_BITS - distance);
+      } else {
+        relay->stats.abandoned += (uint32_t)(distance - HISTORY_BITS);
+      }
+      relay->stats.abandoned += (uint32_t)__builtin_popcountll(missing);
+      relay->stats.gaps += (uint32_t)(distance - 1);
+      relay->history = (distance < HISTORY_BITS) ? (relay->history << distance) | 1 : 1;
+      relay->highest = pktSeq;
+      if (distance > 1) {
+        relay->wrAttempts = 0;
+      }
+    } else {
+      uint32_t position = (uint32_t)-distance;
+
+      if (position >= HISTORY_BITS || pkt_seq_diff(pktSeq, relay->firstSeq) < 0
+          || (relay->history & ((uint64_t)1 << position))) {
+        relay->stats.duplicates++;
+        return false;
+      }
+      relay->history |= (uint64_t)1 << position;
+      relay->stats.recovered++;
+      relay->wrAttempts = 0;
+    }
+  }
+
+  relay->stats.received++;
+  if (relay->deliver != NULL) {
+    relay->deliver(packet, relay->context);
+  }
+  slot = &relay->buffer[pktSeq % RELAY_BUFFER_LENGTH];
+  slot->header = packet->header;
+  memcpy(slot->payload, packet->payload, packet->header.length);
+  if (forward(relay, (pkt_t *)slot, relay->hop + 1)) {
+    relay->stats.forwarded++;
+  }
+
+  if (missingInReach(relay) != 0 && !relay->requesting) {
+    relay->requesting = true;
+    return true;
+  }
+  return false;
+}
+
+///Rebuilds the one packet of the parity group we miss, if any, then passes the parity on
+bool handleParity(relay_t *relay, pkt_t *packet)
+{
+  relay_packet_t rebuilt;
+  parity_lookup_t lookup = { .relay = relay, .unavailable = false };
+  bool requesting = false;
+
+  if (relay->synced && pkt_fec_recover(packet, lookupKept, &lookup, (pkt_t *)&rebuilt)
+      && !lookup.unavailable && pkt_seq_diff(rebuilt.header.pktSeq, relay->firstSeq) >= 0
+      && pkt_seq_diff(rebuilt.header.pktSeq, relay->highest) > -HISTORY_BITS) {
+    relay->stats.rebuilt++;
+    requesting = handleData(relay, (pkt_t *)&rebuilt);
+  }
+  if (forward(relay, packet, relay->hop + 1)) {
+    relay->stats.forwarded++;
+  }
+  return requesting;
+}
+
+///Gives a data packet of a parity group if we have it, packets received but
+///already overwritten in the buffer make the group unusable
+const pkt_t *lookupKept(pkt_seq_t pktSeq, void *context)
+{
+  parity_lookup_t *lookup = context;
+  const relay_t *relay = lookup->relay;
+  const relay_packet_t *slot = &relay->buffer[pktSeq % RELAY_BUFFER_LENGTH];
+  int32_t distance = pkt_seq_diff(pktSeq, relay->highest);
+
+  if (distance > 0 || -distance >= HISTORY_BITS || pkt_seq_diff(pktSeq, relay->firstSeq) < 0
+      || !(relay->history & ((uint64_t)1 << -distance))) {
+    return NULL;
+  }
+  if (slot->header.wupSeq != Wd || slot->header.pktSeq != pktSeq) {
+    lookup->unavailable = true;
+    return NULL;
+  }
+  return (const pkt_t *)slot;
+}
+
+///Answers a Wr as the sink does, from the packets kept
+void serveRequest(relay_t *relay, const pkt_t *packet)
+{
+  pkt_wr_bitmap_t request;
+  pkt_seq_t pktSeq = packet->header.pktSeq;
+
+  relay->stats.wrServed++;
+  if (packet->header.length >= sizeof(request)) {
+    memcpy(&request, packet->payload, sizeof(request));
+    if (request.marker == PKT_WR_BITMAP_MARKER && request.bits <= PKT_WR_BITMAP_BITS) {
+      resend(relay, pktSeq);
+      for (uint32_t i = 0; i < request.bits; i++) {
+        if (request.lost[i / 8] & (1u << (i % 8))) {
+          resend(relay, pkt_seq_add(pktSeq, i + 1));
+        }
+      }
+      return;
+    }
+  }
+  //Legacy request, the packet and every newer one
+  while (relay->synced && pkt_seq_diff(pktSeq, relay->highest) <= 0) {
+    resend(relay, pktSeq);
+    pktSeq = pkt_seq_add(pktSeq, 1);
+  }
+}
+
+void resend(relay_t *relay, pkt_seq_t pktSeq)
+{
+  relay_packet_t *slot = &relay->buffer[pktSeq % RELAY_BUFFER_LENGTH];
+
+  if (slot->header.wupSeq != Wd || slot->header.pktSeq != pktSeq) {
+    return;
+  }
+  if (forward(relay, (pkt_t *)slot, relay->hop + 1)) {
+    relay->stats.resent++;
+  }
+}
+
+bool forward(relay_t *relay, pkt_t *packet, uint8_t hopCount)
+{
+  packet->header.hopCount = hopCount;
+  return relay->send(packet, relay->context);
+}
+
+uint64_t missingInReach(const relay_t *relay)
+{
+  return ~relay->history & validMask(relay) & REACH_MASK;
+}
+
+///History positions holding sequence numbers from the first one heard on
+uint64_t validMask(const relay_t *relay)
+{
+  int32_t span = pkt_seq_diff(relay->highest, relay->firstSeq);
+
+  if (!relay->synced) {
+    return 0;
+  }
+  return (span >= HISTORY_BITS - 1) ? ~(uint64_t)0 : ((uint64_t)1 << (span + 1)) - 1;
+}
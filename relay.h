@@ -0,0 +1,145 @@
+/***************************************************************************//**
+ * @file relay.h
+ * @brief Relay side of the flood protocol
+ *
+ * A relay takes packets from its upstream neighbours only, the frames whose
+ * hopCount is its own:
+ *
+ * - a data packet heard for the first time is delivered, kept for
+ *   retransmissions and rebroadcast with hopCount + 1,
+ * - a beacon (hopCount one below its own) is rebroadcast with its own hop
+ *   count, which the sink counts as consistent,
+ * - a parity packet is rebroadcast with hopCount + 1, after rebuilding the
+ *   data packet of its group the relay misses, if it misses only that one,
+ * - a Wr carrying its own hop count, from a relay one hop further, is
+ *   answered from the packets it kept.
+ *
+ * Sequence numbers it skips are asked upstream with a selective Wr carrying
+ * the hop count below its own, while they're still in the retransmission
+ * buffer of the upstream node. A relay started without a hop count takes
+ * the lowest one its beacons and data packets show.
+ *
+ * The module only keeps the protocol state, the caller owns the radio and
+ * does the waiting as it does for trickle.h: every packet to transmit goes
+ * through the send callback, and when relay_handle_frame() returns a delay
+ * the caller calls relay_request() once it's over, and again after each
+ * delay relay_request() returns. No locking is done, callers sharing a relay
+ * between tasks serialize the calls themselves.
+ ******************************************************************************/
+#ifndef RELAY_H
+#define RELAY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "pkt.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Packets a relay keeps to answer Wr, and the reach of its own requests
+#define RELAY_BUFFER_LENGTH RETRANSMISSION_BUFFER_DEFAULT_LENGTH
+
+#if RELAY_BUFFER_LENGTH > 64
+#error "RELAY_BUFFER_LENGTH exceeds the received packet history"
+#endif
+
+/// Hop count of a relay that hasn't heard its upstream yet
+#define RELAY_HOP_UNKNOWN 0xFF
+
+/// No relay_request() call is due
+#define RELAY_NO_REQUEST UINT32_MAX
+
+/// Hands a packet to the transmitter, to be sent behind a WUP. The packet
+/// is only valid during the call. Returns false if it's not taken, either
+/// for lack of room or because the same data packet is already waiting.
+typedef bool (*relay_send_cb_t)(const pkt_t *packet, void *context);
+
+/// Hands the first copy of a data packet to the application
+typedef void (*relay_deliver_cb_t)(const pkt_t *packet, void *context);
+
+typedef struct
+{
+  uint32_t received;     //Data packets, first copies
+  uint32_t duplicates;
+  uint32_t forwarded;    //Data and beacons rebroadcast
+  uint32_t gaps;         //Sequence numbers skipped
+  uint32_t recovered;    //Skipped ones received later
+  uint32_t abandoned;    //Skipped ones that left the upstream buffer
+  uint32_t rebuilt;      //Missing ones rebuilt from a parity packet
+  uint32_t wrSent;
+  uint32_t wrServed;     //Requests of downstream relays answered
+  uint32_t resent;
+} relay_stats_t;
+
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) relay_packet_t;
+
+typedef struct
+{
+  uint8_t hop;
+  relay_send_cb_t send;
+  relay_deliver_cb_t deliver;
+  void *context;
+
+  //Received data packets: bit i of history is highest - i
+  bool synced;
+  pkt_seq_t firstSeq;
+  pkt_seq_t highest;
+  uint64_t history;
+  relay_packet_t buffer[RELAY_BUFFER_LENGTH];
+
+  bool requesting;       //A relay_request() call is due
+  uint32_t wrAttempts;   //Wr sent since the last progress
+
+  relay_stats_t stats;
+} relay_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets a relay up with nothing received.
+ *
+ * @param relay Relay
+ * @param hop Hop count of the relay, 1 for the neighbours of the sink,
+ *            RELAY_HOP_UNKNOWN to learn it from the packets heard
+ * @param send Called for every packet to transmit
+ * @param deliver Called for the first copy of every data packet, may be NULL
+ * @param context Passed through to the callbacks
+ *****************************************************************************/
+void relay_init(relay_t *relay, uint8_t hop, relay_send_cb_t send, relay_deliver_cb_t deliver,
+                void *context);
+
+/**************************************************************************//**
+ * Handles a received radio frame, of any layout, aggregated or not.
+ *
+ * @param relay Relay
+ * @param frame Received frame
+ * @param length Frame length
+ * @returns Delay after which relay_request() must be called,
+ *          RELAY_NO_REQUEST if no new wait starts
+ *****************************************************************************/
+uint32_t relay_handle_frame(relay_t *relay, const uint8_t *frame, uint16_t length);
+
+/**************************************************************************//**
+ * Asks upstream for the skipped packets still in reach, the oldest in the
+ * header and the newer ones in the bitmap.
+ *
+ * @param relay Relay
+ * @returns Delay after which it must be called again, RELAY_NO_REQUEST once
+ *          nothing is missing or RELAY_WR_ATTEMPTS requests went unanswered
+ *****************************************************************************/
+uint32_t relay_request(relay_t *relay);
+
+/**************************************************************************//**
+ * Gives the hop count of the relay.
+ *
+ * @param relay Relay
+ * @returns Hop count, RELAY_HOP_UNKNOWN if it's not known yet
+ *****************************************************************************/
+uint8_t relay_get_hop(const relay_t *relay);
+
+#endif  // RELAY_H
@@ -0,0 +1,90 @@
+/***************************************************************************//**
+ * @file resend_set.c
+ * @brief Packets waiting to be resent, merged across retransmission requests
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "resend_set.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RESEND_SET_MASK (RETRANSMISSION_BUFFER_DEFAULT_LENGTH - 1)
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+///Pending flag and sequence number, at the same position as in the retransmission buffer
+static bool pending[RETRANSMISSION_BUFFER_DEFAULT_LENGTH];
+static pkt_seq_t pendingSeq[RETRANSMISSION_BUFFER_DEFAULT_LENGTH];
+
+///Pending sequence numbers in request order, a stored packet can only be in once
+static pkt_seq_t order[RETRANSMISSION_BUFFER_DEFAULT_LENGTH];
+static uint32_t count;
+
+static resend_set_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void resend_set_init(void)
+{
+  for (uint32_t i = 0; i < RETRANSMISSION_BUFFER_DEFAULT_LENGTH; i++) {
+    pending[i] = false;
+  }
+  count = 0;
+}
+
+void resend_set_add(pkt_pool_index_t index, void *context)
+{
+  pkt_seq_t pktSeq = pkt_pool_get(index)->header.pktSeq;
+  uint32_t slot = pktSeq & RESEND_SET_MASK;
+  (void)context;
+
+  if (pending[slot] && pendingSeq[slot] == pktSeq) {
+    stats.duplicates++;
+    return;
+  }
+  //A packet pending in the same slot may have been overwritten by this one, it stays
+  //in the order list until the flush skips it, so the list can run full
+  if (count == RETRANSMISSION_BUFFER_DEFAULT_LENGTH) {
+    stats.expired++;
+    return;
+  }
+  pending[slot] = true;
+  pendingSeq[slot] = pktSeq;
+  order[count++] = pktSeq;
+  stats.added++;
+}
+
+bool resend_set_is_empty(void)
+{
+  return count == 0;
+}
+
+uint32_t resend_set_flush(retransmission_buffer_cb_t callback, void *context)
+{
+  uint32_t visited = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    pkt_pool_index_t index = retransmission_buffer_lookup(order[i]);
+    pending[order[i] & RESEND_SET_MASK] = false;
+    if (index == PKT_POOL_INVALID_INDEX) {
+      stats.expired++;
+      continue;
+    }
+    callback(index, context);
+    visited++;
+  }
+  count = 0;
+  stats.flushes++;
+  stats.resent += visited;
+  return visited;
+}
+
+const resend_set_stats_t *resend_set_get_stats(void)
+{
+  return &stats;
+}
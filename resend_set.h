@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file resend_set.h
+ * @brief Packets waiting to be resent, merged across retransmission requests
+ *
+ * Only the receiver task uses the set, no locking is done.
+ ******************************************************************************/
+#ifndef RESEND_SET_H
+#define RESEND_SET_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "pkt.h"
+#include "retransmission_buffer.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint32_t added;      //Packets put in the set
+  uint32_t duplicates; //Packets already pending when requested again
+  uint32_t flushes;
+  uint32_t resent;     //Packets handed to the flush callback
+  uint32_t expired;    //Pending packets overwritten in the retransmission buffer before the flush
+} resend_set_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the set.
+ *****************************************************************************/
+void resend_set_init(void);
+
+/**************************************************************************//**
+ * Marks a stored packet for resending.
+ *
+ * Has the retransmission_buffer_cb_t signature, so it can be passed straight
+ * to the retransmission buffer visitors.
+ *
+ * @param index Pool slot of a packet in the retransmission buffer
+ * @param context Unused
+ *****************************************************************************/
+void resend_set_add(pkt_pool_index_t index, void *context);
+
+/**************************************************************************//**
+ * Tells whether packets are pending.
+ *
+ * @returns true if the set is empty
+ *****************************************************************************/
+bool resend_set_is_empty(void);
+
+/**************************************************************************//**
+ * Visits the pending packets in the order they were first requested and
+ * empties the set.
+ *
+ * @param callback Called for every pending packet still stored
+ * @param context Passed through to the callback
+ * @returns Number of packets visited
+ *****************************************************************************/
+uint32_t resend_set_flush(retransmission_buffer_cb_t callback, void *context);
+
+/**************************************************************************//**
+ * Gives access to the counters.
+ *
+ * @returns Pointer to the counters
+ *****************************************************************************/
+const resend_set_stats_t *resend_set_get_stats(void);
+
+#endif  // RESEND_SET_H
@@ -0,0 +1,123 @@
+/***************************************************************************//**
+ * @file retransmission_buffer.c
+ * @brief Ring of the last generated data packets, indexed by sequence number
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "retransmission_buffer.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RETRANSMISSION_BUFFER_MASK (RETRANSMISSION_BUFFER_DEFAULT_LENGTH - 1)
+
+typedef struct
+{
+  pkt_seq_t pktSeq;
+  pkt_pool_index_t index;
+} retransmission_slot_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static retransmission_slot_t slots[RETRANSMISSION_BUFFER_DEFAULT_LENGTH];
+
+///Sequence number of the last inserted packet
+static pkt_seq_t newestSeq;
+static bool empty = true;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void retransmission_buffer_init(void)
+{
+  for (uint32_t i = 0; i < RETRANSMISSION_BUFFER_DEFAULT_LENGTH; i++) {
+    slots[i].index = PKT_POOL_INVALID_INDEX;
+  }
+  empty = true;
+}
+
+void retransmission_buffer_insert(pkt_pool_index_t index)
+{
+  pkt_seq_t pktSeq = pkt_pool_get(index)->header.pktSeq;
+  retransmission_slot_t *slot = &slots[pktSeq & RETRANSMISSION_BUFFER_MASK];
+
+  pkt_pool_index_t evicted;
+
+  pkt_pool_ref(index);
+
+  //The receiver task may look the slot up in between
+  taskENTER_CRITICAL();
+  evicted = slot->index;
+  slot->pktSeq = pktSeq;
+  slot->index = index;
+  newestSeq = pktSeq;
+  empty = false;
+  taskEXIT_CRITICAL();
+
+  if (evicted != PKT_POOL_INVALID_INDEX) {
+    pkt_pool_unref(evicted);
+  }
+}
+
+pkt_pool_index_t retransmission_buffer_lookup(pkt_seq_t pktSeq)
+{
+  const retransmission_slot_t *slot = &slots[pktSeq & RETRANSMISSION_BUFFER_MASK];
+
+  if (slot->pktSeq != pktSeq) {
+    return PKT_POOL_INVALID_INDEX;
+  }
+  return slot->index;
+}
+
+uint32_t retransmission_buffer_for_each_from(pkt_seq_t pktSeq,
+                                             retransmission_buffer_cb_t callback,
+                                             void *context)
+{
+  //Distance in sequence space, negative if pktSeq is newer than anything we sent
+  int32_t span = pkt_seq_diff(newestSeq, pktSeq);
+  uint32_t visited = 0;
+
+  if (empty || span < 0 || span > RETRANSMISSION_BUFFER_MASK) {
+    return 0;
+  }
+  for (int32_t i = 0; i <= span; i++) {
+    pkt_pool_index_t index = retransmission_buffer_lookup(pkt_seq_add(pktSeq, i));
+    if (index != PKT_POOL_INVALID_INDEX) {
+      callback(index, context);
+      visited++;
+    }
+  }
+  return visited;
+}
+
+uint32_t retransmission_buffer_for_each_in_bitmap(pkt_seq_t pktSeq,
+                                                  const uint8_t *lost,
+                                                  uint32_t bits,
+                                                  retransmission_buffer_cb_t callback,
+                                                  void *context)
+{
+  pkt_pool_index_t index = retransmission_buffer_lookup(pktSeq);
+  uint32_t visited = 0;
+
+  if (index != PKT_POOL_INVALID_INDEX) {
+    callback(index, context);
+    visited++;
+  }
+  for (uint32_t i = 0; i < bits; i++) {
+    if ((lost[i / 8] & (1u << (i % 8))) == 0) {
+      continue;
+    }
+    index = retransmission_buffer_lookup(pkt_seq_add(pktSeq, 1 + i));
+    if (index != PKT_POOL_INVALID_INDEX) {
+      callback(index, context);
+      visited++;
+    }
+  }
+  return visited;
+}
@@ -0,0 +1,94 @@
+/***************************************************************************//**
+ * @file retransmission_buffer.h
+ * @brief Ring of the last generated data packets, indexed by sequence number
+ ******************************************************************************/
+#ifndef RETRANSMISSION_BUFFER_H
+#define RETRANSMISSION_BUFFER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "pkt.h"
+#include "pkt_pool.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (RETRANSMISSION_BUFFER_DEFAULT_LENGTH < 2) \
+  || (RETRANSMISSION_BUFFER_DEFAULT_LENGTH & (RETRANSMISSION_BUFFER_DEFAULT_LENGTH - 1))
+#error "RETRANSMISSION_BUFFER_DEFAULT_LENGTH must be a power of two"
+#endif
+
+#if (RETRANSMISSION_BUFFER_DEFAULT_LENGTH - 1) > PKT_SEQ_MAX
+#error "RETRANSMISSION_BUFFER_DEFAULT_LENGTH exceeds the packet sequence space"
+#endif
+
+/// Called once per stored packet by retransmission_buffer_for_each_from() and
+/// retransmission_buffer_for_each_in_bitmap()
+typedef void (*retransmission_buffer_cb_t)(pkt_pool_index_t index, void *context);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the buffer, must be called before any reference is stored.
+ *****************************************************************************/
+void retransmission_buffer_init(void);
+
+/**************************************************************************//**
+ * Stores a data packet in the slot selected by its sequence number.
+ *
+ * @param index Pool slot of the packet to store, the buffer takes its own
+ *              reference and drops the one of the packet that was
+ *              RETRANSMISSION_BUFFER_DEFAULT_LENGTH sequence numbers older
+ *
+ * Sequence numbers are expected to be increasing, the last inserted packet
+ * is the newest one.
+ *****************************************************************************/
+void retransmission_buffer_insert(pkt_pool_index_t index);
+
+/**************************************************************************//**
+ * Looks a packet up by sequence number.
+ *
+ * @param pktSeq Sequence number of the packet
+ * @returns Pool slot of the stored packet, PKT_POOL_INVALID_INDEX if it's not
+ *          (or no longer) stored. No reference is added for the caller.
+ *****************************************************************************/
+pkt_pool_index_t retransmission_buffer_lookup(pkt_seq_t pktSeq);
+
+/**************************************************************************//**
+ * Visits the stored packets from pktSeq up to the newest one, in order.
+ *
+ * @param pktSeq First sequence number to visit
+ * @param callback Called for every stored packet in the range
+ * @param context Passed through to the callback
+ * @returns Number of packets visited
+ *
+ * Sequence numbers that have already been overwritten are skipped.
+ *****************************************************************************/
+uint32_t retransmission_buffer_for_each_from(pkt_seq_t pktSeq,
+                                             retransmission_buffer_cb_t callback,
+                                             void *context);
+
+/**************************************************************************//**
+ * Visits pktSeq and the stored packets marked in a loss bitmap, in order.
+ *
+ * @param pktSeq First sequence number to visit
+ * @param lost Bitmap, bit i (lost[i / 8] & (1 << (i % 8))) selects pktSeq + 1 + i
+ * @param bits Number of valid bits in lost
+ * @param callback Called for every stored packet selected
+ * @param context Passed through to the callback
+ * @returns Number of packets visited
+ *
+ * Sequence numbers that have already been overwritten are skipped.
+ *****************************************************************************/
+uint32_t retransmission_buffer_for_each_in_bitmap(pkt_seq_t pktSeq,
+                                                  const uint8_t *lost,
+                                                  uint32_t bits,
+                                                  retransmission_buffer_cb_t callback,
+                                                  void *context);
+
+#endif  // RETRANSMISSION_BUFFER_H
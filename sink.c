@@ -0,0 +1,521 @@
+/***************************************************************************//**
+ * @file sink.c
+ * @brief Sink side of the flood protocol
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "pkt_agg.h"
+#include "pkt_fec.h"
+#include "pkt_pool.h"
+#include "resend_set.h"
+#include "retransmission_buffer.h"
+#include "sink.h"
+#include "tx_scheduler.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define AIRTIME_US(channel, frameLength)                                  \
+  ((((uint32_t)(frameLength) * 8 + SINK_FRAME_OVERHEAD_BITS) * 1000000UL) \
+   / (((channel) == SINK_CHANNEL_WUP) ? SINK_WUP_BITRATE : SINK_DATA_BITRATE))
+
+/// Packets and bytes in one transmitted frame
+#if TX_AGGREGATION_ENABLE
+#define FRAME_PACKETS_MAX PKT_AGG_RECORDS_MAX
+#define FRAME_MAX_LENGTH TX_AGGREGATION_FRAME_LENGTH
+#else
+#define FRAME_PACKETS_MAX 1
+#define FRAME_MAX_LENGTH PKT_FRAME_MAX_LENGTH
+#endif
+
+#if TX_AGGREGATION_ENABLE && (PKT_WIRE_VERSION != PKT_VERSION_2)
+#error "TX_AGGREGATION_ENABLE needs v2 frames"
+#endif
+#if TX_AGGREGATION_ENABLE && (TX_AGGREGATION_FRAME_LENGTH < PKT_FRAME_MAX_LENGTH)
+#error "TX_AGGREGATION_FRAME_LENGTH can't hold the longest data packet"
+#endif
+
+typedef enum
+{
+  TX_STATE_IDLE,  //Waiting for a packet in the queue
+  TX_STATE_WUP,   //WUP frame started on the sub GHz channel
+  TX_STATE_GAP,   //Waiting for the relays to wake up, on the timer
+  TX_STATE_DATA   //Data frame started, or scheduled, on the 2.4 GHz channel
+} tx_state_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void startTx(void);
+static void countSent(uint32_t sentUs);
+static void finish(bool sent);
+static bool continueBurst(void);
+static bool take(TickType_t timeout);
+static void release(bool sent);
+#if FEC_ENABLE
+static void sendParity(void);
+#endif
+static void serveRequest(const pkt_t *packet);
+static void enqueue(pkt_pool_index_t index, tx_class_t txClass);
+static void retransmit(pkt_pool_index_t index, void *context);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const sink_ops_t *ops;
+static void *opsContext;
+
+static const uint8_t hopCount = 0;
+static pkt_seq_t pktSequenceNumber;
+
+#if FEC_ENABLE
+///Parity of the data packets generated so far in the current FEC block
+static pkt_fec_encoder_t fecEncoder;
+#endif
+
+///Transmitter state machine, the state is read by sink_tx_is_idle() from any context
+static volatile tx_state_t txState;
+static pkt_pool_index_t txIndices[FRAME_PACKETS_MAX];
+static uint32_t txCount;  //Packets in txIndices
+static uint8_t txFrame[FRAME_MAX_LENGTH];
+static uint16_t txFrameLength;
+static uint32_t txAttempts;
+static uint32_t txBurstLength;  //Data frames sent since the WUP
+static uint32_t wupEndUs;
+
+static sink_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sink_init(const sink_ops_t *sinkOps, void *context)
+{
+  ops = sinkOps;
+  opsContext = context;
+  pktSequenceNumber = 1;
+  txState = TX_STATE_IDLE;
+  txCount = 0;
+  memset(&stats, 0, sizeof(stats));
+
+  pkt_pool_init();
+  retransmission_buffer_init();
+  resend_set_init();
+  tx_scheduler_init();
+#if FEC_ENABLE
+  pkt_fec_encoder_reset(&fecEncoder);
+#endif
+}
+
+bool sink_generate(uint8_t payloadLength, pkt_seq_t *pktSeq)
+{
+  pkt_pool_index_t index;
+  pkt_t *packet;
+
+  //Every slot is held by the queue or the retransmission buffer, skip this round
+  index = pkt_pool_alloc(PKT_CLASS_DATA);
+  if (index == PKT_POOL_INVALID_INDEX) {
+    return false;
+  }
+  packet = pkt_pool_get(index);
+  packet->header.pktSeq = pktSequenceNumber;
+  packet->header.wupSeq = Wd;
+  packet->header.hopCount = hopCount + 1;
+  packet->header.length = payloadLength;
+
+  retransmission_buffer_insert(index);
+  stats.generated++;
+  if (pktSeq != NULL) {
+    *pktSeq = pktSequenceNumber;
+  }
+  pktSequenceNumber = pkt_seq_add(pktSequenceNumber, 1);
+
+#if FEC_ENABLE
+  //Parity is computed over the packet before the queue owns it
+  bool blockComplete = pkt_fec_encoder_add(&fecEncoder, packet);
+#endif
+
+  enqueue(index, TX_CLASS_DATA);
+
+#if FEC_ENABLE
+  if (blockComplete) {
+    sendParity();
+  }
+#endif
+  return true;
+}
+
+void sink_send_beacon(void)
+{
+  pkt_pool_index_t index = pkt_pool_alloc(PKT_CLASS_CONTROL);
+  pkt_t *packet;
+
+  //Header only
+  if (index != PKT_POOL_INVALID_INDEX) {
+    packet = pkt_pool_get(index);
+    packet->header.hopCount = hopCount;
+    packet->header.pktSeq = 0;
+    packet->header.wupSeq = Wb;
+    enqueue(index, TX_CLASS_BEACON);
+  }
+}
+
+bool sink_tx_start(TickType_t timeout)
+{
+  if (txState != TX_STATE_IDLE || !take(timeout)) {
+    return false;
+  }
+  if (ops->tx_begin != NULL) {
+    ops->tx_begin(opsContext);
+  }
+  //The WUP is the actual packet, sent on the sub GHz channel
+  txState = TX_STATE_WUP;
+  txAttempts = 0;
+  txBurstLength = 0;
+  startTx();
+  return true;
+}
+
+bool sink_tx_is_idle(void)
+{
+  return txState == TX_STATE_IDLE;
+}
+
+void sink_tx_done(uint32_t sentUs)
+{
+  if (txState != TX_STATE_WUP && txState != TX_STATE_DATA) {
+    return;
+  }
+  countSent(sentUs);
+  if (txState == TX_STATE_WUP) {
+    //Give the relays time to wake up, we are still in their rx window
+    wupEndUs = sentUs;
+#if TX_SCHEDULED_DATA_ENABLE
+    txState = TX_STATE_DATA;
+    txAttempts = 0;
+    startTx();
+#else
+    txState = TX_STATE_GAP;
+    ops->start_timer(opsContext, SINK_TX_WUP_DATA_GAP_MS);
+#endif
+    return;
+  }
+  if (!continueBurst()) {
+    finish(true);
+  }
+}
+
+void sink_tx_failed(uint32_t failures)
+{
+  if (txState != TX_STATE_WUP && txState != TX_STATE_DATA) {
+    return;
+  }
+  if (failures & SINK_TX_ABORTED) {
+    stats.tx.aborted++;
+  }
+  if (failures & SINK_TX_BLOCKED) {
+    stats.tx.blocked++;
+  }
+  if (failures & SINK_TX_CHANNEL_BUSY) {
+    stats.tx.channelBusy++;
+  }
+  ops->start_timer(opsContext, SINK_TX_RETRY_DELAY_MS);
+}
+
+void sink_tx_missed(void)
+{
+  if (txState != TX_STATE_DATA) {
+    return;
+  }
+  //Woken up too late for the scheduled time, the gap is over already
+  stats.tx.scheduleMissed++;
+  startTx();
+}
+
+void sink_tx_timer(void)
+{
+  switch (txState) {
+    case TX_STATE_WUP:
+    case TX_STATE_DATA:
+      //Retry delay elapsed
+      startTx();
+      break;
+    case TX_STATE_GAP:
+      //Send the actual flood data packet
+      txState = TX_STATE_DATA;
+      txAttempts = 0;
+      startTx();
+      break;
+    default:
+      break;
+  }
+}
+
+uint32_t sink_decode_frame(const uint8_t *frame, uint16_t length, sink_packet_t *packets,
+                           uint32_t capacity)
+{
+  pkt_agg_reader_t reader;
+  uint32_t count = 0;
+  uint8_t version;
+
+  //Plain frames come out as a single packet
+  pkt_agg_reader_init(&reader, frame, length);
+  while (count < capacity
+         && (version = pkt_agg_reader_next(&reader, (pkt_t *)&packets[count], sizeof(packets[count].payload))) != 0) {
+    if (version == PKT_VERSION_1) {
+      //Legacy frames only carry the low bits, place them next to what we are sending
+      packets[count].header.pktSeq = pkt_seq_extend(pktSequenceNumber, packets[count].header.pktSeq, PKT_V1_SEQ_BITS);
+    }
+    count++;
+  }
+  return count;
+}
+
+void sink_handle_packet(const pkt_t *packet)
+{
+  if (packet->header.wupSeq == Wr) {
+    if (packet->header.hopCount == hopCount) {
+      //A relay is missing data, beacon again soon
+      ops->hear(opsContext, false);
+      if (ops->request_heard != NULL) {
+        ops->request_heard(opsContext, packet);
+      }
+      serveRequest(packet);
+    }
+  } else if (packet->header.hopCount == hopCount + 1) {
+    //A neighbour relaying our beacon or data, it agrees with us
+    ops->hear(opsContext, true);
+  } else if (packet->header.hopCount <= hopCount) {
+    //Someone claims to be as close to the sink as we are
+    ops->hear(opsContext, false);
+  }
+}
+
+void sink_flush_requests(void)
+{
+  resend_set_flush(retransmit, NULL);
+}
+
+const sink_stats_t *sink_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Encodes the frame again on every attempt, the burst may have changed it
+void startTx(void)
+{
+  uint16_t channel = (txState == TX_STATE_WUP) ? SINK_CHANNEL_WUP : SINK_CHANNEL_DATA;
+#if TX_AGGREGATION_ENABLE
+  const pkt_t *packets[FRAME_PACKETS_MAX];
+
+  for (uint32_t i = 0; i < txCount; i++) {
+    packets[i] = pkt_pool_get(txIndices[i]);
+  }
+  txFrameLength = pkt_agg_encode(packets, txCount, txFrame, sizeof(txFrame));
+#else
+  txFrameLength = pkt_encode(pkt_pool_get(txIndices[0]), PKT_WIRE_VERSION, txFrame);
+#endif
+  if (txAttempts++ == SINK_TX_MAX_ATTEMPTS || txFrameLength == 0) {
+    stats.tx.dropped++;
+    finish(false);
+    return;
+  }
+#if TX_SCHEDULED_DATA_ENABLE
+  if (txState == TX_STATE_DATA && txAttempts == 1 && txBurstLength == 0) {
+    //First attempt of the first data frame, let the radio time it from the WUP end
+    uint32_t atUs = wupEndUs + TX_WUP_DATA_GAP_US;
+
+    if (ops->start_tx(opsContext, channel, txFrame, txFrameLength, &atUs)) {
+      return;
+    }
+    //The scheduled time can't be met anymore, fall back to an immediate start
+    stats.tx.scheduleMissed++;
+  }
+#endif
+  if (!ops->start_tx(opsContext, channel, txFrame, txFrameLength, NULL)) {
+    //Radio busy (e.g. receiving), try again later instead of spinning
+    stats.tx.startFailures++;
+    ops->start_timer(opsContext, SINK_TX_RETRY_DELAY_MS);
+  }
+}
+
+void countSent(uint32_t sentUs)
+{
+  uint16_t channel = (txState == TX_STATE_WUP) ? SINK_CHANNEL_WUP : SINK_CHANNEL_DATA;
+  sink_airtime_stats_t *airtime =
+    &stats.airtime[(txCount > 1) ? SINK_AIRTIME_AGGREGATE : pkt_pool_get(txIndices[0])->header.wupSeq];
+
+  airtime->frames++;
+  airtime->bytes += txFrameLength;
+  airtime->airtimeUs += AIRTIME_US(channel, txFrameLength);
+  if (txState == TX_STATE_WUP) {
+    stats.goodput.airtimeUs += AIRTIME_US(SINK_CHANNEL_WUP, txFrameLength);
+    return;
+  }
+  stats.tx.sent++;
+  stats.goodput.frames++;
+  stats.goodput.airtimeUs += AIRTIME_US(SINK_CHANNEL_DATA, txFrameLength);
+  for (uint32_t i = 0; i < txCount; i++) {
+    uint8_t length = pkt_pool_get(txIndices[i])->header.length;
+    uint16_t singleLength = (PKT_WIRE_VERSION == PKT_VERSION_1) ? PKT_V1_FRAME_LENGTH : PKT_V2_FRAME_LENGTH(length);
+
+    stats.goodput.packets++;
+    stats.goodput.payloadBytes += length;
+    stats.goodput.singleAirtimeUs += AIRTIME_US(SINK_CHANNEL_WUP, singleLength)
+                                     + AIRTIME_US(SINK_CHANNEL_DATA, singleLength);
+  }
+  if (txBurstLength++ == 0) {
+    stats.tx.lastGapUs = sentUs - wupEndUs;
+  }
+  if (txBurstLength > stats.tx.longestBurst) {
+    stats.tx.longestBurst = txBurstLength;
+  }
+}
+
+///sent tells whether the data frame went out or the packets were given up on
+void finish(bool sent)
+{
+  release(sent);
+  txState = TX_STATE_IDLE;
+  ops->tx_end(opsContext, sent);
+}
+
+///Called once a data frame is sent: the relays woken up by the WUP are still listening, so a packet
+///already queued goes out right away, without a WUP of its own
+bool continueBurst(void)
+{
+  if (txBurstLength >= TX_BURST_MAX_LENGTH
+      || (uint32_t)(ops->now_us(opsContext) - wupEndUs) > TX_BURST_WINDOW_US
+      || tx_scheduler_count() == 0) {
+    return false;
+  }
+  release(true);
+  if (!take(0)) {
+    return false;
+  }
+  txAttempts = 0;
+  stats.tx.burstFrames++;
+  startTx();
+  return true;
+}
+
+///Takes the packets of the next frame out of the tx_scheduler queues
+bool take(TickType_t timeout)
+{
+  if (!tx_scheduler_dequeue(&txIndices[0], timeout)) {
+    return false;
+  }
+  txCount = 1;
+#if TX_AGGREGATION_ENABLE
+  //Packets queued behind the first one join its frame while they fit
+  uint32_t frameLength = PKT_AGG_HEADER_LENGTH + PKT_V2_FRAME_LENGTH(pkt_pool_get(txIndices[0])->header.length);
+  while (txCount < FRAME_PACKETS_MAX
+         && frameLength + PKT_V2_FRAME_LENGTH(0) <= TX_AGGREGATION_FRAME_LENGTH
+         && tx_scheduler_dequeue_fitting(&txIndices[txCount],
+                                         TX_AGGREGATION_FRAME_LENGTH - frameLength - PKT_V2_FRAME_LENGTH(0))) {
+    frameLength += PKT_V2_FRAME_LENGTH(pkt_pool_get(txIndices[txCount])->header.length);
+    txCount++;
+  }
+#endif
+  return true;
+}
+
+///Only packets whose data frame went out are passed to packet_sent, dropped ones are counted in the stats
+void release(bool sent)
+{
+  for (uint32_t i = 0; i < txCount; i++) {
+    if (sent && ops->packet_sent != NULL) {
+      ops->packet_sent(opsContext, pkt_pool_get(txIndices[i]));
+    }
+    pkt_pool_unref(txIndices[i]);
+  }
+  txCount = 0;
+}
+
+#if FEC_ENABLE
+///Queues the parity packets of the completed FEC block, right behind its last data packet
+void sendParity(void)
+{
+  pkt_pool_index_t index;
+  pkt_t *packet;
+
+  for (uint32_t group = 0; group < FEC_PARITY_COUNT; group++) {
+    index = pkt_pool_alloc(PKT_CLASS_DATA);
+    if (index == PKT_POOL_INVALID_INDEX) {
+      stats.parityDropped++;
+      continue;
+    }
+    packet = pkt_pool_get(index);
+    pkt_fec_encoder_build(&fecEncoder, group, packet);
+    packet->header.hopCount = hopCount + 1;
+    enqueue(index, TX_CLASS_DATA);
+  }
+  pkt_fec_encoder_reset(&fecEncoder);
+}
+#endif
+
+void serveRequest(const pkt_t *packet)
+{
+  pkt_wr_bitmap_t request;
+  bool selective = false;
+  bool windowOpen = !resend_set_is_empty();
+
+  //Header only requests are legacy ones
+  if (packet->header.length >= sizeof(request)) {
+    memcpy(&request, packet->payload, sizeof(request));
+    selective = request.marker == PKT_WR_BITMAP_MARKER && request.bits <= PKT_WR_BITMAP_BITS;
+  }
+  if (selective) {
+    //Resend only the packets the relay marked as lost
+    stats.wr.selective++;
+    stats.wr.requested++;
+    for (uint32_t i = 0; i < request.bits; i++) {
+      if (request.lost[i / 8] & (1u << (i % 8))) {
+        stats.wr.requested++;
+      }
+    }
+    retransmission_buffer_for_each_in_bitmap(packet->header.pktSeq, request.lost, request.bits,
+                                             resend_set_add, NULL);
+  } else {
+    //Legacy request: resend the requested packet and every newer one we still have
+    stats.wr.legacy++;
+    stats.wr.requested++;
+    if (retransmission_buffer_lookup(packet->header.pktSeq) != PKT_POOL_INVALID_INDEX) {
+      retransmission_buffer_for_each_from(packet->header.pktSeq, resend_set_add, NULL);
+    }
+  }
+
+  if (RETRANSMISSION_COALESCE_MS == 0) {
+    resend_set_flush(retransmit, NULL);
+  } else if (!windowOpen && !resend_set_is_empty()) {
+    //First request of a window, the other relays' ones merge into it until the timer fires
+    ops->start_coalesce_timer(opsContext, RETRANSMISSION_COALESCE_MS);
+  }
+}
+
+void enqueue(pkt_pool_index_t index, tx_class_t txClass)
+{
+  //The queue owns the reference from now on, the transmitter drops it once sent.
+  //A full queue is counted in the tx_scheduler stats of the class.
+  if (!tx_scheduler_enqueue(txClass, index)) {
+    pkt_pool_unref(index);
+    return;
+  }
+  if (ops->packet_queued != NULL) {
+    ops->packet_queued(opsContext);
+  }
+}
+
+///Retransmission buffer visitor, queues a stored packet for transmission
+void retransmit(pkt_pool_index_t index, void *context)
+{
+  (void)context;
+  pkt_pool_ref(index);
+  enqueue(index, TX_CLASS_RETRANSMISSION);
+}
@@ -0,0 +1,248 @@
+/***************************************************************************//**
+ * @file sink.h
+ * @brief Sink side of the flood protocol
+ *
+ * The sink generates the data packets and the beacons and sends them as
+ * relay.h expects: every frame goes out twice, a WUP on the sub GHz channel to
+ * wake the relays up with RFSense and, TX_WUP_DATA_GAP_US after the WUP end,
+ * the same frame on the 2.4 GHz channel. Packets queued by then follow the
+ * data frame back to back, up to TX_BURST_MAX_LENGTH of them, while the
+ * relays are still in the RX window the WUP opened. The Wr of the relays one
+ * hop away are answered from the retransmission buffer, the requests of a
+ * RETRANSMISSION_COALESCE_MS window merged in the resend set.
+ *
+ * The module keeps the protocol state and drives the firmware modules it
+ * builds on: pkt_pool, retransmission_buffer, resend_set, tx_scheduler and
+ * pkt_fec. The caller owns the radio, the timers and the beacon Trickle
+ * timer, through the operations given to sink_init(), and calls back in when
+ * they complete:
+ *
+ * - sink_tx_done() or sink_tx_failed() after every start_tx that returned
+ *   true, sink_tx_missed() if a scheduled start was missed,
+ * - sink_tx_timer() when the timer of start_timer expires,
+ * - sink_flush_requests() when the window of start_coalesce_timer is over.
+ *
+ * The transmitter calls (sink_tx_*) come from one context, the receiver
+ * calls (sink_decode_frame(), sink_handle_packet(), sink_flush_requests())
+ * from one context, sink_generate() from one context and sink_send_beacon()
+ * from any: they only meet in the thread safe tx_scheduler queues.
+ ******************************************************************************/
+#ifndef SINK_H
+#define SINK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "pkt.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Radio channels, see Protocol_Configuration_channels
+#define SINK_CHANNEL_DATA 0
+#define SINK_CHANNEL_WUP  1
+
+/// Channel bitrates and the on air overhead of every frame: 40 bit preamble,
+/// 16 bit syncword and 16 bit CRC
+#define SINK_DATA_BITRATE         250000
+#define SINK_WUP_BITRATE          50000
+#define SINK_FRAME_OVERHEAD_BITS  (40 + 16 + 16)
+
+/// Beacon intervals that run before the packet generation starts
+#define SINK_STARTUP_BEACON_INTERVALS 3
+
+/// Transmitter timings, the WUP to data gap is set in flood_config.h
+#define SINK_TX_WUP_DATA_GAP_MS ((TX_WUP_DATA_GAP_US + 999) / 1000)
+#define SINK_TX_RETRY_DELAY_MS  5
+#define SINK_TX_MAX_ATTEMPTS    10
+
+/// Reasons of a failed transmission, see sink_tx_failed()
+#define SINK_TX_ABORTED       (1UL << 0)
+#define SINK_TX_BLOCKED       (1UL << 1)
+#define SINK_TX_CHANNEL_BUSY  (1UL << 2)
+
+/// Airtime counters of the aggregate frames, next to the ones of each wupSeq
+#define SINK_AIRTIME_AGGREGATE (Wp + 1)
+
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) sink_packet_t;
+
+/// Platform side of the sink, all of them but tx_begin, packet_queued,
+/// packet_sent and request_heard must be set
+typedef struct
+{
+  /// Starts a frame, at the radio time *atUs if atUs isn't NULL. Returns
+  /// false if the radio refused it, or can't start it at *atUs anymore.
+  bool (*start_tx)(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                   const uint32_t *atUs);
+  /// Restarts the transmitter timer
+  void (*start_timer)(void *context, uint32_t ms);
+  /// Radio time [us], the time base of sink_tx_done() and of start_tx
+  uint32_t (*now_us)(void *context);
+  /// A frame was taken, the radio is busy until tx_end
+  void (*tx_begin)(void *context);
+  /// Its packets are released, sent tells whether the last data frame went
+  /// out. The transmitter timer and a pending start must not fire anymore.
+  void (*tx_end)(void *context, bool sent);
+  /// The tx_scheduler queues got a packet
+  void (*packet_queued)(void *context);
+  /// A packet whose data frame went out, before it's released
+  void (*packet_sent)(void *context, const pkt_t *packet);
+  /// Tells the beacon Trickle timer whether a packet heard agrees with us
+  void (*hear)(void *context, bool consistent);
+  /// A Wr from a relay one hop away, before it's served
+  void (*request_heard)(void *context, const pkt_t *packet);
+  /// Starts the coalescing window of the retransmission requests
+  void (*start_coalesce_timer)(void *context, uint32_t ms);
+} sink_ops_t;
+
+typedef struct
+{
+  uint32_t sent;
+  uint32_t startFailures;
+  uint32_t aborted;
+  uint32_t blocked;
+  uint32_t channelBusy;
+  uint32_t dropped;
+  uint32_t scheduleMissed;
+  uint32_t lastGapUs;     //WUP end to data preamble start of the last packet
+  uint32_t burstFrames;   //Data frames sent behind an earlier one, without a WUP of their own
+  uint32_t longestBurst;  //Most data frames sent after one WUP
+} sink_tx_stats_t;
+
+typedef struct
+{
+  uint32_t legacy;     //Wr asking for a packet and every newer one
+  uint32_t selective;  //Wr carrying a loss bitmap
+  uint32_t requested;  //Packets asked for (one per legacy Wr), resend_set resent / requested is the retransmission cost
+} sink_wr_stats_t;
+
+/// Frames sent of one type (wupSeq), WUP and data frames both count.
+/// Aggregate frames, whatever they carry, are counted under SINK_AIRTIME_AGGREGATE.
+typedef struct
+{
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t airtimeUs;
+} sink_airtime_stats_t;
+
+/// Data channel frames, goodput is payloadBytes * 1000000 / airtimeUs bytes per second of airtime, the WUP
+/// sent ahead of each burst included. singleAirtimeUs is the airtime the same packets take sent one per frame,
+/// each behind its own WUP, the goodput baseline.
+typedef struct
+{
+  uint32_t frames;
+  uint32_t packets;
+  uint32_t payloadBytes;
+  uint32_t airtimeUs;
+  uint32_t singleAirtimeUs;
+} sink_goodput_stats_t;
+
+typedef struct
+{
+  uint32_t generated;
+  uint32_t parityDropped;  //FEC parity packets that found no pool slot
+  sink_tx_stats_t tx;
+  sink_wr_stats_t wr;
+  sink_airtime_stats_t airtime[SINK_AIRTIME_AGGREGATE + 1];
+  sink_goodput_stats_t goodput;
+} sink_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets the sink and the modules it drives up, with nothing generated.
+ *
+ * @param ops Platform operations, kept
+ * @param context Passed through to the operations
+ *****************************************************************************/
+void sink_init(const sink_ops_t *ops, void *context);
+
+/**************************************************************************//**
+ * Generates a data packet, keeps it for retransmissions and queues it, and
+ * the parity packets of its FEC block if it completes one.
+ *
+ * @param payloadLength Payload bytes
+ * @param pktSeq Set to the sequence number of the packet, may be NULL
+ * @return false if no pool slot was free, nothing is generated then
+ *****************************************************************************/
+bool sink_generate(uint8_t payloadLength, pkt_seq_t *pktSeq);
+
+/**************************************************************************//**
+ * Queues a beacon, when the Trickle timer of the caller fires.
+ *****************************************************************************/
+void sink_send_beacon(void);
+
+/**************************************************************************//**
+ * Takes the next frame out of the tx_scheduler queues and starts its WUP.
+ *
+ * @param timeout Longest wait for a packet
+ * @return false if the transmitter is busy or no packet came
+ *****************************************************************************/
+bool sink_tx_start(TickType_t timeout);
+
+/**************************************************************************//**
+ * Tells whether the transmitter is waiting for a packet, from any context.
+ *****************************************************************************/
+bool sink_tx_is_idle(void);
+
+/**************************************************************************//**
+ * Advances the transmitter once the radio sent its frame.
+ *
+ * @param sentUs Radio time of the WUP end, or of the data preamble start
+ *****************************************************************************/
+void sink_tx_done(uint32_t sentUs);
+
+/**************************************************************************//**
+ * Retries the frame after SINK_TX_RETRY_DELAY_MS, up to
+ * SINK_TX_MAX_ATTEMPTS times.
+ *
+ * @param failures SINK_TX_ABORTED, SINK_TX_BLOCKED and SINK_TX_CHANNEL_BUSY
+ *                 bits, counted in the stats
+ *****************************************************************************/
+void sink_tx_failed(uint32_t failures);
+
+/**************************************************************************//**
+ * Starts the data frame right away, its scheduled time went by unnoticed.
+ *****************************************************************************/
+void sink_tx_missed(void);
+
+/**************************************************************************//**
+ * Advances the transmitter once the timer of start_timer expired.
+ *****************************************************************************/
+void sink_tx_timer(void);
+
+/**************************************************************************//**
+ * Splits a received frame, of any layout, into its packets. The sequence
+ * numbers of v1 packets are placed next to the ones the sink sends.
+ *
+ * @param frame Received frame
+ * @param length Bytes in frame
+ * @param packets Filled with the packets
+ * @param capacity Packets that fit in packets
+ * @return The packets decoded, 0 if the frame isn't valid
+ *****************************************************************************/
+uint32_t sink_decode_frame(const uint8_t *frame, uint16_t length, sink_packet_t *packets,
+                           uint32_t capacity);
+
+/**************************************************************************//**
+ * Handles a received packet: tells the beacon Trickle timer about it and
+ * serves the Wr of the relays one hop away.
+ *****************************************************************************/
+void sink_handle_packet(const pkt_t *packet);
+
+/**************************************************************************//**
+ * Queues every packet requested in the coalescing window, once.
+ *****************************************************************************/
+void sink_flush_requests(void);
+
+/**************************************************************************//**
+ * Gives the sink counters, updated in place.
+ *****************************************************************************/
+const sink_stats_t *sink_get_stats(void);
+
+#endif  // SINK_H
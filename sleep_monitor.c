@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file sleep_monitor.c
+ * @brief EM2 residency and kernel time drift under tickless idle
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+
+#include "sleep_monitor.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void emTransitionCallback(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static sleep_monitor_stats_t stats;
+
+///Sleeptimer ticks at init and at the last EM2 entry
+static uint64_t initTick;
+static uint32_t em2EnterTick;
+
+static sl_power_manager_em_transition_event_handle_t emTransitionHandle;
+static const sl_power_manager_em_transition_event_info_t emTransitionInfo = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM2,
+  .on_event = emTransitionCallback
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sleep_monitor_init(void)
+{
+  initTick = sl_sleeptimer_get_tick_count64();
+  sl_power_manager_subscribe_em_transition_event(&emTransitionHandle, &emTransitionInfo);
+}
+
+const sleep_monitor_stats_t *sleep_monitor_get_stats(void)
+{
+  uint64_t kernelMs = ((uint64_t)xTaskGetTickCount() * 1000u) / configTICK_RATE_HZ;
+  uint64_t uptimeMs;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64() - initTick, &uptimeMs);
+  stats.uptimeMs = uptimeMs;
+  stats.driftMs = (int32_t)(kernelMs - uptimeMs);
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+void emTransitionCallback(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+
+  if (to == SL_POWER_MANAGER_EM2) {
+    em2EnterTick = now;
+    stats.sleeps++;
+  } else if (from == SL_POWER_MANAGER_EM2) {
+    stats.lastSleepMs = sl_sleeptimer_tick_to_ms(now - em2EnterTick);
+    stats.totalSleepMs += stats.lastSleepMs;
+    if (stats.lastSleepMs > stats.longestSleepMs) {
+      stats.longestSleepMs = stats.lastSleepMs;
+    }
+  }
+}
@@ -0,0 +1,46 @@
+/***************************************************************************//**
+ * @file sleep_monitor.h
+ * @brief EM2 residency and kernel time drift under tickless idle
+ ******************************************************************************/
+#ifndef SLEEP_MONITOR_H
+#define SLEEP_MONITOR_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint32_t sleeps;         //EM2 entries
+  uint32_t lastSleepMs;    //Length of the last EM2 stretch
+  uint32_t longestSleepMs;
+  uint64_t totalSleepMs;
+  uint64_t uptimeMs;       //Sleeptimer time since init
+  int32_t driftMs;         //Kernel time minus sleeptimer time since init
+} sleep_monitor_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts tracking EM2 and takes the reference for the drift.
+ *
+ * Call it before starting the scheduler, the kernel time is 0 then.
+ *****************************************************************************/
+void sleep_monitor_init(void);
+
+/**************************************************************************//**
+ * Refreshes the uptime and drift and gives access to the counters.
+ *
+ * Must be called from a task. A drift that grows with the uptime means the
+ * tick compensation after a suppressed tick period is losing time.
+ *
+ * @returns Pointer to the counters
+ *****************************************************************************/
+const sleep_monitor_stats_t *sleep_monitor_get_stats(void);
+
+#endif  // SLEEP_MONITOR_H
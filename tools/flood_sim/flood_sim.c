@@ -0,0 +1,378 @@
+/***************************************************************************//**
+ * @file flood_sim.c
+ * @brief Discrete-event simulator of the flood, sink logic in virtual time
+ *
+ * Runs the sink of sim_sink.h and a tree of relays of sim_relay.h over the
+ * medium of sim_medium.h for a simulated duration, then prints the delivery
+ * latency of every relay, the retransmissions and the airtime per channel.
+ * A run only depends on its options and its seed.
+ *
+ * The relays form a tree of the given fanout around the sink: relay i
+ * (from 1) hangs off node (i - 1) / fanout, node 0 being the sink, and
+ * hears its parent, its children and, unless -S is given, its siblings.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flood_config.h"
+#include "pkt.h"
+#include "resend_set.h"
+#include "sink.h"
+#include "tx_scheduler.h"
+
+#include "sim_event.h"
+#include "sim_medium.h"
+#include "sim_relay.h"
+#include "sim_sink.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SINK_NODE 0
+
+///Generation times kept for the latency, far more than a packet can stay in flight
+#define GENERATED_RING_LENGTH 65536
+
+///Latency histogram, 1 ms buckets and one for anything longer
+#define LATENCY_BUCKETS 60000
+
+typedef struct
+{
+  uint32_t relays;
+  uint32_t fanout;
+  bool siblings;
+  uint64_t durationS;
+  uint64_t seed;
+  uint32_t lossPerMille;
+  uint32_t generationPeriodMs;
+  bool perNode;
+  sim_relay_config_t relay;
+} options_t;
+
+typedef struct
+{
+  uint32_t delivered;
+  uint64_t latencySumUs;
+  uint64_t latencyMaxUs;
+} latency_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint64_t generatedUs[GENERATED_RING_LENGTH];
+static latency_t *latencies;
+static uint32_t latencyHistogram[LATENCY_BUCKETS + 1];
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n relays] [-f fanout] [-S] [-t seconds] [-s seed] [-l loss] [-g period_ms]\n"
+          "          [-j jitter_ms] [-w wake_ms] [-q]\n"
+          "  -n relays     relays around the sink (default 100)\n"
+          "  -f fanout     children per node of the relay tree (default 3)\n"
+          "  -S            siblings don't hear each other\n"
+          "  -t seconds    simulated time (default 86400)\n"
+          "  -s seed       seed of the run (default 1)\n"
+          "  -l loss       random loss of every data channel link, per mille (default 50)\n"
+          "  -g period_ms  data generation period of the sink (default 1000)\n"
+          "  -j jitter_ms  longest random wait of a relay before it transmits (default 20)\n"
+          "  -w wake_ms    relay RX window after a wake up (default 1000)\n"
+          "  -q            per hop summary only, no per relay lines\n",
+          program);
+}
+
+static void packetGenerated(pkt_seq_t pktSeq)
+{
+  generatedUs[pktSeq % GENERATED_RING_LENGTH] = sim_event_now_us();
+}
+
+static void packetDelivered(uint32_t node, pkt_seq_t pktSeq)
+{
+  latency_t *latency = &latencies[node];
+  uint64_t us = sim_event_now_us() - generatedUs[pktSeq % GENERATED_RING_LENGTH];
+  uint64_t bucket = us / 1000;
+
+  latency->delivered++;
+  latency->latencySumUs += us;
+  if (us > latency->latencyMaxUs) {
+    latency->latencyMaxUs = us;
+  }
+  latencyHistogram[(bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS]++;
+}
+
+///Latency under which a share of the deliveries fall, in ms
+static uint32_t latencyPercentile(uint64_t deliveries, double share)
+{
+  uint64_t target = (uint64_t)(deliveries * share);
+  uint64_t count = 0;
+
+  if (deliveries == 0) {
+    return 0;
+  }
+  for (uint32_t bucket = 0; bucket <= LATENCY_BUCKETS; bucket++) {
+    count += latencyHistogram[bucket];
+    if (count > target) {
+      return bucket + 1;
+    }
+  }
+  return LATENCY_BUCKETS;
+}
+
+static double percent(uint64_t part, uint64_t whole)
+{
+  return (whole != 0) ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static void printSink(uint64_t durationUs)
+{
+  static const char *const classNames[TX_CLASS_COUNT] = { "beacon", "data", "retransmission" };
+  const sink_stats_t *sink = sink_get_stats();
+  const trickle_stats_t *trickle = sim_sink_get_trickle_stats();
+  const resend_set_stats_t *resend = resend_set_get_stats();
+  const sim_medium_node_stats_t *radio = sim_medium_get_node_stats(SINK_NODE);
+
+  printf("\nsink: %u packets generated, %u data frames sent (%u in bursts, longest burst %u), %u dropped\n",
+         sink->generated, sink->tx.sent, sink->tx.burstFrames, sink->tx.longestBurst, sink->tx.dropped);
+  printf("  Wr: %u legacy, %u selective, %u packets requested, %u resent, %u duplicates, %u expired\n",
+         sink->wr.legacy, sink->wr.selective, sink->wr.requested, resend->resent, resend->duplicates, resend->expired);
+  printf("  beacons: %u intervals, %u sent, %u suppressed, %u resets\n",
+         trickle->intervals, trickle->transmissions, trickle->suppressed, trickle->resets);
+  for (uint32_t c = 0; c < TX_CLASS_COUNT; c++) {
+    const tx_scheduler_stats_t *queue = tx_scheduler_get_stats((tx_class_t)c);
+    printf("  %-14s queue: %u sent, %u dropped, delay avg %.1f ms max %u ms\n", classNames[c],
+           queue->sent, queue->dropped, queue->sent ? (double)queue->totalDelayMs / queue->sent : 0.0,
+           queue->maxDelayMs);
+  }
+  printf("  airtime: %.1f s data (%.3f %%), %.1f s WUP (%.3f %%)\n",
+         radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_DATA] / 1e6, percent(radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_DATA], durationUs),
+         radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_WUP] / 1e6, percent(radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_WUP], durationUs));
+}
+
+static void printChannels(uint64_t durationUs)
+{
+  static const char *const channelNames[SIM_MEDIUM_CHANNEL_COUNT] = { "data (2.4 GHz)", "WUP (868 MHz)" };
+
+  printf("\nchannel         frames     airtime_s airtime_%%  received  collided      lost    missed\n");
+  for (uint16_t c = 0; c < SIM_MEDIUM_CHANNEL_COUNT; c++) {
+    const sim_medium_channel_stats_t *channel = sim_medium_get_channel_stats(c);
+    printf("%-14s %8u %12.1f %7.3f %10llu %9llu %9llu %9llu\n", channelNames[c], channel->frames,
+           channel->airtimeUs / 1e6, percent(channel->airtimeUs, durationUs),
+           (unsigned long long)channel->received, (unsigned long long)channel->collided,
+           (unsigned long long)channel->lost, (unsigned long long)channel->missed);
+  }
+}
+
+static void printRelays(const options_t *options, const sim_relay_t *relays, const uint8_t *hops,
+                        const uint32_t *parents, uint8_t maxHop)
+{
+  uint32_t generated = sink_get_stats()->generated;
+  uint64_t deliveries = 0;
+
+  printf("\nhop relays delivered_%% latency_avg_ms latency_max_ms   gaps  abandoned  wr_sent  resent\n");
+  for (uint8_t hop = 1; hop <= maxHop; hop++) {
+    uint64_t delivered = 0, latencySumUs = 0, latencyMaxUs = 0, gaps = 0, abandoned = 0, wrSent = 0, resent = 0;
+    uint32_t count = 0;
+
+    for (uint32_t r = 0; r < options->relays; r++) {
+      const latency_t *latency = &latencies[r + 1];
+      const relay_stats_t *stats = &relays[r].protocol.stats;
+      if (hops[r + 1] != hop) {
+        continue;
+      }
+      count++;
+      delivered += latency->delivered;
+      latencySumUs += latency->latencySumUs;
+      if (latency->latencyMaxUs > latencyMaxUs) {
+        latencyMaxUs = latency->latencyMaxUs;
+      }
+      gaps += stats->gaps;
+      abandoned += stats->abandoned;
+      wrSent += stats->wrSent;
+      resent += stats->resent;
+    }
+    deliveries += delivered;
+    printf("%3u %6u %11.2f %14.1f %14.1f %6llu %10llu %8llu %7llu\n", hop, count,
+           percent(delivered, (uint64_t)generated * count), delivered ? latencySumUs / 1e3 / delivered : 0.0,
+           latencyMaxUs / 1e3, (unsigned long long)gaps, (unsigned long long)abandoned,
+           (unsigned long long)wrSent, (unsigned long long)resent);
+  }
+  printf("latency over %llu deliveries: p50 %u ms, p95 %u ms, p99 %u ms\n", (unsigned long long)deliveries,
+         latencyPercentile(deliveries, 0.50), latencyPercentile(deliveries, 0.95), latencyPercentile(deliveries, 0.99));
+
+  if (!options->perNode) {
+    return;
+  }
+  printf("\nnode parent hop delivered_%% latency_avg_ms latency_max_ms dup  gaps recovered abandoned wr_sent wr_served"
+         " resent drops wakeups data_airtime_ms wup_airtime_ms\n");
+  for (uint32_t r = 0; r < options->relays; r++) {
+    const latency_t *latency = &latencies[r + 1];
+    const relay_stats_t *stats = &relays[r].protocol.stats;
+    const sim_medium_node_stats_t *radio = sim_medium_get_node_stats(r + 1);
+    printf("%4u %6u %3u %11.2f %14.1f %14.1f %3u %5u %9u %9u %7u %9u %6u %5u %7u %15.1f %14.1f\n",
+           r + 1, parents[r + 1], hops[r + 1], percent(latency->delivered, generated),
+           latency->delivered ? latency->latencySumUs / 1e3 / latency->delivered : 0.0,
+           latency->latencyMaxUs / 1e3, stats->duplicates, stats->gaps, stats->recovered, stats->abandoned,
+           stats->wrSent, stats->wrServed, stats->resent, relays[r].stats.queueDrops, relays[r].stats.wakeUps,
+           radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_DATA] / 1e3, radio->txAirtimeUs[SIM_MEDIUM_CHANNEL_WUP] / 1e3);
+  }
+}
+
+static double wallSeconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  options_t options = {
+    .relays = 100,
+    .fanout = 3,
+    .siblings = true,
+    .durationS = 86400,
+    .seed = 1,
+    .lossPerMille = 50,
+    .generationPeriodMs = 1000,
+    .perNode = true,
+    .relay = {
+      .forwardJitterMs = 20,
+      .wakeWindowMs = 1000,
+      .delivered = packetDelivered
+    }
+  };
+  sim_medium_config_t mediumConfig;
+  sim_sink_config_t sinkConfig;
+  sim_relay_t *relays;
+  uint8_t *hops;
+  uint32_t *parents;
+  uint32_t nodeCount;
+  uint8_t maxHop = 0;
+  uint64_t handled;
+  double started;
+  double elapsed;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:f:St:s:l:g:j:w:qh")) != -1) {
+    switch (opt) {
+      case 'n':
+        options.relays = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'f':
+        options.fanout = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'S':
+        options.siblings = false;
+        break;
+      case 't':
+        options.durationS = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        options.seed = strtoull(optarg, NULL, 0);
+        break;
+      case 'l':
+        options.lossPerMille = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'g':
+        options.generationPeriodMs = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'j':
+        options.relay.forwardJitterMs = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'w':
+        options.relay.wakeWindowMs = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'q':
+        options.perNode = false;
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (optind != argc || options.fanout == 0 || options.generationPeriodMs == 0 || options.lossPerMille > 1000) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  nodeCount = options.relays + 1;
+  relays = calloc(options.relays, sizeof(*relays));
+  hops = calloc(nodeCount, sizeof(*hops));
+  parents = calloc(nodeCount, sizeof(*parents));
+  latencies = calloc(nodeCount, sizeof(*latencies));
+  if ((options.relays > 0 && relays == NULL) || hops == NULL || parents == NULL || latencies == NULL) {
+    perror("flood_sim");
+    return EXIT_FAILURE;
+  }
+
+  sim_event_init();
+  mediumConfig = (sim_medium_config_t){
+    .channels = {
+      [SIM_MEDIUM_CHANNEL_DATA] = { SINK_DATA_BITRATE, SINK_FRAME_OVERHEAD_BITS, options.lossPerMille },
+      [SIM_MEDIUM_CHANNEL_WUP] = { SINK_WUP_BITRATE, SINK_FRAME_OVERHEAD_BITS, 0 }
+    },
+    .rfSenseTimeUs = RFSENSE_SENSE_TIME_US,
+    .seed = options.seed
+  };
+  sim_medium_init(nodeCount, &mediumConfig);
+
+  //Breadth first tree, a parent always comes before its children
+  for (uint32_t n = 1; n < nodeCount; n++) {
+    parents[n] = (n - 1) / options.fanout;
+    hops[n] = hops[parents[n]] + 1;
+    if (hops[n] > maxHop) {
+      maxHop = hops[n];
+    }
+    sim_medium_link(n, parents[n]);
+    if (options.siblings) {
+      for (uint32_t sibling = parents[n] * options.fanout + 1; sibling < n; sibling++) {
+        sim_medium_link(n, sibling);
+      }
+    }
+  }
+  if (maxHop + 1 > PKT_V2_HOP_COUNT_MAX) {
+    fprintf(stderr, "flood_sim: %u hops don't fit the hop count of the frames, raise the fanout\n", maxHop);
+    return EXIT_FAILURE;
+  }
+
+  sinkConfig = (sim_sink_config_t){
+    .generationPeriodMs = options.generationPeriodMs,
+    .payloadLength = 10,
+    .seed = (uint32_t)(options.seed * 2654435761u) | 1,
+    .generated = packetGenerated
+  };
+  sim_sink_init(SINK_NODE, &sinkConfig);
+  for (uint32_t r = 0; r < options.relays; r++) {
+    sim_relay_init(&relays[r], r + 1, options.seed, &options.relay);
+  }
+
+  started = wallSeconds();
+  handled = sim_event_run(options.durationS * 1000000ULL);
+  elapsed = wallSeconds() - started;
+
+  printf("flood_sim: %u relays, fanout %u, %u hops, %llu s simulated, seed %llu\n",
+         options.relays, options.fanout, maxHop, (unsigned long long)options.durationS,
+         (unsigned long long)options.seed);
+  printf("%llu events in %.2f s (%.0f events/s, %u pending at most)\n", (unsigned long long)handled, elapsed,
+         elapsed > 0 ? handled / elapsed : 0.0, sim_event_get_stats()->pendingPeak);
+  printSink(options.durationS * 1000000ULL);
+  printChannels(options.durationS * 1000000ULL);
+  printRelays(&options, relays, hops, parents, maxHop);
+  return EXIT_SUCCESS;
+}
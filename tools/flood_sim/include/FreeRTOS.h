@@ -0,0 +1,29 @@
+/***************************************************************************//**
+ * @file FreeRTOS.h
+ * @brief Simulator stand-in of the kernel types the firmware modules use
+ *
+ * The simulator runs one event at a time, nothing ever preempts the
+ * modules, so there is no scheduler behind these definitions. Ticks follow
+ * the virtual clock of sim_event.h at the rate of the firmware config.
+ ******************************************************************************/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <assert.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define configTICK_RATE_HZ    1024
+#define configASSERT(x)       assert(x)
+
+#define pdFALSE               ((BaseType_t)0)
+#define pdTRUE                ((BaseType_t)1)
+#define pdPASS                pdTRUE
+#define pdFAIL                pdFALSE
+#define portMAX_DELAY         ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#endif // INC_FREERTOS_H
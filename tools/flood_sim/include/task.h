@@ -0,0 +1,18 @@
+/***************************************************************************//**
+ * @file task.h
+ * @brief Simulator stand-in of the task calls the firmware modules use
+ ******************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+#include "sim_event.h"
+
+/// Events never interrupt each other, there is nothing to mask
+#define taskENTER_CRITICAL()  do {} while (0)
+#define taskEXIT_CRITICAL()   do {} while (0)
+
+#define xTaskGetTickCount() \
+  ((TickType_t)((sim_event_now_us() * configTICK_RATE_HZ) / 1000000ULL))
+
+#endif // INC_TASK_H
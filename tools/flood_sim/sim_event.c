@@ -0,0 +1,360 @@
+/***************************************************************************//**
+ * @file sim_event.c
+ * @brief Virtual clock and event queue of the flood simulator
+ *
+ * Calendar queue (R. Brown, CACM 1988): the pending events are hashed by
+ * due time into a ring of buckets of bucketWidth microseconds each, a ring
+ * turn being a "year". Each bucket is a list sorted by (time, order), the
+ * next event is the head of the first bucket, from the current one on,
+ * that is due within the bucket's window of the current year.
+ *
+ * The ring doubles or halves with the number of pending events, and the
+ * bucket width is taken from the spacing of the soonest events then, and
+ * again whenever too many empty buckets are walked or too many events share
+ * a bucket. With a fitting width schedule, cancel and next are O(1) on
+ * average. Events further than a year ahead only cost a skipped check, and
+ * a year without a due event falls back to a search of the bucket heads.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_event.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SIM_EVENT_BUCKETS_MIN 16
+
+/// Soonest events whose spacing sets the bucket width
+#define SIM_EVENT_WIDTH_SAMPLE 25
+
+/// Events taken between two checks of the bucket width, and the average
+/// steps (buckets walked to find an event, events walked to sort one in)
+/// above which the width is taken again
+#define SIM_EVENT_CHECK_PERIOD 4096
+#define SIM_EVENT_STEPS_MAX    4
+
+typedef struct
+{
+  sim_event_t *head;     //Soonest
+  sim_event_t *tail;
+} bucket_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool earlier(const sim_event_t *a, const sim_event_t *b);
+static uint32_t bucketOf(uint64_t timeUs);
+static void startAt(uint64_t timeUs);
+static void insert(sim_event_t *event);
+static void unlink(sim_event_t *event);
+static sim_event_t *peek(void);
+static void checkWidth(void);
+static uint32_t sampleShift(void);
+static void rebuild(uint32_t count, uint32_t shift);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint64_t nowUs;
+static uint64_t nextOrder;
+
+static bucket_t *buckets;
+static uint32_t bucketCount;
+static uint32_t widthShift;    //Bucket width is 1 << widthShift us
+static uint32_t current;       //Bucket the next event is looked for from
+static uint64_t currentEndUs;  //End of its window in the current year
+static uint32_t pending;
+
+//Steps since the last width check
+static uint32_t taken;
+static uint64_t bucketSteps;
+static uint64_t insertSteps;
+
+static sim_event_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sim_event_init(void)
+{
+  for (uint32_t i = 0; i < bucketCount; i++) {
+    for (sim_event_t *event = buckets[i].head; event != NULL; event = event->next) {
+      event->position = 0;
+    }
+  }
+  free(buckets);
+  buckets = NULL;
+  bucketCount = 0;
+  pending = 0;
+  nowUs = 0;
+  nextOrder = 0;
+  stats = (sim_event_stats_t){ 0 };
+  //1 ms buckets until there are events to measure
+  rebuild(SIM_EVENT_BUCKETS_MIN, 10);
+}
+
+void sim_event_schedule(sim_event_t *event, sim_event_handler_t handler, void *context, uint64_t timeUs)
+{
+  if (event->position != 0) {
+    unlink(event);
+  }
+  event->timeUs = (timeUs < nowUs) ? nowUs : timeUs;
+  event->order = nextOrder++;
+  event->handler = handler;
+  event->context = context;
+  insert(event);
+  if (pending > 2 * bucketCount) {
+    rebuild(bucketCount * 2, sampleShift());
+  }
+
+  stats.scheduled++;
+  if (pending > stats.pendingPeak) {
+    stats.pendingPeak = pending;
+  }
+}
+
+void sim_event_cancel(sim_event_t *event)
+{
+  if (event->position == 0) {
+    return;
+  }
+  unlink(event);
+  stats.cancelled++;
+}
+
+bool sim_event_is_pending(const sim_event_t *event)
+{
+  return event->position != 0;
+}
+
+uint64_t sim_event_now_us(void)
+{
+  return nowUs;
+}
+
+uint64_t sim_event_run(uint64_t endUs)
+{
+  uint64_t handled = 0;
+  sim_event_t *event;
+
+  while ((event = peek()) != NULL && event->timeUs <= endUs) {
+    unlink(event);
+    nowUs = event->timeUs;
+    //The handler may schedule the event again
+    event->handler(event);
+    handled++;
+    if (++taken == SIM_EVENT_CHECK_PERIOD) {
+      checkWidth();
+    }
+  }
+  if (endUs > nowUs) {
+    nowUs = endUs;
+  }
+  stats.handled += handled;
+  return handled;
+}
+
+const sim_event_stats_t *sim_event_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+bool earlier(const sim_event_t *a, const sim_event_t *b)
+{
+  return (a->timeUs != b->timeUs) ? (a->timeUs < b->timeUs) : (a->order < b->order);
+}
+
+uint32_t bucketOf(uint64_t timeUs)
+{
+  return (uint32_t)(timeUs >> widthShift) & (bucketCount - 1);
+}
+
+///Makes the bucket of timeUs, in the year of timeUs, the current one
+void startAt(uint64_t timeUs)
+{
+  current = bucketOf(timeUs);
+  currentEndUs = ((timeUs >> widthShift) + 1) << widthShift;
+}
+
+///Sorts the event in from the tail, where new events usually belong
+void insert(sim_event_t *event)
+{
+  uint32_t index = bucketOf(event->timeUs);
+  bucket_t *bucket = &buckets[index];
+  sim_event_t *before = bucket->tail;
+
+  while (before != NULL && earlier(event, before)) {
+    before = before->prev;
+    insertSteps++;
+  }
+  event->prev = before;
+  if (before != NULL) {
+    event->next = before->next;
+    before->next = event;
+  } else {
+    event->next = bucket->head;
+    bucket->head = event;
+  }
+  if (event->next != NULL) {
+    event->next->prev = event;
+  } else {
+    bucket->tail = event;
+  }
+  event->position = index + 1;
+  pending++;
+
+  //Due before the window looked at, e.g. scheduled after peek() went past it
+  if (event->timeUs < currentEndUs - ((uint64_t)1 << widthShift)) {
+    startAt(event->timeUs);
+  }
+}
+
+void unlink(sim_event_t *event)
+{
+  bucket_t *bucket = &buckets[event->position - 1];
+
+  if (event->prev != NULL) {
+    event->prev->next = event->next;
+  } else {
+    bucket->head = event->next;
+  }
+  if (event->next != NULL) {
+    event->next->prev = event->prev;
+  } else {
+    bucket->tail = event->prev;
+  }
+  event->position = 0;
+  pending--;
+}
+
+///Finds the next event and makes its bucket the current one
+sim_event_t *peek(void)
+{
+  uint32_t index = current;
+  uint64_t endUs = currentEndUs;
+  sim_event_t *soonest = NULL;
+
+  if (pending == 0) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < bucketCount; i++) {
+    sim_event_t *head = buckets[index].head;
+
+    if (head != NULL && head->timeUs < endUs) {
+      current = index;
+      currentEndUs = endUs;
+      return head;
+    }
+    index = (index + 1) & (bucketCount - 1);
+    endUs += (uint64_t)1 << widthShift;
+    bucketSteps++;
+  }
+  //Nothing due this year, the heads are the soonest of their buckets
+  for (uint32_t i = 0; i < bucketCount; i++) {
+    sim_event_t *head = buckets[i].head;
+
+    if (head != NULL && (soonest == NULL || earlier(head, soonest))) {
+      soonest = head;
+    }
+  }
+  startAt(soonest->timeUs);
+  return soonest;
+}
+
+///Shrinks the ring after the pending events, and takes the width again if
+///the events took too many steps to find or to sort in
+void checkWidth(void)
+{
+  bool tooManySteps = bucketSteps + insertSteps > (uint64_t)SIM_EVENT_STEPS_MAX * taken;
+  uint32_t count = bucketCount;
+
+  while (count > SIM_EVENT_BUCKETS_MIN && pending < count / 2) {
+    count /= 2;
+  }
+  if (tooManySteps || count != bucketCount) {
+    uint32_t shift = sampleShift();
+
+    if (shift != widthShift || count != bucketCount) {
+      rebuild(count, shift);
+    }
+  }
+  taken = 0;
+  bucketSteps = 0;
+  insertSteps = 0;
+}
+
+///Three times the average spacing of the soonest events, leaving out the
+///gaps over twice the average, rounded up to a power of two
+uint32_t sampleShift(void)
+{
+  sim_event_t *sample[SIM_EVENT_WIDTH_SAMPLE];
+  uint32_t count = 0;
+  uint64_t spanUs;
+  uint64_t sumUs = 0;
+  uint32_t gaps = 0;
+  uint64_t widthUs;
+  uint32_t shift = 0;
+  uint32_t savedCurrent = current;
+  uint64_t savedEndUs = currentEndUs;
+
+  while (count < SIM_EVENT_WIDTH_SAMPLE && (sample[count] = peek()) != NULL) {
+    unlink(sample[count++]);
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    insert(sample[i]);
+  }
+  current = savedCurrent;
+  currentEndUs = savedEndUs;
+  if (count < 2) {
+    return widthShift;
+  }
+
+  spanUs = sample[count - 1]->timeUs - sample[0]->timeUs;
+  for (uint32_t i = 1; i < count; i++) {
+    uint64_t gapUs = sample[i]->timeUs - sample[i - 1]->timeUs;
+    if (gapUs * (count - 1) <= 2 * spanUs) {
+      sumUs += gapUs;
+      gaps++;
+    }
+  }
+  widthUs = 3 * sumUs / gaps;
+  while (((uint64_t)1 << shift) < widthUs && shift < 40) {
+    shift++;
+  }
+  return shift;
+}
+
+///Hashes the pending events again into count buckets of the given width
+void rebuild(uint32_t count, uint32_t shift)
+{
+  bucket_t *old = buckets;
+  uint32_t oldCount = bucketCount;
+
+  buckets = calloc(count, sizeof(*buckets));
+  if (buckets == NULL) {
+    perror("sim_event");
+    exit(EXIT_FAILURE);
+  }
+  bucketCount = count;
+  widthShift = shift;
+  pending = 0;
+  startAt(nowUs);
+  for (uint32_t i = 0; i < oldCount; i++) {
+    sim_event_t *event = old[i].head;
+
+    while (event != NULL) {
+      sim_event_t *next = event->next;
+      insert(event);
+      event = next;
+    }
+  }
+  free(old);
+}
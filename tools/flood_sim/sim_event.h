@@ -0,0 +1,101 @@
+/***************************************************************************//**
+ * @file sim_event.h
+ * @brief Virtual clock and event queue of the flood simulator
+ *
+ * Time only moves when the next event is taken, from one event time to the
+ * next, so a simulated day costs what its events cost and nothing else.
+ * Events due at the same time run in the order they were scheduled, which
+ * keeps a run reproducible.
+ *
+ * Events are owned by the caller, usually embedded in the state of a node,
+ * as sleeptimer handles are in the firmware, so the queue never allocates
+ * per event. Scheduling an event that is already pending moves it, the way
+ * sl_sleeptimer_restart_timer_ms() does, and cancelling one is O(1).
+ *
+ * sim_event.c keeps the events in a calendar queue, sim_event_heap.c in a
+ * binary heap, the baseline it's benchmarked against (make bench).
+ ******************************************************************************/
+#ifndef SIM_EVENT_H
+#define SIM_EVENT_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct sim_event sim_event_t;
+
+typedef void (*sim_event_handler_t)(sim_event_t *event);
+
+struct sim_event
+{
+  uint64_t timeUs;
+  uint64_t order;        //Ties between events due at the same time
+  sim_event_handler_t handler;
+  void *context;
+  sim_event_t *prev;     //Neighbours in the calendar bucket
+  sim_event_t *next;
+  uint32_t position;     //Bucket or heap index + 1, 0 while not pending
+};
+
+typedef struct
+{
+  uint64_t scheduled;
+  uint64_t cancelled;
+  uint64_t handled;
+  uint32_t pendingPeak;
+} sim_event_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the queue and sets the clock back to 0.
+ *****************************************************************************/
+void sim_event_init(void);
+
+/**************************************************************************//**
+ * Schedules an event, moving it if it's pending already.
+ *
+ * @param event Event, must stay valid until it's handled or cancelled
+ * @param handler Called with the event once it's due
+ * @param context Stored in the event for the handler
+ * @param timeUs Due time, the current time if it's in the past
+ *****************************************************************************/
+void sim_event_schedule(sim_event_t *event, sim_event_handler_t handler, void *context, uint64_t timeUs);
+
+/**************************************************************************//**
+ * Takes an event off the queue, nothing happens if it's not pending.
+ *****************************************************************************/
+void sim_event_cancel(sim_event_t *event);
+
+/**************************************************************************//**
+ * Tells whether an event is waiting to be handled.
+ *****************************************************************************/
+bool sim_event_is_pending(const sim_event_t *event);
+
+/**************************************************************************//**
+ * Gives the virtual time.
+ *
+ * @returns Microseconds since sim_event_init()
+ *****************************************************************************/
+uint64_t sim_event_now_us(void);
+
+/**************************************************************************//**
+ * Handles the events in time order.
+ *
+ * @param endUs Events due after it are left pending, the clock stops there
+ * @returns Number of events handled
+ *****************************************************************************/
+uint64_t sim_event_run(uint64_t endUs);
+
+/**************************************************************************//**
+ * Gives the queue counters, updated in place.
+ *****************************************************************************/
+const sim_event_stats_t *sim_event_get_stats(void);
+
+#endif  // SIM_EVENT_H
@@ -0,0 +1,192 @@
+/***************************************************************************//**
+ * @file sim_event_bench.c
+ * @brief Throughput of the simulator event queue alone
+ *
+ * Classic hold model: a fixed number of events is kept pending, every
+ * handled event schedules itself again a random increment later and, for
+ * the given share of them, restarts another pending event, as a node does
+ * with sl_sleeptimer_restart_timer_ms(). Built against sim_event.c as
+ * sim_event_bench and against sim_event_heap.c as sim_event_bench_heap,
+ * see make bench.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim_event.h"
+#include "sim_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Mean increment of the uniform and exponential distributions
+#define MEAN_US 1000
+
+typedef enum
+{
+  DISTRIBUTION_UNIFORM,
+  DISTRIBUTION_EXPONENTIAL,
+  DISTRIBUTION_TICKS,     //Whole ms, many events due at once
+  DISTRIBUTION_FLOOD,     //Mostly radio events, some long timers
+  DISTRIBUTION_COUNT
+} distribution_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const char *const distributionNames[DISTRIBUTION_COUNT] = {
+  "uniform", "exponential", "ticks", "flood"
+};
+
+static sim_event_t *events;
+static uint32_t eventCount;
+static distribution_t distribution;
+static uint32_t restartPercent;
+static uint64_t holdsLeft;
+static sim_random_t increments;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n pending] [-e events] [-r restart_%%] [-s seed]\n"
+          "  -n pending    events kept pending (default 100, 1000, 10000 and 100000)\n"
+          "  -e events     events handled per run (default 10000000)\n"
+          "  -r restart_%%  handled events restarting another one (default 25)\n"
+          "  -s seed       seed of the increments (default 1)\n",
+          program);
+}
+
+static uint64_t incrementUs(void)
+{
+  switch (distribution) {
+    case DISTRIBUTION_UNIFORM:
+      return sim_random_below(&increments, 2 * MEAN_US + 1);
+    case DISTRIBUTION_EXPONENTIAL:
+      return (uint64_t)(-MEAN_US * log((sim_random_next(&increments) >> 11) * 0x1.0p-53 + 0x1.0p-54));
+    case DISTRIBUTION_TICKS:
+      return 1000 * (uint64_t)sim_random_below(&increments, 3);
+    case DISTRIBUTION_FLOOD:
+    default:
+      //TX ends and WUP gaps, then Wr, wake window and beacon timers
+      return (sim_random_below(&increments, 10) != 0)
+             ? sim_random_below(&increments, 2000)
+             : 1000 * (uint64_t)sim_random_below(&increments, 60000);
+  }
+}
+
+static void holdHandler(sim_event_t *event)
+{
+  if (holdsLeft == 0) {
+    return;
+  }
+  holdsLeft--;
+  sim_event_schedule(event, holdHandler, NULL, sim_event_now_us() + incrementUs());
+  if (sim_random_below(&increments, 100) < restartPercent) {
+    sim_event_t *other = &events[sim_random_below(&increments, eventCount)];
+    if (sim_event_is_pending(other)) {
+      sim_event_schedule(other, holdHandler, NULL, sim_event_now_us() + incrementUs());
+    }
+  }
+}
+
+static double wallSeconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+///Events handled per second, the pending ones drained at the end included
+static double run(uint32_t pending, uint64_t holds, uint64_t seed)
+{
+  double started;
+  uint64_t handled;
+
+  sim_event_init();
+  sim_random_seed(&increments, seed, distribution);
+  eventCount = pending;
+  holdsLeft = holds;
+  for (uint32_t i = 0; i < pending; i++) {
+    events[i] = (sim_event_t){ 0 };
+    sim_event_schedule(&events[i], holdHandler, NULL, incrementUs());
+  }
+  started = wallSeconds();
+  handled = sim_event_run(UINT64_MAX);
+  return handled / (wallSeconds() - started);
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  uint32_t sizes[] = { 100, 1000, 10000, 100000 };
+  uint32_t sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+  uint64_t holds = 10000000;
+  uint64_t seed = 1;
+  uint32_t largest = 0;
+  int option;
+
+  restartPercent = 25;
+  while ((option = getopt(argc, argv, "n:e:r:s:h")) != -1) {
+    switch (option) {
+      case 'n':
+        sizes[0] = (uint32_t)strtoul(optarg, NULL, 0);
+        sizeCount = 1;
+        break;
+      case 'e':
+        holds = strtoull(optarg, NULL, 0);
+        break;
+      case 'r':
+        restartPercent = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  for (uint32_t s = 0; s < sizeCount; s++) {
+    largest = (sizes[s] > largest) ? sizes[s] : largest;
+  }
+  if (largest == 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  events = calloc(largest, sizeof(*events));
+  if (events == NULL) {
+    perror("sim_event_bench");
+    return EXIT_FAILURE;
+  }
+  printf("%s: %llu events per run, %u %% restarts, events/s\n", argv[0], (unsigned long long)holds,
+         restartPercent);
+  printf("%8s", "pending");
+  for (uint32_t d = 0; d < DISTRIBUTION_COUNT; d++) {
+    printf(" %12s", distributionNames[d]);
+  }
+  printf("\n");
+  for (uint32_t s = 0; s < sizeCount; s++) {
+    printf("%8u", sizes[s]);
+    for (distribution = 0; distribution < DISTRIBUTION_COUNT; distribution++) {
+      printf(" %12.0f", run(sizes[s], holds, seed));
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  free(events);
+  return EXIT_SUCCESS;
+}
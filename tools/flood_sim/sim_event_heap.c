@@ -0,0 +1,195 @@
+/***************************************************************************//**
+ * @file sim_event_heap.c
+ * @brief Binary heap event queue, the baseline of the calendar queue
+ *
+ * Same interface and same event order as sim_event.c, so flood_sim_heap
+ * prints what flood_sim prints and both can be timed on the same run.
+ * Every operation is O(log n) in the pending events.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_event.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SIM_EVENT_HEAP_INITIAL_LENGTH 1024
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool earlier(const sim_event_t *a, const sim_event_t *b);
+static void place(sim_event_t *event, uint32_t index);
+static void siftUp(uint32_t index);
+static void siftDown(uint32_t index);
+static void removeAt(uint32_t index);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint64_t nowUs;
+static uint64_t nextOrder;
+
+///Binary min heap of the pending events, soonest at index 0
+static sim_event_t **heap;
+static uint32_t heapLength;
+static uint32_t heapCapacity;
+
+static sim_event_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sim_event_init(void)
+{
+  for (uint32_t i = 0; i < heapLength; i++) {
+    heap[i]->position = 0;
+  }
+  heapLength = 0;
+  nowUs = 0;
+  nextOrder = 0;
+  stats = (sim_event_stats_t){ 0 };
+}
+
+void sim_event_schedule(sim_event_t *event, sim_event_handler_t handler, void *context, uint64_t timeUs)
+{
+  if (event->position != 0) {
+    removeAt(event->position - 1);
+  }
+  if (heapLength == heapCapacity) {
+    heapCapacity = (heapCapacity == 0) ? SIM_EVENT_HEAP_INITIAL_LENGTH : heapCapacity * 2;
+    heap = realloc(heap, heapCapacity * sizeof(*heap));
+    if (heap == NULL) {
+      perror("sim_event");
+      exit(EXIT_FAILURE);
+    }
+  }
+  event->timeUs = (timeUs < nowUs) ? nowUs : timeUs;
+  event->order = nextOrder++;
+  event->handler = handler;
+  event->context = context;
+  place(event, heapLength++);
+  siftUp(heapLength - 1);
+
+  stats.scheduled++;
+  if (heapLength > stats.pendingPeak) {
+    stats.pendingPeak = heapLength;
+  }
+}
+
+void sim_event_cancel(sim_event_t *event)
+{
+  if (event->position == 0) {
+    return;
+  }
+  removeAt(event->position - 1);
+  stats.cancelled++;
+}
+
+bool sim_event_is_pending(const sim_event_t *event)
+{
+  return event->position != 0;
+}
+
+uint64_t sim_event_now_us(void)
+{
+  return nowUs;
+}
+
+uint64_t sim_event_run(uint64_t endUs)
+{
+  uint64_t handled = 0;
+
+  while (heapLength > 0 && heap[0]->timeUs <= endUs) {
+    sim_event_t *event = heap[0];
+
+    removeAt(0);
+    nowUs = event->timeUs;
+    //The handler may schedule the event again
+    event->handler(event);
+    handled++;
+  }
+  if (endUs > nowUs) {
+    nowUs = endUs;
+  }
+  stats.handled += handled;
+  return handled;
+}
+
+const sim_event_stats_t *sim_event_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+bool earlier(const sim_event_t *a, const sim_event_t *b)
+{
+  return (a->timeUs != b->timeUs) ? (a->timeUs < b->timeUs) : (a->order < b->order);
+}
+
+void place(sim_event_t *event, uint32_t index)
+{
+  heap[index] = event;
+  event->position = index + 1;
+}
+
+void siftUp(uint32_t index)
+{
+  sim_event_t *event = heap[index];
+
+  while (index > 0) {
+    uint32_t parent = (index - 1) / 2;
+    if (!earlier(event, heap[parent])) {
+      break;
+    }
+    place(heap[parent], index);
+    index = parent;
+  }
+  place(event, index);
+}
+
+void siftDown(uint32_t index)
+{
+  sim_event_t *event = heap[index];
+
+  while (true) {
+    uint32_t child = 2 * index + 1;
+    if (child >= heapLength) {
+      break;
+    }
+    if (child + 1 < heapLength && earlier(heap[child + 1], heap[child])) {
+      child++;
+    }
+    if (!earlier(heap[child], event)) {
+      break;
+    }
+    place(heap[child], index);
+    index = child;
+  }
+  place(event, index);
+}
+
+///The last event fills the hole and moves whichever way restores the order
+void removeAt(uint32_t index)
+{
+  sim_event_t *event = heap[index];
+  sim_event_t *last = heap[--heapLength];
+
+  event->position = 0;
+  if (last == event) {
+    return;
+  }
+  place(last, index);
+  if (index > 0 && earlier(last, heap[(index - 1) / 2])) {
+    siftUp(index);
+  } else {
+    siftDown(index);
+  }
+}
@@ -0,0 +1,258 @@
+/***************************************************************************//**
+ * @file sim_medium.c
+ * @brief Radio medium of the flood simulator, in virtual time
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_event.h"
+#include "sim_medium.h"
+#include "sim_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define NO_NODE 0xFFFFFFFFUL
+
+///What a node hears on one channel
+typedef struct
+{
+  uint32_t from;      //Sender of the frame being received, NO_NODE if none
+  uint64_t endUs;     //Until when the channel is busy around the node
+  bool collided;
+} reception_t;
+
+typedef struct
+{
+  const sim_medium_node_ops_t *ops;
+  void *context;
+
+  uint32_t *neighbors;
+  uint32_t neighborCount;
+  uint32_t neighborCapacity;
+
+  bool transmitting;
+  uint16_t txChannel;
+  uint16_t txLength;
+  uint8_t txFrame[SIM_MEDIUM_FRAME_MAX_LENGTH];
+  sim_event_t txEnd;
+
+  reception_t rx[SIM_MEDIUM_CHANNEL_COUNT];
+  sim_medium_node_stats_t stats;
+} node_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void *allocate(void *memory, size_t size);
+static void txEndHandler(sim_event_t *event);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static sim_medium_config_t mediumConfig;
+static node_t *nodes;
+static uint32_t nodesLength;
+static sim_random_t lossRandom;
+static sim_medium_channel_stats_t channelStats[SIM_MEDIUM_CHANNEL_COUNT];
+
+///Receivers of the frame that just ended, filled before any of them is called
+static uint32_t *hearers;
+static uint32_t hearersCapacity;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sim_medium_init(uint32_t nodeCount, const sim_medium_config_t *config)
+{
+  for (uint32_t n = 0; n < nodesLength; n++) {
+    sim_event_cancel(&nodes[n].txEnd);
+    free(nodes[n].neighbors);
+  }
+  nodes = allocate(nodes, nodeCount * sizeof(*nodes));
+  memset(nodes, 0, nodeCount * sizeof(*nodes));
+  nodesLength = nodeCount;
+  for (uint32_t n = 0; n < nodeCount; n++) {
+    for (uint16_t c = 0; c < SIM_MEDIUM_CHANNEL_COUNT; c++) {
+      nodes[n].rx[c].from = NO_NODE;
+    }
+  }
+  mediumConfig = *config;
+  sim_random_seed(&lossRandom, config->seed, 0);
+  memset(channelStats, 0, sizeof(channelStats));
+}
+
+void sim_medium_attach(uint32_t node, const sim_medium_node_ops_t *ops, void *context)
+{
+  nodes[node].ops = ops;
+  nodes[node].context = context;
+}
+
+void sim_medium_link(uint32_t a, uint32_t b)
+{
+  uint32_t ends[2] = { a, b };
+
+  for (uint32_t i = 0; i < 2; i++) {
+    node_t *n = &nodes[ends[i]];
+    if (n->neighborCount == n->neighborCapacity) {
+      n->neighborCapacity = (n->neighborCapacity == 0) ? 4 : n->neighborCapacity * 2;
+      n->neighbors = allocate(n->neighbors, n->neighborCapacity * sizeof(*n->neighbors));
+    }
+    n->neighbors[n->neighborCount++] = ends[1 - i];
+    if (n->neighborCount > hearersCapacity) {
+      hearersCapacity = n->neighborCapacity;
+      hearers = allocate(hearers, hearersCapacity * sizeof(*hearers));
+    }
+  }
+}
+
+bool sim_medium_transmit(uint32_t node, uint16_t channel, const uint8_t *frame, uint16_t length)
+{
+  node_t *sender = &nodes[node];
+  uint64_t startUs = sim_event_now_us();
+  uint64_t endUs;
+  uint32_t airtimeUs;
+
+  if (sender->transmitting || channel >= SIM_MEDIUM_CHANNEL_COUNT
+      || length == 0 || length > SIM_MEDIUM_FRAME_MAX_LENGTH) {
+    return false;
+  }
+  airtimeUs = sim_medium_airtime_us(channel, length);
+  endUs = startUs + airtimeUs;
+
+  //Half duplex, whatever the sender was receiving is lost
+  for (uint16_t c = 0; c < SIM_MEDIUM_CHANNEL_COUNT; c++) {
+    if (sender->rx[c].from != NO_NODE) {
+      sender->rx[c].collided = true;
+    }
+  }
+  sender->transmitting = true;
+  sender->txChannel = channel;
+  sender->txLength = length;
+  memcpy(sender->txFrame, frame, length);
+
+  for (uint32_t i = 0; i < sender->neighborCount; i++) {
+    node_t *receiver = &nodes[sender->neighbors[i]];
+    reception_t *rx = &receiver->rx[channel];
+
+    if (receiver->ops == NULL || receiver->transmitting
+        || !receiver->ops->listening(receiver->context, channel)) {
+      channelStats[channel].missed++;
+      continue;
+    }
+    if (rx->endUs > startUs) {
+      //Overlaps what the receiver is hearing, neither frame makes it
+      rx->collided = true;
+      if (endUs > rx->endUs) {
+        rx->endUs = endUs;
+      }
+      channelStats[channel].collided++;
+      receiver->stats.rxCollided++;
+      continue;
+    }
+    rx->from = node;
+    rx->endUs = endUs;
+    rx->collided = false;
+  }
+
+  channelStats[channel].frames++;
+  channelStats[channel].airtimeUs += airtimeUs;
+  sender->stats.txFrames[channel]++;
+  sender->stats.txAirtimeUs[channel] += airtimeUs;
+  sim_event_schedule(&sender->txEnd, txEndHandler, sender, endUs);
+  return true;
+}
+
+bool sim_medium_is_transmitting(uint32_t node)
+{
+  return nodes[node].transmitting;
+}
+
+uint32_t sim_medium_airtime_us(uint16_t channel, uint16_t length)
+{
+  const sim_medium_channel_config_t *phy = &mediumConfig.channels[channel];
+
+  return (uint32_t)((((uint64_t)length * 8 + phy->overheadBits) * 1000000ULL) / phy->bitrate);
+}
+
+const sim_medium_channel_stats_t *sim_medium_get_channel_stats(uint16_t channel)
+{
+  return &channelStats[channel];
+}
+
+const sim_medium_node_stats_t *sim_medium_get_node_stats(uint32_t node)
+{
+  return &nodes[node].stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+void *allocate(void *memory, size_t size)
+{
+  memory = realloc(memory, size);
+  if (memory == NULL) {
+    perror("sim_medium");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+///Settles the frame at every neighbour first, their callbacks may start
+///frames of their own that the sender has to hear
+void txEndHandler(sim_event_t *event)
+{
+  node_t *sender = event->context;
+  uint32_t node = (uint32_t)(sender - nodes);
+  uint16_t channel = sender->txChannel;
+  sim_medium_channel_stats_t *stats = &channelStats[channel];
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < sender->neighborCount; i++) {
+    node_t *receiver = &nodes[sender->neighbors[i]];
+    reception_t *rx = &receiver->rx[channel];
+
+    if (rx->from != node) {
+      continue;
+    }
+    rx->from = NO_NODE;
+    if (channel == SIM_MEDIUM_CHANNEL_WUP) {
+      //Energy is sensed whatever it carries
+      if (sim_medium_airtime_us(channel, sender->txLength) >= mediumConfig.rfSenseTimeUs) {
+        hearers[count++] = sender->neighbors[i];
+      }
+      continue;
+    }
+    if (rx->collided) {
+      receiver->stats.rxCollided++;
+      stats->collided++;
+    } else if (mediumConfig.channels[channel].lossPerMille > 0
+               && sim_random_below(&lossRandom, 1000) < mediumConfig.channels[channel].lossPerMille) {
+      stats->lost++;
+    } else if (!receiver->ops->listening(receiver->context, channel)) {
+      //Left RX before the end
+      stats->missed++;
+    } else {
+      hearers[count++] = sender->neighbors[i];
+    }
+  }
+
+  sender->transmitting = false;
+  for (uint32_t i = 0; i < count; i++) {
+    node_t *receiver = &nodes[hearers[i]];
+
+    stats->received++;
+    receiver->stats.rxFrames[channel]++;
+    if (channel == SIM_MEDIUM_CHANNEL_WUP) {
+      receiver->ops->sense(receiver->context);
+    } else {
+      receiver->ops->receive(receiver->context, sender->txFrame, sender->txLength, node);
+    }
+  }
+  sender->ops->tx_done(sender->context);
+}
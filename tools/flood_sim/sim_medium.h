@@ -0,0 +1,140 @@
+/***************************************************************************//**
+ * @file sim_medium.h
+ * @brief Radio medium of the flood simulator, in virtual time
+ *
+ * Nodes only hear the nodes they are linked to. A frame is received if the
+ * receiver listened on its channel from its start, didn't transmit meanwhile
+ * and heard no other frame overlap it, and then only if the link doesn't
+ * lose it at random. Both overlapping frames are lost.
+ *
+ * Channel 0 is the 2.4 GHz data channel, its frames are decoded. Channel 1
+ * is the 868 MHz WUP channel, where nodes only sense energy as RFSense does:
+ * a frame lasting at least the sense time wakes every listening neighbour
+ * up, overlapping or not.
+ ******************************************************************************/
+#ifndef SIM_MEDIUM_H
+#define SIM_MEDIUM_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SIM_MEDIUM_CHANNEL_COUNT     2
+#define SIM_MEDIUM_CHANNEL_DATA      0
+#define SIM_MEDIUM_CHANNEL_WUP       1
+
+/// Longest frame, the length byte counts up to 255 bytes after it
+#define SIM_MEDIUM_FRAME_MAX_LENGTH  256
+
+typedef struct
+{
+  uint32_t bitrate;       //[bit/s]
+  uint32_t overheadBits;  //Preamble, sync word and CRC
+  uint32_t lossPerMille;  //Frames each link drops at random
+} sim_medium_channel_config_t;
+
+typedef struct
+{
+  sim_medium_channel_config_t channels[SIM_MEDIUM_CHANNEL_COUNT];
+  uint32_t rfSenseTimeUs;
+  uint64_t seed;
+} sim_medium_config_t;
+
+/// What the medium needs to know of a node, all called from event handlers
+typedef struct
+{
+  /// Whether the node hears the channel right now: RX on the data channel,
+  /// RFSense armed on the WUP channel
+  bool (*listening)(void *context, uint16_t channel);
+  /// Energy sensed on the WUP channel
+  void (*sense)(void *context);
+  /// Data frame received, valid during the call only
+  void (*receive)(void *context, const uint8_t *frame, uint16_t length, uint32_t from);
+  /// The frame of the last sim_medium_transmit() is over
+  void (*tx_done)(void *context);
+} sim_medium_node_ops_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint64_t airtimeUs;
+  uint64_t received;   //Receptions, a frame counts once per receiver
+  uint64_t collided;
+  uint64_t lost;       //Random loss of the link
+  uint64_t missed;     //Receiver not listening or transmitting itself
+} sim_medium_channel_stats_t;
+
+typedef struct
+{
+  uint32_t txFrames[SIM_MEDIUM_CHANNEL_COUNT];
+  uint64_t txAirtimeUs[SIM_MEDIUM_CHANNEL_COUNT];
+  uint32_t rxFrames[SIM_MEDIUM_CHANNEL_COUNT];
+  uint32_t rxCollided;
+} sim_medium_node_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets up a medium of unlinked nodes, dropping the previous one.
+ *
+ * @param nodeCount Nodes, numbered from 0
+ * @param config Channels, copied
+ *****************************************************************************/
+void sim_medium_init(uint32_t nodeCount, const sim_medium_config_t *config);
+
+/**************************************************************************//**
+ * Gives a node its callbacks, a node without them hears nothing.
+ *
+ * @param node Node
+ * @param ops Callbacks, kept by reference
+ * @param context Passed to the callbacks
+ *****************************************************************************/
+void sim_medium_attach(uint32_t node, const sim_medium_node_ops_t *ops, void *context);
+
+/**************************************************************************//**
+ * Puts two nodes in range of each other.
+ *****************************************************************************/
+void sim_medium_link(uint32_t a, uint32_t b);
+
+/**************************************************************************//**
+ * Starts a frame from a node, tx_done is called once it's over.
+ *
+ * @param node Transmitting node
+ * @param channel Channel
+ * @param frame Frame, copied
+ * @param length Frame length, length byte included
+ * @returns false if the node is transmitting already or the frame is invalid
+ *****************************************************************************/
+bool sim_medium_transmit(uint32_t node, uint16_t channel, const uint8_t *frame, uint16_t length);
+
+/**************************************************************************//**
+ * Tells whether a node has a frame on air.
+ *****************************************************************************/
+bool sim_medium_is_transmitting(uint32_t node);
+
+/**************************************************************************//**
+ * Tells how long a frame lasts on air.
+ *
+ * @param channel Channel
+ * @param length Frame length, length byte included
+ * @returns Airtime from the preamble start to the CRC end [us]
+ *****************************************************************************/
+uint32_t sim_medium_airtime_us(uint16_t channel, uint16_t length);
+
+/**************************************************************************//**
+ * Gives the counters of a channel, updated in place.
+ *****************************************************************************/
+const sim_medium_channel_stats_t *sim_medium_get_channel_stats(uint16_t channel);
+
+/**************************************************************************//**
+ * Gives the counters of a node, updated in place.
+ *****************************************************************************/
+const sim_medium_node_stats_t *sim_medium_get_node_stats(uint32_t node);
+
+#endif  // SIM_MEDIUM_H
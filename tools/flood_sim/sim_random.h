@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @file sim_random.h
+ * @brief Seeded random streams of the flood simulator
+ *
+ * Every module draws from its own stream, seeded from the run seed, so a
+ * change in how often one module draws doesn't shift the others.
+ ******************************************************************************/
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint64_t state;
+} sim_random_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/// Seeds a stream, streams differ by seed and by stream number
+static inline void sim_random_seed(sim_random_t *random, uint64_t seed, uint64_t stream)
+{
+  random->state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+}
+
+/// splitmix64, any state (0 included) gives a full period
+static inline uint64_t sim_random_next(sim_random_t *random)
+{
+  uint64_t z = (random->state += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/// Uniform in [0, bound), bound > 0
+static inline uint32_t sim_random_below(sim_random_t *random, uint32_t bound)
+{
+  return (uint32_t)(((sim_random_next(random) >> 32) * bound) >> 32);
+}
+
+#endif  // SIM_RANDOM_H
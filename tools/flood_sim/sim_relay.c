@@ -0,0 +1,231 @@
+/***************************************************************************//**
+ * @file sim_relay.c
+ * @brief Relay models of the flood simulator
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "sim_medium.h"
+#include "sim_relay.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define MS_TO_US(ms) ((uint64_t)(ms) * 1000)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool relaySend(const pkt_t *packet, void *context);
+static void relayDeliver(const pkt_t *packet, void *context);
+static void wrStart(sim_relay_t *relay, uint32_t delayMs);
+static void wrHandler(sim_event_t *event);
+
+static bool enqueue(sim_relay_t *relay, const pkt_t *packet);
+static bool isQueued(const sim_relay_t *relay, pkt_seq_t pktSeq);
+static void txKick(sim_relay_t *relay);
+static void txHandler(sim_event_t *event);
+static void txStart(sim_relay_t *relay, uint16_t channel);
+
+static bool isAwake(const sim_relay_t *relay);
+static void stayAwake(sim_relay_t *relay);
+
+static bool relayListening(void *context, uint16_t channel);
+static void relaySense(void *context);
+static void relayReceive(void *context, const uint8_t *frame, uint16_t length, uint32_t from);
+static void relayTxDone(void *context);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const sim_medium_node_ops_t relayOps = {
+  .listening = relayListening,
+  .sense = relaySense,
+  .receive = relayReceive,
+  .tx_done = relayTxDone
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sim_relay_init(sim_relay_t *relay, uint32_t node, uint64_t seed, const sim_relay_config_t *config)
+{
+  memset(relay, 0, sizeof(*relay));
+  relay->node = node;
+  relay->config = config;
+  relay_init(&relay->protocol, RELAY_HOP_UNKNOWN, relaySend, relayDeliver, relay);
+  sim_random_seed(&relay->random, seed, node);
+  sim_medium_attach(node, &relayOps, relay);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///A data packet already queued isn't queued twice
+bool relaySend(const pkt_t *packet, void *context)
+{
+  sim_relay_t *relay = context;
+
+  if (packet->header.wupSeq == Wd && isQueued(relay, packet->header.pktSeq)) {
+    return false;
+  }
+  return enqueue(relay, packet);
+}
+
+void relayDeliver(const pkt_t *packet, void *context)
+{
+  sim_relay_t *relay = context;
+
+  if (relay->config->delivered != NULL) {
+    relay->config->delivered(relay->node, packet->header.pktSeq);
+  }
+}
+
+void wrStart(sim_relay_t *relay, uint32_t delayMs)
+{
+  if (delayMs != RELAY_NO_REQUEST) {
+    sim_event_schedule(&relay->wrEvent, wrHandler, relay, sim_event_now_us() + MS_TO_US(delayMs));
+  }
+}
+
+void wrHandler(sim_event_t *event)
+{
+  sim_relay_t *relay = event->context;
+
+  wrStart(relay, relay_request(&relay->protocol));
+}
+
+bool enqueue(sim_relay_t *relay, const pkt_t *packet)
+{
+  relay_packet_t *entry;
+
+  if (relay->queueCount == SIM_RELAY_QUEUE_LENGTH) {
+    relay->stats.queueDrops++;
+    return false;
+  }
+  entry = &relay->queue[(relay->queueHead + relay->queueCount++) % SIM_RELAY_QUEUE_LENGTH];
+  entry->header = packet->header;
+  memcpy(entry->payload, packet->payload, packet->header.length);
+  txKick(relay);
+  return true;
+}
+
+bool isQueued(const sim_relay_t *relay, pkt_seq_t pktSeq)
+{
+  for (uint32_t i = 0; i < relay->queueCount; i++) {
+    const pkt_header_t *header = &relay->queue[(relay->queueHead + i) % SIM_RELAY_QUEUE_LENGTH].header;
+    if (header->wupSeq == Wd && header->pktSeq == pktSeq) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void txKick(sim_relay_t *relay)
+{
+  uint64_t jitterUs;
+
+  if (relay->txState != SIM_RELAY_TX_IDLE || relay->queueCount == 0) {
+    return;
+  }
+  jitterUs = sim_random_below(&relay->random, (uint32_t)MS_TO_US(relay->config->forwardJitterMs) + 1);
+  relay->txState = SIM_RELAY_TX_BACKOFF;
+  sim_event_schedule(&relay->txEvent, txHandler, relay, sim_event_now_us() + jitterUs);
+}
+
+void txHandler(sim_event_t *event)
+{
+  sim_relay_t *relay = event->context;
+
+  if (relay->txState == SIM_RELAY_TX_BACKOFF) {
+    relay->txState = SIM_RELAY_TX_WUP;
+    relay->burstLength = 0;
+    txStart(relay, SIM_MEDIUM_CHANNEL_WUP);
+  } else if (relay->txState == SIM_RELAY_TX_GAP) {
+    relay->txState = SIM_RELAY_TX_DATA;
+    txStart(relay, SIM_MEDIUM_CHANNEL_DATA);
+  }
+}
+
+///As the sink does, the WUP is the first packet itself
+void txStart(sim_relay_t *relay, uint16_t channel)
+{
+  uint16_t length = 0;
+
+  while (relay->queueCount > 0
+         && (length = pkt_encode((const pkt_t *)&relay->queue[relay->queueHead], PKT_WIRE_VERSION, relay->frame)) == 0) {
+    relay->queueHead = (relay->queueHead + 1) % SIM_RELAY_QUEUE_LENGTH;
+    relay->queueCount--;
+    relay->stats.queueDrops++;
+  }
+  if (length == 0) {
+    relay->txState = SIM_RELAY_TX_IDLE;
+    return;
+  }
+  sim_medium_transmit(relay->node, channel, relay->frame, length);
+}
+
+bool isAwake(const sim_relay_t *relay)
+{
+  return relay->txState != SIM_RELAY_TX_IDLE || sim_event_now_us() < relay->wakeUntilUs;
+}
+
+void stayAwake(sim_relay_t *relay)
+{
+  relay->wakeUntilUs = sim_event_now_us() + MS_TO_US(relay->config->wakeWindowMs);
+}
+
+bool relayListening(void *context, uint16_t channel)
+{
+  bool awake = isAwake(context);
+
+  //RFSense is only armed while the radio is asleep
+  return (channel == SIM_MEDIUM_CHANNEL_DATA) ? awake : !awake;
+}
+
+void relaySense(void *context)
+{
+  sim_relay_t *relay = context;
+
+  if (!isAwake(relay)) {
+    relay->stats.wakeUps++;
+  }
+  stayAwake(relay);
+}
+
+void relayReceive(void *context, const uint8_t *frame, uint16_t length, uint32_t from)
+{
+  sim_relay_t *relay = context;
+  (void)from;
+
+  stayAwake(relay);
+  wrStart(relay, relay_handle_frame(&relay->protocol, frame, length));
+}
+
+void relayTxDone(void *context)
+{
+  sim_relay_t *relay = context;
+  uint64_t now = sim_event_now_us();
+
+  stayAwake(relay);
+  if (relay->txState == SIM_RELAY_TX_WUP) {
+    relay->wupEndUs = now;
+    relay->txState = SIM_RELAY_TX_GAP;
+    sim_event_schedule(&relay->txEvent, txHandler, relay, now + TX_WUP_DATA_GAP_US);
+    return;
+  }
+  relay->queueHead = (relay->queueHead + 1) % SIM_RELAY_QUEUE_LENGTH;
+  relay->queueCount--;
+  relay->burstLength++;
+  //Downstream relays are still in the window the WUP opened
+  if (relay->queueCount > 0 && relay->burstLength < TX_BURST_MAX_LENGTH
+      && now - relay->wupEndUs <= TX_BURST_WINDOW_US) {
+    txStart(relay, SIM_MEDIUM_CHANNEL_DATA);
+    return;
+  }
+  relay->txState = SIM_RELAY_TX_IDLE;
+  txKick(relay);
+}
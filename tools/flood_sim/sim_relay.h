@@ -0,0 +1,94 @@
+/***************************************************************************//**
+ * @file sim_relay.h
+ * @brief Relay models of the flood simulator
+ *
+ * The protocol is the one of relay.h, the firmware module built unchanged:
+ * this file only gives it a radio, a transmit queue and its timers. Relays
+ * start without a hop count and learn it from their upstream neighbours.
+ *
+ * Relays sleep with RFSense armed and listen on the data channel for
+ * wakeWindowMs after a WUP, a reception or a transmission of their own.
+ * Every transmission is a WUP followed by a burst of data frames, with the
+ * gap and burst limits of the sink, after a random wait that keeps the
+ * relays woken by the same frame from all answering at once.
+ ******************************************************************************/
+#ifndef SIM_RELAY_H
+#define SIM_RELAY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flood_config.h"
+#include "pkt.h"
+#include "relay.h"
+
+#include "sim_event.h"
+#include "sim_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SIM_RELAY_QUEUE_LENGTH QUEUE_DEFAULT_LENGTH
+
+typedef struct
+{
+  uint32_t forwardJitterMs;  //Longest random wait before a transmission
+  uint32_t wakeWindowMs;
+  /// Called for the first copy of every data packet
+  void (*delivered)(uint32_t node, pkt_seq_t pktSeq);
+} sim_relay_config_t;
+
+typedef struct
+{
+  uint32_t queueDrops;
+  uint32_t wakeUps;      //WUPs sensed while asleep
+} sim_relay_stats_t;
+
+typedef enum
+{
+  SIM_RELAY_TX_IDLE,
+  SIM_RELAY_TX_BACKOFF,
+  SIM_RELAY_TX_WUP,
+  SIM_RELAY_TX_GAP,
+  SIM_RELAY_TX_DATA
+} sim_relay_tx_state_t;
+
+typedef struct
+{
+  uint32_t node;
+  const sim_relay_config_t *config;
+  sim_random_t random;
+  uint64_t wakeUntilUs;
+
+  relay_t protocol;
+  sim_event_t wrEvent;
+
+  relay_packet_t queue[SIM_RELAY_QUEUE_LENGTH];
+  uint32_t queueHead;
+  uint32_t queueCount;
+  sim_relay_tx_state_t txState;
+  sim_event_t txEvent;
+  uint64_t wupEndUs;
+  uint32_t burstLength;
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+
+  sim_relay_stats_t stats;
+} sim_relay_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets a relay up asleep and attaches it to the medium.
+ *
+ * @param relay Relay
+ * @param node Medium node of the relay
+ * @param seed Run seed, the relay draws from its own stream of it
+ * @param config Settings, kept by reference
+ *****************************************************************************/
+void sim_relay_init(sim_relay_t *relay, uint32_t node, uint64_t seed, const sim_relay_config_t *config);
+
+#endif  // SIM_RELAY_H
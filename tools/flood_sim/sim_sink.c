@@ -0,0 +1,301 @@
+/***************************************************************************//**
+ * @file sim_sink.c
+ * @brief The sink of main.c, run by the events of the flood simulator
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "flood_config.h"
+#include "pkt.h"
+#include "pkt_agg.h"
+#include "sink.h"
+#include "trickle.h"
+
+#include "sim_event.h"
+#include "sim_medium.h"
+#include "sim_sink.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (SINK_CHANNEL_DATA != SIM_MEDIUM_CHANNEL_DATA) || (SINK_CHANNEL_WUP != SIM_MEDIUM_CHANNEL_WUP)
+#error "The channels of sink.h and of the medium differ"
+#endif
+
+#define RX_BATCH_CAPACITY PKT_AGG_RECORDS_MAX
+
+#define MS_TO_US(ms) ((uint64_t)(ms) * 1000)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+///Beacon
+static void beaconStartInterval(uint64_t startUs);
+static void beaconHandler(sim_event_t *event);
+static void beaconHear(void *context, bool consistent);
+
+///Packet generator
+static void pktGeneratorHandler(sim_event_t *event);
+
+///Transmitter
+static void transmitterKick(void *context);
+static void transmitterKickHandler(sim_event_t *event);
+static bool transmitterStartTx(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                               const uint32_t *atUs);
+static void transmitterScheduledHandler(sim_event_t *event);
+static void transmitterStartTimer(void *context, uint32_t ms);
+static void transmitterTimerHandler(sim_event_t *event);
+static uint32_t transmitterNowUs(void *context);
+static void transmitterEnd(void *context, bool sent);
+
+///Receiver
+static void receiverStartCoalesceTimer(void *context, uint32_t ms);
+static void receiverCoalesceHandler(sim_event_t *event);
+
+///Medium callbacks
+static bool sinkListening(void *context, uint16_t channel);
+static void sinkSense(void *context);
+static void sinkReceive(void *context, const uint8_t *frame, uint16_t length, uint32_t from);
+static void sinkTxDone(void *context);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const sim_medium_node_ops_t mediumOps = {
+  .listening = sinkListening,
+  .sense = sinkSense,
+  .receive = sinkReceive,
+  .tx_done = sinkTxDone
+};
+
+///The platform side of sink.c, as main.c gives it
+static const sink_ops_t sinkOps = {
+  .start_tx = transmitterStartTx,
+  .start_timer = transmitterStartTimer,
+  .now_us = transmitterNowUs,
+  .tx_end = transmitterEnd,
+  .packet_queued = transmitterKick,
+  .hear = beaconHear,
+  .start_coalesce_timer = receiverStartCoalesceTimer
+};
+
+static uint32_t sinkNode;
+static sim_sink_config_t sinkConfig;
+static sim_sink_stats_t sinkStats;
+
+///Beacon Trickle timer, the event stands at the transmission point or at the interval end
+static trickle_t beaconTrickle;
+static sim_event_t beaconEvent;
+static bool beaconAtFirePoint;
+static uint64_t beaconIntervalStartUs;
+static uint32_t beaconIntervals;
+
+static sim_event_t pktGeneratorEvent;
+
+///Frame last started, the one of a scheduled start stays in sink.c until it's done
+static uint16_t txChannel;
+static uint16_t txLength;
+static const uint8_t *txFrame;
+static sim_event_t txKickEvent;
+static sim_event_t txScheduledEvent;
+static sim_event_t txTimerEvent;
+
+///Receiver
+static sink_packet_t rxBatch[RX_BATCH_CAPACITY];
+static sim_event_t coalesceEvent;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sim_sink_init(uint32_t node, const sim_sink_config_t *config)
+{
+  sinkNode = node;
+  sinkConfig = *config;
+  memset(&sinkStats, 0, sizeof(sinkStats));
+
+  sink_init(&sinkOps, NULL);
+  sim_medium_attach(node, &mediumOps, NULL);
+
+  trickle_init(&beaconTrickle, BEACON_TRICKLE_IMIN_MS, BEACON_TRICKLE_DOUBLINGS, BEACON_TRICKLE_K, config->seed);
+  beaconIntervals = 0;
+  beaconStartInterval(sim_event_now_us());
+}
+
+const sim_sink_stats_t *sim_sink_get_stats(void)
+{
+  return &sinkStats;
+}
+
+const trickle_stats_t *sim_sink_get_trickle_stats(void)
+{
+  return &beaconTrickle.stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Beacon
+///The waits of beaconTaskFunction() of main.c are the beacon event
+void beaconStartInterval(uint64_t startUs){
+  beaconIntervalStartUs = startUs;
+  beaconAtFirePoint = true;
+  sim_event_schedule(&beaconEvent, beaconHandler, NULL, startUs + MS_TO_US(trickle_get_fire_ms(&beaconTrickle)));
+}
+
+void beaconHandler(sim_event_t *event){
+  if(beaconAtFirePoint){
+      beaconAtFirePoint = false;
+      if(trickle_fire(&beaconTrickle)){
+          sink_send_beacon();
+      }
+      sim_event_schedule(event, beaconHandler, NULL, beaconIntervalStartUs + MS_TO_US(trickle_get_interval_ms(&beaconTrickle)));
+      return;
+  }
+  beaconIntervalStartUs += MS_TO_US(trickle_get_interval_ms(&beaconTrickle));
+  trickle_next_interval(&beaconTrickle);
+
+  //Start the packet generator once the startup beacons are out
+  if(++beaconIntervals == SINK_STARTUP_BEACON_INTERVALS){
+      sim_event_schedule(&pktGeneratorEvent, pktGeneratorHandler, NULL,
+                         sim_event_now_us() + MS_TO_US(sinkConfig.generationPeriodMs));
+  }
+  beaconStartInterval(beaconIntervalStartUs);
+}
+
+///A reset interval starts now, as the notified beacon task does
+void beaconHear(void *context, bool consistent){
+  (void)context;
+  if(consistent){
+      trickle_hear_consistent(&beaconTrickle);
+  }else if(trickle_hear_inconsistent(&beaconTrickle)){
+      beaconStartInterval(sim_event_now_us());
+  }
+}
+
+///Packet generator
+///One pass of the pktGeneratorTaskFunction() loop of main.c per event
+void pktGeneratorHandler(sim_event_t *event){
+  pkt_seq_t pktSeq;
+
+  sim_event_schedule(event, pktGeneratorHandler, NULL, sim_event_now_us() + MS_TO_US(sinkConfig.generationPeriodMs));
+  if(sink_generate(sinkConfig.payloadLength, &pktSeq) && sinkConfig.generated != NULL){
+      sinkConfig.generated(pktSeq);
+  }
+}
+
+///Transmitter
+///The transmitter task runs below the receiver and the beacon tasks, so it
+///only takes the queue once the handler that filled it is over
+void transmitterKick(void *context){
+  (void)context;
+  if(sink_tx_is_idle() && !sim_event_is_pending(&txKickEvent)){
+      sim_event_schedule(&txKickEvent, transmitterKickHandler, NULL, sim_event_now_us());
+  }
+}
+
+void transmitterKickHandler(sim_event_t *event){
+  (void)event;
+  sink_tx_start(0);
+}
+
+///A scheduled start is an event at its time, the radio time is the low bits of the simulated one
+bool transmitterStartTx(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                        const uint32_t *atUs){
+  uint64_t nowUs = sim_event_now_us();
+  (void)context;
+
+  txChannel = channel;
+  txLength = length;
+  txFrame = frame;
+  if(atUs != NULL){
+      int32_t leftUs = (int32_t)(*atUs - (uint32_t)nowUs);
+
+      if(leftUs < 0){
+          return false;
+      }
+      sim_event_schedule(&txScheduledEvent, transmitterScheduledHandler, NULL, nowUs + (uint64_t)leftUs);
+      return true;
+  }
+  return sim_medium_transmit(sinkNode, channel, frame, length);
+}
+
+///A start refused at its scheduled time is a blocked transmission
+void transmitterScheduledHandler(sim_event_t *event){
+  (void)event;
+  if(!sim_medium_transmit(sinkNode, txChannel, txFrame, txLength)){
+      sink_tx_failed(SINK_TX_BLOCKED);
+  }
+}
+
+void transmitterStartTimer(void *context, uint32_t ms){
+  (void)context;
+  sim_event_schedule(&txTimerEvent, transmitterTimerHandler, NULL, sim_event_now_us() + MS_TO_US(ms));
+}
+
+void transmitterTimerHandler(sim_event_t *event){
+  (void)event;
+  sink_tx_timer();
+}
+
+uint32_t transmitterNowUs(void *context){
+  (void)context;
+  return (uint32_t)sim_event_now_us();
+}
+
+void transmitterEnd(void *context, bool sent){
+  (void)sent;
+  sim_event_cancel(&txTimerEvent);
+  sim_event_cancel(&txScheduledEvent);
+  transmitterKick(context);
+}
+
+///Receiver
+void receiverStartCoalesceTimer(void *context, uint32_t ms){
+  (void)context;
+  sim_event_schedule(&coalesceEvent, receiverCoalesceHandler, NULL, sim_event_now_us() + MS_TO_US(ms));
+}
+
+void receiverCoalesceHandler(sim_event_t *event){
+  (void)event;
+  sink_flush_requests();
+}
+
+///Medium callbacks
+bool sinkListening(void *context, uint16_t channel){
+  (void)context;
+  return channel == SIM_MEDIUM_CHANNEL_DATA;
+}
+
+void sinkSense(void *context){
+  (void)context;
+}
+
+///receiverDrainFifo() of main.c, one frame at a time here
+void sinkReceive(void *context, const uint8_t *frame, uint16_t length, uint32_t from){
+  uint32_t count = sink_decode_frame(frame, length, rxBatch, RX_BATCH_CAPACITY);
+  (void)context;
+  (void)from;
+
+  if(count == 0){
+      sinkStats.discarded++;
+      return;
+  }
+  sinkStats.received += count;
+  for(uint32_t i = 0; i < count; i++){
+      sink_handle_packet((pkt_t *)&rxBatch[i]);
+  }
+}
+
+///RAIL_EVENT_TX_PACKET_SENT of main.c: the WUP is timed at its end, the data frame at its preamble start
+void sinkTxDone(void *context){
+  uint64_t sentUs = sim_event_now_us();
+  (void)context;
+
+  if(txChannel == SINK_CHANNEL_DATA){
+      sentUs -= sim_medium_airtime_us(txChannel, txLength);
+  }
+  sink_tx_done((uint32_t)sentUs);
+}
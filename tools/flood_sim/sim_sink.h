@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file sim_sink.h
+ * @brief The sink of main.c, run by the events of the flood simulator
+ *
+ * The protocol is the one of main.c, sink.c, built unchanged with the
+ * firmware modules it drives. The four sink tasks become event handlers that
+ * keep the names of their main.c counterparts and give sink.c the same
+ * platform operations: the beacon Trickle loop, the packet generator, the
+ * transmitter on the medium, with its scheduled data start, and the receiver.
+ * The protocol counters are read through sink_get_stats().
+ *
+ * The sink listens on the data channel whenever it isn't transmitting.
+ ******************************************************************************/
+#ifndef SIM_SINK_H
+#define SIM_SINK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pkt.h"
+#include "trickle.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint32_t generationPeriodMs;  //PACKET_GENERATION_MS_DELAY of main.c
+  uint8_t payloadLength;        //PACKET_GENERATION_PAYLOAD_LENGTH of main.c
+  uint32_t seed;                //Trickle seed, RAIL_GetRadioEntropy() on the device, not 0
+  /// Called for every data packet generated, at its generation time
+  void (*generated)(pkt_seq_t pktSeq);
+} sim_sink_config_t;
+
+/// The received and discarded counters of the rx_stats_t of main.c
+typedef struct
+{
+  uint32_t received;
+  uint32_t discarded;
+} sim_sink_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets the firmware modules up, attaches the sink to the medium and starts
+ * beaconing at the current time.
+ *
+ * @param node Medium node of the sink
+ * @param config Settings, copied
+ *****************************************************************************/
+void sim_sink_init(uint32_t node, const sim_sink_config_t *config);
+
+/**************************************************************************//**
+ * Gives the receiver counters, updated in place.
+ *****************************************************************************/
+const sim_sink_stats_t *sim_sink_get_stats(void);
+
+/**************************************************************************//**
+ * Gives the counters of the beacon Trickle timer, updated in place.
+ *****************************************************************************/
+const trickle_stats_t *sim_sink_get_trickle_stats(void);
+
+#endif  // SIM_SINK_H
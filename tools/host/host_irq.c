@@ -0,0 +1,158 @@
+/***************************************************************************//**
+ * @file host_irq.c
+ * @brief Interrupt context of the host build
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "host_irq.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define HOST_IRQ_TASK_PRIORITY   (configMAX_PRIORITIES - 1)
+#define HOST_IRQ_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void irqTaskFunction(void *parameters);
+static uint64_t monotonicUs(void);
+static void unlinkTimer(host_irq_timer_t *timer);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint64_t epochUs;
+
+///Running timers, soonest first
+static host_irq_timer_t *timers;
+static host_irq_poll_t pollFunction;
+
+static TaskHandle_t irqTaskHandle;
+static StackType_t irqTaskStack[HOST_IRQ_TASK_STACK_SIZE];
+static StaticTask_t irqTaskTCB;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void host_irq_init(void)
+{
+  epochUs = monotonicUs();
+  irqTaskHandle = xTaskCreateStatic(irqTaskFunction, "irqTask", HOST_IRQ_TASK_STACK_SIZE, NULL,
+                                    HOST_IRQ_TASK_PRIORITY, irqTaskStack, &irqTaskTCB);
+  configASSERT(irqTaskHandle != NULL);
+}
+
+uint64_t host_irq_now_us(void)
+{
+  return monotonicUs() - epochUs;
+}
+
+uint64_t host_irq_epoch_us(void)
+{
+  return epochUs;
+}
+
+void host_irq_timer_start(host_irq_timer_t *timer, host_irq_handler_t handler, uint64_t dueUs)
+{
+  host_irq_timer_t **link;
+
+  taskENTER_CRITICAL();
+  unlinkTimer(timer);
+  timer->handler = handler;
+  timer->dueUs = dueUs;
+  timer->running = true;
+  link = &timers;
+  while (*link != NULL && (*link)->dueUs <= dueUs) {
+    link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+  taskEXIT_CRITICAL();
+}
+
+void host_irq_timer_stop(host_irq_timer_t *timer)
+{
+  taskENTER_CRITICAL();
+  unlinkTimer(timer);
+  taskEXIT_CRITICAL();
+}
+
+void host_irq_set_poll(host_irq_poll_t poll)
+{
+  taskENTER_CRITICAL();
+  pollFunction = poll;
+  taskEXIT_CRITICAL();
+}
+
+bool host_irq_in_context(void)
+{
+  return irqTaskHandle != NULL
+         && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED
+         && xTaskGetCurrentTaskHandle() == irqTaskHandle;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Runs the due timers and the poll function once per tick, as a compare
+///interrupt of the tick timer would. Timers are mostly started with the
+///interrupts masked, where no kernel call is allowed to wake this task up.
+void irqTaskFunction(void *parameters)
+{
+  host_irq_timer_t *timer;
+  TickType_t lastWake = xTaskGetTickCount();
+  uint64_t now;
+  (void)parameters;
+
+  while (true) {
+    taskENTER_CRITICAL();
+    if (pollFunction != NULL) {
+      pollFunction();
+    }
+    now = host_irq_now_us();
+    while (timers != NULL && timers->dueUs <= now) {
+      timer = timers;
+      timers = timer->next;
+      timer->next = NULL;
+      timer->running = false;
+      timer->handler(timer);
+    }
+    taskEXIT_CRITICAL();
+
+    vTaskDelayUntil(&lastWake, 1);
+  }
+}
+
+uint64_t monotonicUs(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+///Called in a critical section
+void unlinkTimer(host_irq_timer_t *timer)
+{
+  host_irq_timer_t **link;
+
+  if (!timer->running) {
+    return;
+  }
+  for (link = &timers; *link != NULL; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      break;
+    }
+  }
+  timer->next = NULL;
+  timer->running = false;
+}
@@ -0,0 +1,92 @@
+/***************************************************************************//**
+ * @file host_irq.h
+ * @brief Interrupt context of the host build
+ *
+ * The firmware expects sleeptimer, RFSense, RAIL and UART completion callbacks
+ * to run in interrupt context. On the host they run in the highest priority
+ * FreeRTOS task, inside a critical section so the POSIX port tick can't
+ * preempt them halfway through a FromISR call, as the NVIC wouldn't.
+ *
+ * Time is CLOCK_MONOTONIC in microseconds since host_irq_init(). Timers are
+ * served at the first kernel tick (1/configTICK_RATE_HZ) after they are due,
+ * never early.
+ ******************************************************************************/
+#ifndef HOST_IRQ_H
+#define HOST_IRQ_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct host_irq_timer host_irq_timer_t;
+
+/// Called in interrupt context once the timer is due, it may start it again
+typedef void (*host_irq_handler_t)(host_irq_timer_t *timer);
+
+/// One shot timer, owned by the caller and embedded in its own state
+struct host_irq_timer
+{
+  host_irq_timer_t *next;
+  host_irq_handler_t handler;
+  uint64_t dueUs;
+  bool running;
+};
+
+/// Called in interrupt context once per kernel tick, e.g. to deliver the
+/// frames of a shared medium
+typedef void (*host_irq_poll_t)(void);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts the clock and creates the interrupt task, before the scheduler runs.
+ *****************************************************************************/
+void host_irq_init(void);
+
+/**************************************************************************//**
+ * Tells the time.
+ *
+ * @returns Microseconds since host_irq_init()
+ *****************************************************************************/
+uint64_t host_irq_now_us(void);
+
+/**************************************************************************//**
+ * Tells when host_irq_init() ran, to share times with other processes.
+ *
+ * @returns CLOCK_MONOTONIC time of host_irq_init() [us]
+ *****************************************************************************/
+uint64_t host_irq_epoch_us(void);
+
+/**************************************************************************//**
+ * Starts or restarts a timer, from a task or from interrupt context.
+ *
+ * @param timer Timer
+ * @param handler Called once dueUs is reached
+ * @param dueUs Absolute time, a time in the past fires at the next pass
+ *****************************************************************************/
+void host_irq_timer_start(host_irq_timer_t *timer, host_irq_handler_t handler, uint64_t dueUs);
+
+/**************************************************************************//**
+ * Stops a timer, nothing happens if it isn't running.
+ *****************************************************************************/
+void host_irq_timer_stop(host_irq_timer_t *timer);
+
+/**************************************************************************//**
+ * Makes the interrupt task call poll once per kernel tick.
+ *
+ * @param poll Poll function, NULL stops polling
+ *****************************************************************************/
+void host_irq_set_poll(host_irq_poll_t poll);
+
+/**************************************************************************//**
+ * Tells whether the caller runs in the interrupt task, CORE_InIrqContext().
+ *****************************************************************************/
+bool host_irq_in_context(void);
+
+#endif  // HOST_IRQ_H
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file FreeRTOSConfig.h
+ * @brief Kernel configuration of the host build, FreeRTOS POSIX port
+ *
+ * Mirrors config/FreeRTOSConfig.h where the firmware depends on it: tick rate,
+ * priorities, static allocation and the idle hook. Stacks are larger since
+ * every task is a pthread and host libc needs more room than newlib-nano.
+ * Tickless idle is off, the POSIX port has no low power mode to enter.
+ ******************************************************************************/
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#define configMINIMAL_STACK_SIZE                4096
+#define configTOTAL_HEAP_SIZE                   (64 * 1024)
+#define configTICK_RATE_HZ                      1024
+#define configTIMER_TASK_STACK_DEPTH            configMINIMAL_STACK_SIZE
+#define configTIMER_TASK_PRIORITY               40
+#define configTIMER_QUEUE_LENGTH                10
+#define configUSE_TIME_SLICING                  1
+#define configIDLE_SHOULD_YIELD                 1
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configQUEUE_REGISTRY_SIZE               10
+
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configUSE_PREEMPTION                    1
+#define configUSE_TIMERS                        1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_16_BIT_TICKS                  0
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configMAX_PRIORITIES                    56
+
+#define INCLUDE_xEventGroupSetBitsFromISR       1
+#define INCLUDE_xSemaphoreGetMutexHolder        1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_eTaskGetState                   1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xResumeFromISR                  1
+
+#define configASSERT(x)                         assert(x)
+#define configUSE_TICKLESS_IDLE                 0
+#define configMAX_TASK_NAME_LEN                 20
+#define configUSE_QUEUE_SETS                    0
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_CO_ROUTINES                   0
+#define configMAX_CO_ROUTINE_PRIORITIES         1
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,36 @@
+/***************************************************************************//**
+ * @file em_core.h
+ * @brief Host stand-in of the emlib core interrupt masking
+ *
+ * Interrupt context is the interrupt task of host_irq.h, masking it is
+ * entering a kernel critical section.
+ ******************************************************************************/
+#ifndef EM_CORE_H
+#define EM_CORE_H
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "host_irq.h"
+
+#define CORE_DECLARE_IRQ_STATE  int irqState __attribute__((unused)) = 0
+#define CORE_ENTER_ATOMIC()     taskENTER_CRITICAL()
+#define CORE_EXIT_ATOMIC()      taskEXIT_CRITICAL()
+#define CORE_ENTER_CRITICAL()   taskENTER_CRITICAL()
+#define CORE_EXIT_CRITICAL()    taskEXIT_CRITICAL()
+#define CORE_ATOMIC_SECTION(yourcode) \
+  {                                   \
+    taskENTER_CRITICAL();             \
+    {                                 \
+      yourcode                        \
+    }                                 \
+    taskEXIT_CRITICAL();              \
+  }
+
+#define CORE_InIrqContext()     host_irq_in_context()
+
+#define __DMB()                 __sync_synchronize()
+
+#endif // EM_CORE_H
@@ -0,0 +1,205 @@
+/***************************************************************************//**
+ * @file rail.h
+ * @brief Host stand-in of the RAIL API used by the sink, see rail_host.h
+ *
+ * Same names, types and semantics as RAIL 2.x for the calls the firmware
+ * makes. Event bit values are the host's own, only their names matter.
+ ******************************************************************************/
+#ifndef RAIL_H
+#define RAIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void *RAIL_Handle_t;
+typedef uint32_t RAIL_Time_t;
+typedef uint64_t RAIL_Events_t;
+typedef uint32_t RAIL_TxOptions_t;
+typedef uint32_t RAIL_CalMask_t;
+typedef const void *RAIL_RxPacketHandle_t;
+
+typedef enum
+{
+  RAIL_STATUS_NO_ERROR,
+  RAIL_STATUS_INVALID_PARAMETER,
+  RAIL_STATUS_INVALID_STATE,
+  RAIL_STATUS_INVALID_CALL,
+  RAIL_STATUS_SUSPENDED,
+} RAIL_Status_t;
+
+#define RAIL_EVENTS_NONE                   0ULL
+#define RAIL_EVENT_RSSI_AVERAGE_DONE       (1ULL << 0)
+#define RAIL_EVENT_RX_FIFO_ALMOST_FULL     (1ULL << 1)
+#define RAIL_EVENT_RX_PACKET_RECEIVED      (1ULL << 2)
+#define RAIL_EVENT_RX_FRAME_ERROR          (1ULL << 3)
+#define RAIL_EVENT_RX_FIFO_OVERFLOW        (1ULL << 4)
+#define RAIL_EVENT_RX_PACKET_ABORTED       (1ULL << 5)
+#define RAIL_EVENT_TX_PACKET_SENT          (1ULL << 6)
+#define RAIL_EVENT_TX_ABORTED              (1ULL << 7)
+#define RAIL_EVENT_TX_BLOCKED              (1ULL << 8)
+#define RAIL_EVENT_TX_UNDERFLOW            (1ULL << 9)
+#define RAIL_EVENT_TX_CHANNEL_BUSY         (1ULL << 10)
+#define RAIL_EVENT_TX_SCHEDULED_TX_MISSED  (1ULL << 11)
+#define RAIL_EVENT_CAL_NEEDED              (1ULL << 12)
+#define RAIL_EVENT_RX_FIFO_FULL            (1ULL << 13)
+
+#define RAIL_EVENTS_TX_COMPLETION (RAIL_EVENT_TX_PACKET_SENT          \
+                                   | RAIL_EVENT_TX_ABORTED            \
+                                   | RAIL_EVENT_TX_BLOCKED            \
+                                   | RAIL_EVENT_TX_UNDERFLOW          \
+                                   | RAIL_EVENT_TX_CHANNEL_BUSY       \
+                                   | RAIL_EVENT_TX_SCHEDULED_TX_MISSED)
+
+#define RAIL_CAL_ALL_PENDING     0xFFFFFFFFUL
+#define RAIL_TX_OPTIONS_DEFAULT  0UL
+
+#define RAIL_RX_PACKET_HANDLE_INVALID         ((RAIL_RxPacketHandle_t)NULL)
+#define RAIL_RX_PACKET_HANDLE_OLDEST          ((RAIL_RxPacketHandle_t)1)
+#define RAIL_RX_PACKET_HANDLE_NEWEST          ((RAIL_RxPacketHandle_t)2)
+#define RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE ((RAIL_RxPacketHandle_t)3)
+
+typedef enum
+{
+  RAIL_RX_PACKET_NONE,
+  RAIL_RX_PACKET_ABORT_FORMAT,
+  RAIL_RX_PACKET_ABORT_FILTERED,
+  RAIL_RX_PACKET_ABORT_ABORTED,
+  RAIL_RX_PACKET_ABORT_OVERFLOW,
+  RAIL_RX_PACKET_ABORT_CRC_ERROR,
+  RAIL_RX_PACKET_READY_CRC_ERROR,
+  RAIL_RX_PACKET_READY_SUCCESS,
+  RAIL_RX_PACKET_RECEIVING,
+} RAIL_RxPacketStatus_t;
+
+typedef struct
+{
+  RAIL_RxPacketStatus_t packetStatus;
+  uint16_t packetBytes;
+  uint16_t firstPortionBytes;
+  const uint8_t *firstPortionData;
+  const uint8_t *lastPortionData;
+} RAIL_RxPacketInfo_t;
+
+typedef enum
+{
+  RAIL_PACKET_TIME_INVALID,
+  RAIL_PACKET_TIME_DEFAULT,
+  RAIL_PACKET_TIME_AT_PREAMBLE_START,
+  RAIL_PACKET_TIME_AT_PREAMBLE_START_USED_TOTAL,
+  RAIL_PACKET_TIME_AT_SYNC_END,
+  RAIL_PACKET_TIME_AT_SYNC_END_USED_TOTAL,
+  RAIL_PACKET_TIME_AT_PACKET_END,
+  RAIL_PACKET_TIME_AT_PACKET_END_USED_TOTAL,
+} RAIL_PacketTimePosition_t;
+
+typedef struct
+{
+  RAIL_Time_t packetTime;
+  uint16_t totalPacketBytes;  //Input of RAIL_GetTxPacketDetails(), frame and CRC bytes
+  RAIL_PacketTimePosition_t timePosition;
+  uint32_t packetDurationUs;
+} RAIL_PacketTimeStamp_t;
+
+typedef struct
+{
+  RAIL_PacketTimeStamp_t timeReceived;
+  bool crcPassed;
+  bool isAck;
+  int8_t rssi;
+  uint8_t lqi;
+  uint8_t syncWordId;
+  uint8_t subPhyId;
+  uint16_t channel;
+} RAIL_RxPacketDetails_t;
+
+typedef struct
+{
+  RAIL_PacketTimeStamp_t timeSent;
+  bool isAck;
+} RAIL_TxPacketDetails_t;
+
+typedef enum
+{
+  RAIL_TIME_ABSOLUTE,
+  RAIL_TIME_DELAY,
+  RAIL_TIME_DISABLED,
+} RAIL_TimeMode_t;
+
+typedef enum
+{
+  RAIL_SCHEDULED_TX_DURING_RX_POSTPONE_TX,
+  RAIL_SCHEDULED_TX_DURING_RX_ABORT_TX,
+} RAIL_ScheduledTxDuringRx_t;
+
+typedef struct
+{
+  RAIL_Time_t when;
+  RAIL_TimeMode_t mode;
+  RAIL_ScheduledTxDuringRx_t txDuringRx;
+} RAIL_ScheduleTxConfig_t;
+
+typedef enum
+{
+  RAIL_IDLE,
+  RAIL_IDLE_ABORT,
+  RAIL_IDLE_FORCE_SHUTDOWN,
+  RAIL_IDLE_FORCE_SHUTDOWN_CLEAR_FLAGS,
+} RAIL_IdleMode_t;
+
+typedef enum
+{
+  RAIL_RF_STATE_INACTIVE = 0,
+  RAIL_RF_STATE_ACTIVE = (1 << 0),
+  RAIL_RF_STATE_RX = (1 << 1),
+  RAIL_RF_STATE_TX = (1 << 2),
+  RAIL_RF_STATE_IDLE = RAIL_RF_STATE_ACTIVE,
+  RAIL_RF_STATE_RX_ACTIVE = (RAIL_RF_STATE_RX | RAIL_RF_STATE_ACTIVE),
+  RAIL_RF_STATE_TX_ACTIVE = (RAIL_RF_STATE_TX | RAIL_RF_STATE_ACTIVE),
+} RAIL_RadioState_t;
+
+typedef enum
+{
+  RAIL_RFSENSE_OFF,
+  RAIL_RFSENSE_2_4GHZ,
+  RAIL_RFSENSE_SUBGHZ,
+  RAIL_RFSENSE_ANY,
+  RAIL_RFSENSE_2_4GHZ_LOW_SENSITIVITY = 0x21,
+  RAIL_RFSENSE_SUBGHZ_LOW_SENSITIVITY,
+  RAIL_RFSENSE_ANY_LOW_SENSITIVITY,
+} RAIL_RfSenseBand_t;
+
+typedef void (*RAIL_RfSense_CallbackPtr_t)(void);
+
+RAIL_Status_t RAILCb_SetupRxFifo(RAIL_Handle_t railHandle);
+
+RAIL_Status_t RAIL_Calibrate(RAIL_Handle_t railHandle, void *calValues, RAIL_CalMask_t calForce);
+RAIL_Time_t RAIL_GetTime(void);
+uint16_t RAIL_GetRadioEntropy(RAIL_Handle_t railHandle, uint8_t *buffer, uint16_t bytes);
+RAIL_RadioState_t RAIL_GetRadioState(RAIL_Handle_t railHandle);
+void RAIL_Idle(RAIL_Handle_t railHandle, RAIL_IdleMode_t mode, bool wait);
+uint16_t RAIL_SetFixedLength(RAIL_Handle_t railHandle, uint16_t length);
+
+uint16_t RAIL_SetTxFifo(RAIL_Handle_t railHandle, uint8_t *addr, uint16_t initLength, uint16_t size);
+uint16_t RAIL_WriteTxFifo(RAIL_Handle_t railHandle, const uint8_t *dataPtr, uint16_t writeLength, bool reset);
+RAIL_Status_t RAIL_StartTx(RAIL_Handle_t railHandle, uint16_t channel, RAIL_TxOptions_t options,
+                           const void *schedulerInfo);
+RAIL_Status_t RAIL_StartScheduledTx(RAIL_Handle_t railHandle, uint16_t channel, RAIL_TxOptions_t options,
+                                    const RAIL_ScheduleTxConfig_t *config, const void *schedulerInfo);
+RAIL_Status_t RAIL_GetTxPacketDetails(RAIL_Handle_t railHandle, RAIL_TxPacketDetails_t *packetDetails);
+
+RAIL_Status_t RAIL_SetRxFifo(RAIL_Handle_t railHandle, uint8_t *addr, uint16_t *size);
+RAIL_Status_t RAIL_StartRx(RAIL_Handle_t railHandle, uint16_t channel, const void *schedulerInfo);
+RAIL_RxPacketHandle_t RAIL_GetRxPacketInfo(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle,
+                                           RAIL_RxPacketInfo_t *pPacketInfo);
+RAIL_Status_t RAIL_GetRxPacketDetails(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle,
+                                      RAIL_RxPacketDetails_t *pPacketDetails);
+void RAIL_CopyRxPacket(uint8_t *pDest, const RAIL_RxPacketInfo_t *pPacketInfo);
+RAIL_RxPacketHandle_t RAIL_HoldRxPacket(RAIL_Handle_t railHandle);
+RAIL_Status_t RAIL_ReleaseRxPacket(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle);
+
+RAIL_Time_t RAIL_StartRfSense(RAIL_Handle_t railHandle, RAIL_RfSenseBand_t band, RAIL_Time_t senseTime,
+                              RAIL_RfSense_CallbackPtr_t cb);
+bool RAIL_IsRfSensed(RAIL_Handle_t railHandle);
+
+#endif // RAIL_H
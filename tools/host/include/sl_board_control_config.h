@@ -0,0 +1,17 @@
+/***************************************************************************//**
+ * @file sl_board_control_config.h
+ * @brief Host stand-in of the board control configuration
+ *
+ * The vcom enable pin is kept so main.c builds unchanged, setting it does
+ * nothing.
+ ******************************************************************************/
+#ifndef SL_BOARD_CONTROL_CONFIG_H
+#define SL_BOARD_CONTROL_CONFIG_H
+
+#define SL_BOARD_ENABLE_VCOM      1
+#define SL_BOARD_ENABLE_VCOM_PORT 0
+#define SL_BOARD_ENABLE_VCOM_PIN  5
+
+void GPIO_PinOutSet(unsigned int port, unsigned int pin);
+
+#endif // SL_BOARD_CONTROL_CONFIG_H
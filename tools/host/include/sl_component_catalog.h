@@ -0,0 +1,16 @@
+/***************************************************************************//**
+ * @file sl_component_catalog.h
+ * @brief Components of the host build, the kernel and the power manager
+ ******************************************************************************/
+#ifndef SL_COMPONENT_CATALOG_H
+#define SL_COMPONENT_CATALOG_H
+
+#define SL_CATALOG_FREERTOS_KERNEL_PRESENT
+#define SL_CATALOG_KERNEL_PRESENT
+#define SL_CATALOG_POWER_MANAGER_PRESENT
+#define SL_CATALOG_RAIL_LIB_PRESENT
+#define SL_CATALOG_SIMPLE_LED_PRESENT
+#define SL_CATALOG_SLEEPTIMER_PRESENT
+#define SL_CATALOG_UARTDRV_USART_PRESENT
+
+#endif // SL_COMPONENT_CATALOG_H
@@ -0,0 +1,36 @@
+/***************************************************************************//**
+ * @file sl_led.h
+ * @brief Host stand-in of the LED driver, keeps the state and counts changes
+ ******************************************************************************/
+#ifndef SL_LED_H
+#define SL_LED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sl_status.h"
+
+#define SL_LED_CURRENT_STATE_OFF 0U
+#define SL_LED_CURRENT_STATE_ON  1U
+
+typedef uint8_t sl_led_state_t;
+
+typedef struct
+{
+  const char *name;
+  sl_led_state_t state;
+  uint32_t turnOns;
+} sl_led_host_context_t;
+
+typedef struct
+{
+  sl_led_host_context_t *context;
+} sl_led_t;
+
+sl_status_t sl_led_init(const sl_led_t *led_handle);
+void sl_led_turn_on(const sl_led_t *led_handle);
+void sl_led_turn_off(const sl_led_t *led_handle);
+void sl_led_toggle(const sl_led_t *led_handle);
+sl_led_state_t sl_led_get_state(const sl_led_t *led_handle);
+
+#endif // SL_LED_H
@@ -0,0 +1,22 @@
+/***************************************************************************//**
+ * @file sl_rail_util_init.h
+ * @brief Host stand-in of the RAIL instance initialization
+ ******************************************************************************/
+#ifndef SL_RAIL_UTIL_INIT_H
+#define SL_RAIL_UTIL_INIT_H
+
+#include "rail.h"
+
+typedef enum sl_rail_util_handle_type{
+  SL_RAIL_UTIL_HANDLE_INST0,
+} sl_rail_util_handle_type_t;
+
+/// Sets up the virtual radio, its RX fifo through RAILCb_SetupRxFifo()
+void sl_rail_util_init(void);
+
+RAIL_Handle_t sl_rail_util_get_handle(sl_rail_util_handle_type_t handle);
+
+/// Defined by the application, called in interrupt context
+void sl_rail_util_on_event(RAIL_Handle_t rail_handle, RAIL_Events_t events);
+
+#endif // SL_RAIL_UTIL_INIT_H
@@ -0,0 +1,15 @@
+/***************************************************************************//**
+ * @file sl_simple_led_instances.h
+ * @brief Host stand-in of the LED instances of the board
+ ******************************************************************************/
+#ifndef SL_SIMPLE_LED_INSTANCES_H
+#define SL_SIMPLE_LED_INSTANCES_H
+
+#include "sl_led.h"
+
+extern const sl_led_t sl_led_led0;
+extern const sl_led_t sl_led_led1;
+
+void sl_simple_led_init_instances(void);
+
+#endif // SL_SIMPLE_LED_INSTANCES_H
@@ -0,0 +1,19 @@
+/***************************************************************************//**
+ * @file sl_status.h
+ * @brief Host stand-in of the SDK status codes used by the stand-ins
+ ******************************************************************************/
+#ifndef SL_STATUS_H
+#define SL_STATUS_H
+
+#include <stdint.h>
+
+typedef uint32_t sl_status_t;
+
+#define SL_STATUS_OK                ((sl_status_t)0x0000)
+#define SL_STATUS_FAIL              ((sl_status_t)0x0001)
+#define SL_STATUS_INVALID_STATE     ((sl_status_t)0x0002)
+#define SL_STATUS_NOT_READY         ((sl_status_t)0x0003)
+#define SL_STATUS_INVALID_PARAMETER ((sl_status_t)0x0021)
+#define SL_STATUS_NULL_POINTER      ((sl_status_t)0x0022)
+
+#endif // SL_STATUS_H
@@ -0,0 +1,11 @@
+/***************************************************************************//**
+ * @file sl_system_init.h
+ * @brief Host stand-in of the system initialization
+ ******************************************************************************/
+#ifndef SL_SYSTEM_INIT_H
+#define SL_SYSTEM_INIT_H
+
+/// Starts the host interrupt context and the services, then the virtual radio
+void sl_system_init(void);
+
+#endif // SL_SYSTEM_INIT_H
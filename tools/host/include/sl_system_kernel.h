@@ -0,0 +1,11 @@
+/***************************************************************************//**
+ * @file sl_system_kernel.h
+ * @brief Host stand-in of the kernel start
+ ******************************************************************************/
+#ifndef SL_SYSTEM_KERNEL_H
+#define SL_SYSTEM_KERNEL_H
+
+/// Starts the scheduler, doesn't return
+void sl_system_kernel_start(void);
+
+#endif // SL_SYSTEM_KERNEL_H
@@ -0,0 +1,52 @@
+/***************************************************************************//**
+ * @file sl_uartdrv_instances.h
+ * @brief Host stand-in of the UARTDRV instance of the vcom
+ *
+ * Transmissions are written to stdout, or to the file or pty named by the
+ * SINK_VCOM environment variable ("pty" opens a new pseudo terminal and
+ * prints its name on stderr). The completion callback runs in interrupt
+ * context once the bytes are written.
+ ******************************************************************************/
+#ifndef SL_UARTDRV_INSTANCES_H
+#define SL_UARTDRV_INSTANCES_H
+
+#include <stdint.h>
+
+#include "host_irq.h"
+
+typedef uint32_t Ecode_t;
+typedef uint32_t UARTDRV_Count_t;
+
+#define ECODE_OK                       0
+#define ECODE_EMDRV_UARTDRV_OK              ECODE_OK
+#define ECODE_EMDRV_UARTDRV_ILLEGAL_HANDLE  0x00001001
+#define ECODE_EMDRV_UARTDRV_PARAM_ERROR     0x00001003
+#define ECODE_EMDRV_UARTDRV_QUEUE_FULL      0x00001005
+#define ECODE_EMDRV_UARTDRV_ABORTED         0x00001009
+
+typedef struct UARTDRV_HandleData UARTDRV_HandleData_t;
+typedef UARTDRV_HandleData_t *UARTDRV_Handle_t;
+
+typedef void (*UARTDRV_Callback_t)(UARTDRV_Handle_t handle, Ecode_t transferStatus,
+                                   uint8_t *data, UARTDRV_Count_t transferCount);
+
+struct UARTDRV_HandleData
+{
+  host_irq_timer_t done;  //First, the interrupt handler casts back to the handle
+  int fd;
+  UARTDRV_Callback_t callback;
+  uint8_t *data;
+  UARTDRV_Count_t count;
+  Ecode_t status;
+  bool busy;
+};
+
+Ecode_t UARTDRV_Transmit(UARTDRV_Handle_t handle, uint8_t *data, UARTDRV_Count_t count,
+                         UARTDRV_Callback_t callback);
+Ecode_t UARTDRV_TransmitB(UARTDRV_Handle_t handle, uint8_t *data, UARTDRV_Count_t count);
+
+extern UARTDRV_Handle_t sl_uartdrv_usart_vcom_handle;
+
+void sl_uartdrv_init_instances(void);
+
+#endif // SL_UARTDRV_INSTANCES_H
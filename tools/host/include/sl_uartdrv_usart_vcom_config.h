@@ -0,0 +1,10 @@
+/***************************************************************************//**
+ * @file sl_uartdrv_usart_vcom_config.h
+ * @brief Host stand-in of the vcom configuration, there is no USART to set up
+ ******************************************************************************/
+#ifndef SL_UARTDRV_USART_VCOM_CONFIG_H
+#define SL_UARTDRV_USART_VCOM_CONFIG_H
+
+#define SL_UARTDRV_USART_VCOM_BAUDRATE 115200
+
+#endif // SL_UARTDRV_USART_VCOM_CONFIG_H
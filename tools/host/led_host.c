@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file led_host.c
+ * @brief Host stand-in of the LED driver and the board LEDs, see sl_led.h
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "sl_simple_led_instances.h"
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static sl_led_host_context_t led0Context = { .name = "led0" };
+static sl_led_host_context_t led1Context = { .name = "led1" };
+
+const sl_led_t sl_led_led0 = { .context = &led0Context };
+const sl_led_t sl_led_led1 = { .context = &led1Context };
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sl_simple_led_init_instances(void)
+{
+  sl_led_init(&sl_led_led0);
+  sl_led_init(&sl_led_led1);
+}
+
+sl_status_t sl_led_init(const sl_led_t *led_handle)
+{
+  if (led_handle == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  led_handle->context->state = SL_LED_CURRENT_STATE_OFF;
+  led_handle->context->turnOns = 0;
+  return SL_STATUS_OK;
+}
+
+void sl_led_turn_on(const sl_led_t *led_handle)
+{
+  if (led_handle->context->state != SL_LED_CURRENT_STATE_ON) {
+    led_handle->context->turnOns++;
+  }
+  led_handle->context->state = SL_LED_CURRENT_STATE_ON;
+}
+
+void sl_led_turn_off(const sl_led_t *led_handle)
+{
+  led_handle->context->state = SL_LED_CURRENT_STATE_OFF;
+}
+
+void sl_led_toggle(const sl_led_t *led_handle)
+{
+  if (led_handle->context->state == SL_LED_CURRENT_STATE_ON) {
+    sl_led_turn_off(led_handle);
+  } else {
+    sl_led_turn_on(led_handle);
+  }
+}
+
+sl_led_state_t sl_led_get_state(const sl_led_t *led_handle)
+{
+  return led_handle->context->state;
+}
@@ -0,0 +1,272 @@
+/***************************************************************************//**
+ * @file medium_shm.c
+ * @brief Broadcast radio medium shared by host nodes through POSIX shared memory
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "medium_shm.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define MEDIUM_SHM_MAGIC   0x464C4D31UL  //"FLM1", bumped with the layout
+#define MEDIUM_SHM_MASK    (MEDIUM_SHM_RING_LENGTH - 1)
+
+/// Nodes that don't see the segment initialized within this many polls give up
+#define MEDIUM_SHM_OPEN_SPINS 100000
+
+typedef struct
+{
+  uint64_t sequence;   //Index + 1 once published, 0 while being written
+  uint64_t startUs;
+  uint64_t endUs;
+  uint32_t sender;
+  uint16_t length;
+  uint8_t data[MEDIUM_SHM_FRAME_MAX_LENGTH];
+} medium_shm_slot_t;
+
+typedef struct
+{
+  uint64_t head;       //Next index to claim
+  uint8_t padding[56]; //Keeps the claims off the line of the first slot
+  medium_shm_slot_t slots[MEDIUM_SHM_RING_LENGTH];
+} medium_shm_ring_t;
+
+struct medium_shm_layout
+{
+  uint32_t magic;      //Written last by the creator
+  uint32_t nodes;
+  medium_shm_config_t config;
+  medium_shm_ring_t rings[MEDIUM_SHM_CHANNEL_COUNT];
+};
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool readSlot(medium_shm_ring_t *ring, uint64_t index, medium_shm_slot_t *copy);
+static bool lose(medium_shm_t *medium, uint32_t lossPerMille);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+bool medium_shm_open(medium_shm_t *medium, const char *name, const medium_shm_config_t *config, uint32_t seed)
+{
+  medium_shm_layout_t *layout;
+  bool creator = true;
+  int fd;
+
+  memset(medium, 0, sizeof(*medium));
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    creator = false;
+    fd = shm_open(name, O_RDWR, 0600);
+  }
+  if (fd < 0) {
+    return false;
+  }
+  if (creator && ftruncate(fd, sizeof(medium_shm_layout_t)) != 0) {
+    close(fd);
+    shm_unlink(name);
+    return false;
+  }
+  //A node attaching right after the creator may see the segment before it's sized
+  for (uint32_t spins = 0; !creator; spins++) {
+    struct stat status;
+    if (fstat(fd, &status) == 0 && (size_t)status.st_size >= sizeof(medium_shm_layout_t)) {
+      break;
+    }
+    if (spins == MEDIUM_SHM_OPEN_SPINS) {
+      close(fd);
+      return false;
+    }
+    sched_yield();
+  }
+  layout = mmap(NULL, sizeof(medium_shm_layout_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (layout == MAP_FAILED) {
+    return false;
+  }
+
+  if (creator) {
+    //ftruncate zeroed the rings, only the configuration is left to write
+    layout->config = *config;
+    __atomic_store_n(&layout->magic, MEDIUM_SHM_MAGIC, __ATOMIC_RELEASE);
+  } else {
+    for (uint32_t spins = 0; __atomic_load_n(&layout->magic, __ATOMIC_ACQUIRE) != MEDIUM_SHM_MAGIC; spins++) {
+      if (spins == MEDIUM_SHM_OPEN_SPINS) {
+        munmap(layout, sizeof(medium_shm_layout_t));
+        return false;
+      }
+      sched_yield();
+    }
+  }
+
+  medium->layout = layout;
+  medium->node = __atomic_fetch_add(&layout->nodes, 1, __ATOMIC_RELAXED) + 1;
+  medium->random = (seed != 0) ? seed : medium->node;
+  //Frames on air before we joined aren't ours to hear
+  for (uint16_t c = 0; c < MEDIUM_SHM_CHANNEL_COUNT; c++) {
+    medium->readIndex[c] = __atomic_load_n(&layout->rings[c].head, __ATOMIC_ACQUIRE);
+  }
+  return true;
+}
+
+void medium_shm_close(medium_shm_t *medium)
+{
+  if (medium->layout != NULL) {
+    munmap(medium->layout, sizeof(medium_shm_layout_t));
+    medium->layout = NULL;
+  }
+}
+
+void medium_shm_unlink(const char *name)
+{
+  shm_unlink(name);
+}
+
+const medium_shm_config_t *medium_shm_get_config(const medium_shm_t *medium)
+{
+  return &medium->layout->config;
+}
+
+bool medium_shm_transmit(medium_shm_t *medium, uint16_t channel, const uint8_t *frame, uint16_t length,
+                         uint64_t startUs, uint64_t endUs)
+{
+  medium_shm_ring_t *ring;
+  medium_shm_slot_t *slot;
+  uint64_t index;
+
+  if (channel >= MEDIUM_SHM_CHANNEL_COUNT || length > MEDIUM_SHM_FRAME_MAX_LENGTH) {
+    return false;
+  }
+  ring = &medium->layout->rings[channel];
+  index = __atomic_fetch_add(&ring->head, 1, __ATOMIC_ACQ_REL);
+  slot = &ring->slots[index & MEDIUM_SHM_MASK];
+
+  //Readers that catch the slot between the two sequence stores see it as
+  //not yet published, or notice the change once they have copied it
+  __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  slot->startUs = startUs;
+  slot->endUs = endUs;
+  slot->sender = medium->node;
+  slot->length = length;
+  memcpy(slot->data, frame, length);
+  __atomic_store_n(&slot->sequence, index + 1, __ATOMIC_RELEASE);
+
+  medium->stats[channel].transmitted++;
+  return true;
+}
+
+uint32_t medium_shm_poll(medium_shm_t *medium, uint64_t nowUs, medium_shm_deliver_t deliver, void *context)
+{
+  medium_shm_slot_t frame;
+  medium_shm_slot_t next;
+  uint32_t delivered = 0;
+
+  for (uint16_t c = 0; c < MEDIUM_SHM_CHANNEL_COUNT; c++) {
+    medium_shm_ring_t *ring = &medium->layout->rings[c];
+    medium_shm_stats_t *stats = &medium->stats[c];
+    uint64_t *readIndex = &medium->readIndex[c];
+
+    while (true) {
+      uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+      bool collided;
+
+      if (*readIndex == head) {
+        break;
+      }
+      if (head - *readIndex > MEDIUM_SHM_RING_LENGTH) {
+        stats->overrun += (uint32_t)(head - *readIndex - MEDIUM_SHM_RING_LENGTH);
+        *readIndex = head - MEDIUM_SHM_RING_LENGTH;
+      }
+      if (!readSlot(ring, *readIndex, &frame)) {
+        uint64_t sequence = __atomic_load_n(&ring->slots[*readIndex & MEDIUM_SHM_MASK].sequence, __ATOMIC_ACQUIRE);
+        if (sequence > *readIndex + 1) {
+          //Overwritten by a later lap
+          stats->overrun++;
+          (*readIndex)++;
+          continue;
+        }
+        //Claimed but not published yet, it'll be there at the next poll
+        break;
+      }
+      if (frame.endUs > nowUs) {
+        break;
+      }
+
+      //Frames are published as they start, so anything starting before this
+      //one ends is already in the ring
+      collided = readSlot(ring, *readIndex + 1, &next) && next.startUs < frame.endUs;
+      if (*readIndex > 0 && readSlot(ring, *readIndex - 1, &next) && next.endUs > frame.startUs) {
+        collided = true;
+      }
+      (*readIndex)++;
+
+      if (frame.sender == medium->node) {
+        continue;
+      }
+      if (collided) {
+        stats->collided++;
+      } else if (lose(medium, medium->layout->config.channels[c].lossPerMille)) {
+        stats->dropped++;
+      } else {
+        stats->received++;
+        delivered++;
+        deliver(context, c, frame.data, frame.length, frame.startUs, frame.endUs);
+      }
+    }
+  }
+  return delivered;
+}
+
+const medium_shm_stats_t *medium_shm_get_stats(const medium_shm_t *medium, uint16_t channel)
+{
+  return &medium->stats[channel];
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Copies a published slot, false if it's not published or was rewritten meanwhile
+bool readSlot(medium_shm_ring_t *ring, uint64_t index, medium_shm_slot_t *copy)
+{
+  medium_shm_slot_t *slot = &ring->slots[index & MEDIUM_SHM_MASK];
+
+  if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != index + 1) {
+    return false;
+  }
+  copy->startUs = slot->startUs;
+  copy->endUs = slot->endUs;
+  copy->sender = slot->sender;
+  copy->length = slot->length;
+  if (copy->length > MEDIUM_SHM_FRAME_MAX_LENGTH) {
+    return false;
+  }
+  memcpy(copy->data, slot->data, copy->length);
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == index + 1;
+}
+
+///xorshift32, one stream per node
+bool lose(medium_shm_t *medium, uint32_t lossPerMille)
+{
+  if (lossPerMille == 0) {
+    return false;
+  }
+  medium->random ^= medium->random << 13;
+  medium->random ^= medium->random >> 17;
+  medium->random ^= medium->random << 5;
+  return (medium->random % 1000) < lossPerMille;
+}
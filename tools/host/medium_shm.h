@@ -0,0 +1,140 @@
+/***************************************************************************//**
+ * @file medium_shm.h
+ * @brief Broadcast radio medium shared by host nodes through POSIX shared memory
+ *
+ * Every node process maps the same segment. Each channel has its own ring of
+ * MEDIUM_SHM_RING_LENGTH frames, so channel 0 (2.4 GHz) and channel 1
+ * (868 MHz) never hear each other. A transmitter claims the next slot with
+ * an atomic add and publishes it with its sequence number. Receivers keep
+ * their own read position and never write to the segment, so any number of
+ * nodes read at the same time without locks. A receiver that falls more than
+ * a ring behind loses the oldest frames and counts them.
+ *
+ * Frames are published when their TX starts and delivered once their end
+ * time has passed. Two frames overlapping on a channel collide and are lost
+ * for every receiver. Each receiver also drops frames at random, at the loss
+ * rate of the channel. Bitrate, overhead and loss of the channels are set by
+ * the node that creates the segment. Later nodes use them as they are.
+ *
+ * Times are CLOCK_MONOTONIC microseconds, which all processes of a machine
+ * share. The code only uses libc, so it works with or without the kernel.
+ ******************************************************************************/
+#ifndef MEDIUM_SHM_H
+#define MEDIUM_SHM_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define MEDIUM_SHM_CHANNEL_COUNT     2
+#define MEDIUM_SHM_FRAME_MAX_LENGTH  256
+
+/// Frames kept per channel, a power of two
+#define MEDIUM_SHM_RING_LENGTH       4096
+
+#if (MEDIUM_SHM_RING_LENGTH & (MEDIUM_SHM_RING_LENGTH - 1)) != 0
+#error "MEDIUM_SHM_RING_LENGTH must be a power of two"
+#endif
+
+typedef struct
+{
+  uint32_t bitrate;        //[bit/s]
+  uint32_t overheadBits;   //Preamble, sync word and CRC
+  uint32_t lossPerMille;   //Frames each receiver drops at random
+} medium_shm_channel_config_t;
+
+typedef struct
+{
+  medium_shm_channel_config_t channels[MEDIUM_SHM_CHANNEL_COUNT];
+} medium_shm_config_t;
+
+typedef struct
+{
+  uint32_t transmitted;
+  uint32_t received;
+  uint32_t collided;
+  uint32_t dropped;   //Random loss
+  uint32_t overrun;   //Overwritten before they were read
+} medium_shm_stats_t;
+
+typedef struct medium_shm_layout medium_shm_layout_t;
+
+/// A node attached to the medium
+typedef struct
+{
+  medium_shm_layout_t *layout;
+  uint32_t node;
+  uint64_t readIndex[MEDIUM_SHM_CHANNEL_COUNT];
+  uint32_t random;
+  medium_shm_stats_t stats[MEDIUM_SHM_CHANNEL_COUNT];
+} medium_shm_t;
+
+/// Called for every frame heard, times in CLOCK_MONOTONIC microseconds
+typedef void (*medium_shm_deliver_t)(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                                     uint64_t startUs, uint64_t endUs);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Attaches to the medium, creating it if it doesn't exist yet.
+ *
+ * @param medium Node state
+ * @param name Shared memory name, e.g. "/flood_medium"
+ * @param config Channels of a new medium, ignored if it exists already
+ * @param seed Seed of the random loss, a different one per node
+ * @returns false if the segment can't be created or mapped
+ *****************************************************************************/
+bool medium_shm_open(medium_shm_t *medium, const char *name, const medium_shm_config_t *config, uint32_t seed);
+
+/**************************************************************************//**
+ * Detaches from the medium, the segment stays for the other nodes.
+ *****************************************************************************/
+void medium_shm_close(medium_shm_t *medium);
+
+/**************************************************************************//**
+ * Removes the segment, nodes still attached keep their mapping.
+ *****************************************************************************/
+void medium_shm_unlink(const char *name);
+
+/**************************************************************************//**
+ * Gives the channels the medium was created with.
+ *****************************************************************************/
+const medium_shm_config_t *medium_shm_get_config(const medium_shm_t *medium);
+
+/**************************************************************************//**
+ * Puts a frame on air.
+ *
+ * @param medium Node state
+ * @param channel Channel
+ * @param frame Frame
+ * @param length Frame length, at most MEDIUM_SHM_FRAME_MAX_LENGTH
+ * @param startUs Preamble start
+ * @param endUs Frame end
+ * @returns false if the channel or the length is invalid
+ *****************************************************************************/
+bool medium_shm_transmit(medium_shm_t *medium, uint16_t channel, const uint8_t *frame, uint16_t length,
+                         uint64_t startUs, uint64_t endUs);
+
+/**************************************************************************//**
+ * Delivers the frames of the other nodes that are over.
+ *
+ * @param medium Node state
+ * @param nowUs Current time
+ * @param deliver Called for every frame heard, in order of start per channel
+ * @param context Passed to deliver
+ * @returns Number of frames delivered
+ *****************************************************************************/
+uint32_t medium_shm_poll(medium_shm_t *medium, uint64_t nowUs, medium_shm_deliver_t deliver, void *context);
+
+/**************************************************************************//**
+ * Gives the counters of a channel, seen from this node.
+ *****************************************************************************/
+const medium_shm_stats_t *medium_shm_get_stats(const medium_shm_t *medium, uint16_t channel);
+
+#endif  // MEDIUM_SHM_H
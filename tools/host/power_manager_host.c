@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file power_manager_host.c
+ * @brief Host stand-in of the power manager, see sl_power_manager.h
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sl_power_manager.h"
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t requirements[SL_POWER_MANAGER_EM4 + 1];
+static sl_power_manager_em_transition_event_handle_t *subscribers;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sl_power_manager_add_em_requirement(sl_power_manager_em_t em)
+{
+  taskENTER_CRITICAL();
+  requirements[em]++;
+  taskEXIT_CRITICAL();
+}
+
+void sl_power_manager_remove_em_requirement(sl_power_manager_em_t em)
+{
+  taskENTER_CRITICAL();
+  configASSERT(requirements[em] > 0);
+  requirements[em]--;
+  taskEXIT_CRITICAL();
+}
+
+void sl_power_manager_sleep(void)
+{
+  //The host stays in EM0, the idle task spins instead
+}
+
+void sl_power_manager_subscribe_em_transition_event(sl_power_manager_em_transition_event_handle_t *event_handle,
+                                                    const sl_power_manager_em_transition_event_info_t *event_info)
+{
+  taskENTER_CRITICAL();
+  event_handle->info = event_info;
+  event_handle->next = subscribers;
+  subscribers = event_handle;
+  taskEXIT_CRITICAL();
+}
+
+void sl_power_manager_unsubscribe_em_transition_event(sl_power_manager_em_transition_event_handle_t *event_handle)
+{
+  sl_power_manager_em_transition_event_handle_t **link;
+
+  taskENTER_CRITICAL();
+  for (link = &subscribers; *link != NULL; link = &(*link)->next) {
+    if (*link == event_handle) {
+      *link = event_handle->next;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL();
+}
+
+uint32_t sl_power_manager_host_get_requirements(sl_power_manager_em_t em)
+{
+  return requirements[em];
+}
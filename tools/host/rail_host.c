@@ -0,0 +1,634 @@
+/***************************************************************************//**
+ * @file rail_host.c
+ * @brief Virtual radio behind the host rail.h
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "host_irq.h"
+#include "rail_host.h"
+#include "sl_rail_util_init.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef enum
+{
+  RADIO_IDLE,
+  RADIO_RX,
+  RADIO_TX
+} radio_state_t;
+
+typedef enum
+{
+  SLOT_FREE,
+  SLOT_CURRENT,  //Being reported by RAIL_EVENT_RX_PACKET_RECEIVED
+  SLOT_HELD
+} slot_state_t;
+
+typedef struct
+{
+  slot_state_t state;
+  uint32_t order;
+  uint16_t channel;
+  uint16_t length;
+  RAIL_Time_t endTime;
+  uint32_t durationUs;
+  uint8_t data[RAIL_HOST_FRAME_MAX_LENGTH];
+} rx_slot_t;
+
+typedef struct
+{
+  radio_state_t state;
+  uint16_t rxChannel;
+  uint64_t rxSinceUs;          //Listening on rxChannel without a break since
+
+  uint8_t txFrame[RAIL_HOST_FRAME_MAX_LENGTH];
+  uint16_t txLength;
+  uint16_t txFifoSize;
+  uint16_t txChannel;
+  uint64_t txStartUs;
+  uint64_t txEndUs;
+  bool txScheduled;
+  bool txDetailsValid;         //Only within RAIL_EVENT_TX_PACKET_SENT
+  host_irq_timer_t txTimer;
+
+  rx_slot_t rxSlots[RAIL_HOST_RX_SLOTS];
+  uint32_t rxOrder;
+  uint16_t rxFifoSize;
+  uint16_t rxFifoUsed;
+  uint16_t fixedLength;
+
+  RAIL_RfSenseBand_t rfSenseBand;
+  uint32_t rfSenseTimeUs;
+  RAIL_RfSense_CallbackPtr_t rfSenseCallback;
+  bool rfSensed;
+
+  RAIL_Events_t pendingEvents;
+  host_irq_timer_t eventTimer;
+
+  uint32_t entropy;
+} radio_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void startTransmit(uint16_t channel);
+static void txTimerHandler(host_irq_timer_t *timer);
+static void scheduledTxHandler(host_irq_timer_t *timer);
+static void eventTimerHandler(host_irq_timer_t *timer);
+static void pendEvents(RAIL_Events_t events);
+static bool rfSenseHears(uint16_t channel);
+static rx_slot_t *findSlot(RAIL_RxPacketHandle_t packetHandle);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static radio_t radio;
+static const rail_host_medium_t *medium;
+static rail_host_phy_t phys[RAIL_HOST_CHANNEL_COUNT] = {
+  [RAIL_HOST_CHANNEL_2G4] = { RAIL_HOST_2G4_BITRATE, RAIL_HOST_OVERHEAD_BITS },
+  [RAIL_HOST_CHANNEL_SUBGHZ] = { RAIL_HOST_SUBGHZ_BITRATE, RAIL_HOST_OVERHEAD_BITS }
+};
+static rail_host_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void rail_host_set_medium(const rail_host_medium_t *newMedium)
+{
+  taskENTER_CRITICAL();
+  medium = newMedium;
+  taskEXIT_CRITICAL();
+}
+
+void rail_host_receive(uint16_t channel, const uint8_t *frame, uint16_t length,
+                       uint64_t startUs, uint64_t endUs)
+{
+  rx_slot_t *slot = NULL;
+
+  if (radio.rfSenseCallback != NULL && rfSenseHears(channel)
+      && endUs - startUs >= radio.rfSenseTimeUs) {
+    //One shot, off once it has fired
+    RAIL_RfSense_CallbackPtr_t callback = radio.rfSenseCallback;
+    radio.rfSenseCallback = NULL;
+    radio.rfSenseBand = RAIL_RFSENSE_OFF;
+    radio.rfSensed = true;
+    stats.rfSenseWakeups++;
+    callback();
+  }
+
+  if (radio.state != RADIO_RX || radio.rxChannel != channel || radio.rxSinceUs > startUs
+      || length == 0 || length > RAIL_HOST_FRAME_MAX_LENGTH) {
+    stats.rxMissed++;
+    return;
+  }
+  for (uint32_t i = 0; i < RAIL_HOST_RX_SLOTS; i++) {
+    if (radio.rxSlots[i].state == SLOT_FREE) {
+      slot = &radio.rxSlots[i];
+      break;
+    }
+  }
+  if (slot == NULL || radio.rxFifoUsed + length > radio.rxFifoSize) {
+    stats.rxOverflows++;
+    sl_rail_util_on_event(&radio, RAIL_EVENT_RX_FIFO_OVERFLOW);
+    return;
+  }
+
+  memcpy(slot->data, frame, length);
+  slot->length = length;
+  slot->channel = channel;
+  slot->endTime = (RAIL_Time_t)endUs;
+  slot->durationUs = (uint32_t)(endUs - startUs);
+  slot->order = radio.rxOrder++;
+  slot->state = SLOT_CURRENT;
+  radio.rxFifoUsed += length;
+  stats.rxFrames[channel]++;
+
+  //RX success auto transition
+  radio.state = RADIO_IDLE;
+  sl_rail_util_on_event(&radio, RAIL_EVENT_RX_PACKET_RECEIVED);
+
+  //A packet that isn't held is gone once the event is over
+  if (slot->state == SLOT_CURRENT) {
+    slot->state = SLOT_FREE;
+    radio.rxFifoUsed -= slot->length;
+  }
+}
+
+void rail_host_set_phy(uint16_t channel, const rail_host_phy_t *phy)
+{
+  if (channel < RAIL_HOST_CHANNEL_COUNT && phy->bitrate > 0) {
+    taskENTER_CRITICAL();
+    phys[channel] = *phy;
+    taskEXIT_CRITICAL();
+  }
+}
+
+uint32_t rail_host_airtime_us(uint16_t channel, uint16_t length)
+{
+  const rail_host_phy_t *phy = &phys[(channel < RAIL_HOST_CHANNEL_COUNT) ? channel : 0];
+
+  return (uint32_t)(((uint64_t)length * 8 + phy->overheadBits) * 1000000ULL / phy->bitrate);
+}
+
+const rail_host_stats_t *rail_host_get_stats(void)
+{
+  return &stats;
+}
+
+void sl_rail_util_init(void)
+{
+  const char *seed = getenv("SINK_SEED");
+
+  radio.state = RADIO_IDLE;
+  radio.entropy = (seed != NULL) ? (uint32_t)strtoul(seed, NULL, 0)
+                                 : (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+  if (radio.entropy == 0) {
+    radio.entropy = 1;
+  }
+  RAILCb_SetupRxFifo(&radio);
+}
+
+RAIL_Handle_t sl_rail_util_get_handle(sl_rail_util_handle_type_t handle)
+{
+  (void)handle;
+  return &radio;
+}
+
+RAIL_Status_t RAIL_Calibrate(RAIL_Handle_t railHandle, void *calValues, RAIL_CalMask_t calForce)
+{
+  (void)railHandle;
+  (void)calValues;
+  (void)calForce;
+  return RAIL_STATUS_NO_ERROR;
+}
+
+RAIL_Time_t RAIL_GetTime(void)
+{
+  return (RAIL_Time_t)host_irq_now_us();
+}
+
+uint16_t RAIL_GetRadioEntropy(RAIL_Handle_t railHandle, uint8_t *buffer, uint16_t bytes)
+{
+  (void)railHandle;
+  taskENTER_CRITICAL();
+  for (uint16_t i = 0; i < bytes; i++) {
+    //xorshift32, repeatable from SINK_SEED
+    radio.entropy ^= radio.entropy << 13;
+    radio.entropy ^= radio.entropy >> 17;
+    radio.entropy ^= radio.entropy << 5;
+    buffer[i] = (uint8_t)radio.entropy;
+  }
+  taskEXIT_CRITICAL();
+  return bytes;
+}
+
+RAIL_RadioState_t RAIL_GetRadioState(RAIL_Handle_t railHandle)
+{
+  (void)railHandle;
+  switch (radio.state) {
+    case RADIO_RX:
+      return RAIL_RF_STATE_RX_ACTIVE;
+    case RADIO_TX:
+      return RAIL_RF_STATE_TX_ACTIVE;
+    default:
+      return RAIL_RF_STATE_IDLE;
+  }
+}
+
+void RAIL_Idle(RAIL_Handle_t railHandle, RAIL_IdleMode_t mode, bool wait)
+{
+  (void)railHandle;
+  (void)wait;
+  taskENTER_CRITICAL();
+  if (radio.txScheduled) {
+    host_irq_timer_stop(&radio.txTimer);
+    radio.txScheduled = false;
+  }
+  if (radio.state == RADIO_TX && mode != RAIL_IDLE) {
+    //Only the abort modes cut a frame short, RAIL_IDLE lets it end
+    host_irq_timer_stop(&radio.txTimer);
+    radio.state = RADIO_IDLE;
+    pendEvents(RAIL_EVENT_TX_ABORTED);
+  } else if (radio.state == RADIO_RX) {
+    radio.state = RADIO_IDLE;
+  }
+  taskEXIT_CRITICAL();
+}
+
+uint16_t RAIL_SetFixedLength(RAIL_Handle_t railHandle, uint16_t length)
+{
+  (void)railHandle;
+  //Frames are sent and received as written, the length only tells the layout
+  radio.fixedLength = length;
+  return length;
+}
+
+uint16_t RAIL_SetTxFifo(RAIL_Handle_t railHandle, uint8_t *addr, uint16_t initLength, uint16_t size)
+{
+  (void)railHandle;
+  (void)addr;
+  radio.txFifoSize = (size > RAIL_HOST_FRAME_MAX_LENGTH) ? RAIL_HOST_FRAME_MAX_LENGTH : size;
+  radio.txLength = (initLength > radio.txFifoSize) ? radio.txFifoSize : initLength;
+  return size;
+}
+
+uint16_t RAIL_WriteTxFifo(RAIL_Handle_t railHandle, const uint8_t *dataPtr, uint16_t writeLength, bool reset)
+{
+  (void)railHandle;
+  taskENTER_CRITICAL();
+  if (reset) {
+    radio.txLength = 0;
+  }
+  if (writeLength > radio.txFifoSize - radio.txLength) {
+    writeLength = radio.txFifoSize - radio.txLength;
+  }
+  memcpy(&radio.txFrame[radio.txLength], dataPtr, writeLength);
+  radio.txLength += writeLength;
+  taskEXIT_CRITICAL();
+  return writeLength;
+}
+
+RAIL_Status_t RAIL_StartTx(RAIL_Handle_t railHandle, uint16_t channel, RAIL_TxOptions_t options,
+                           const void *schedulerInfo)
+{
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  (void)railHandle;
+  (void)options;
+  (void)schedulerInfo;
+
+  if (channel >= RAIL_HOST_CHANNEL_COUNT) {
+    return RAIL_STATUS_INVALID_PARAMETER;
+  }
+  taskENTER_CRITICAL();
+  if (radio.state == RADIO_TX || radio.txScheduled || radio.txLength == 0) {
+    status = RAIL_STATUS_INVALID_STATE;
+  } else {
+    startTransmit(channel);
+  }
+  taskEXIT_CRITICAL();
+  return status;
+}
+
+RAIL_Status_t RAIL_StartScheduledTx(RAIL_Handle_t railHandle, uint16_t channel, RAIL_TxOptions_t options,
+                                    const RAIL_ScheduleTxConfig_t *config, const void *schedulerInfo)
+{
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  uint64_t now;
+  int64_t delayUs;
+  (void)railHandle;
+  (void)options;
+  (void)schedulerInfo;
+
+  if (channel >= RAIL_HOST_CHANNEL_COUNT || config == NULL || config->mode == RAIL_TIME_DISABLED) {
+    return RAIL_STATUS_INVALID_PARAMETER;
+  }
+  taskENTER_CRITICAL();
+  now = host_irq_now_us();
+  delayUs = (config->mode == RAIL_TIME_DELAY) ? (int64_t)config->when
+                                              : (int64_t)(int32_t)(config->when - (RAIL_Time_t)now);
+  if (radio.state == RADIO_TX || radio.txScheduled || radio.txLength == 0) {
+    status = RAIL_STATUS_INVALID_STATE;
+  } else if (delayUs < 0) {
+    //Too late, reported as an event as the radio does
+    pendEvents(RAIL_EVENT_TX_SCHEDULED_TX_MISSED);
+  } else {
+    radio.txScheduled = true;
+    radio.txChannel = channel;
+    host_irq_timer_start(&radio.txTimer, scheduledTxHandler, now + (uint64_t)delayUs);
+  }
+  taskEXIT_CRITICAL();
+  return status;
+}
+
+RAIL_Status_t RAIL_GetTxPacketDetails(RAIL_Handle_t railHandle, RAIL_TxPacketDetails_t *packetDetails)
+{
+  uint64_t time;
+  uint64_t totalUs;
+  (void)railHandle;
+
+  if (!radio.txDetailsValid) {
+    return RAIL_STATUS_INVALID_STATE;
+  }
+  //As on the radio, totalPacketBytes is an input: the frame and CRC bytes the
+  //_USED_TOTAL positions count back from the packet end
+  totalUs = (uint64_t)packetDetails->timeSent.totalPacketBytes * 8 * 1000000ULL
+            / phys[radio.txChannel].bitrate;
+  switch (packetDetails->timeSent.timePosition) {
+    case RAIL_PACKET_TIME_AT_PREAMBLE_START:
+      time = radio.txStartUs;
+      break;
+    case RAIL_PACKET_TIME_AT_PREAMBLE_START_USED_TOTAL:
+      //The CRC is the last part of the overhead, it's counted in totalPacketBytes
+      time = radio.txEndUs - totalUs - rail_host_airtime_us(radio.txChannel, 0)
+             + RAIL_HOST_CRC_BITS * 1000000ULL / phys[radio.txChannel].bitrate;
+      break;
+    case RAIL_PACKET_TIME_AT_SYNC_END:
+      time = radio.txStartUs + rail_host_airtime_us(radio.txChannel, 0)
+             - RAIL_HOST_CRC_BITS * 1000000ULL / phys[radio.txChannel].bitrate;
+      break;
+    case RAIL_PACKET_TIME_AT_SYNC_END_USED_TOTAL:
+      time = radio.txEndUs - totalUs;
+      break;
+    default:
+      packetDetails->timeSent.timePosition = RAIL_PACKET_TIME_AT_PACKET_END;
+      time = radio.txEndUs;
+      break;
+  }
+  packetDetails->timeSent.packetTime = (RAIL_Time_t)time;
+  packetDetails->timeSent.packetDurationUs = (uint32_t)(radio.txEndUs - radio.txStartUs);
+  packetDetails->isAck = false;
+  return RAIL_STATUS_NO_ERROR;
+}
+
+RAIL_Status_t RAIL_SetRxFifo(RAIL_Handle_t railHandle, uint8_t *addr, uint16_t *size)
+{
+  (void)railHandle;
+  if (addr == NULL || size == NULL || *size == 0) {
+    return RAIL_STATUS_INVALID_PARAMETER;
+  }
+  //Frames are kept in the slots, the size only bounds what can be held
+  radio.rxFifoSize = *size;
+  return RAIL_STATUS_NO_ERROR;
+}
+
+RAIL_Status_t RAIL_StartRx(RAIL_Handle_t railHandle, uint16_t channel, const void *schedulerInfo)
+{
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  (void)railHandle;
+  (void)schedulerInfo;
+
+  if (channel >= RAIL_HOST_CHANNEL_COUNT) {
+    return RAIL_STATUS_INVALID_PARAMETER;
+  }
+  taskENTER_CRITICAL();
+  if (radio.state == RADIO_TX) {
+    status = RAIL_STATUS_INVALID_STATE;
+  } else if (radio.state != RADIO_RX || radio.rxChannel != channel) {
+    radio.state = RADIO_RX;
+    radio.rxChannel = channel;
+    radio.rxSinceUs = host_irq_now_us();
+  }
+  taskEXIT_CRITICAL();
+  return status;
+}
+
+RAIL_RxPacketHandle_t RAIL_GetRxPacketInfo(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle,
+                                           RAIL_RxPacketInfo_t *pPacketInfo)
+{
+  rx_slot_t *slot;
+  (void)railHandle;
+
+  taskENTER_CRITICAL();
+  slot = findSlot(packetHandle);
+  if (slot == NULL) {
+    pPacketInfo->packetStatus = RAIL_RX_PACKET_NONE;
+    pPacketInfo->packetBytes = 0;
+    pPacketInfo->firstPortionBytes = 0;
+    pPacketInfo->firstPortionData = NULL;
+    pPacketInfo->lastPortionData = NULL;
+  } else {
+    pPacketInfo->packetStatus = RAIL_RX_PACKET_READY_SUCCESS;
+    pPacketInfo->packetBytes = slot->length;
+    pPacketInfo->firstPortionBytes = slot->length;
+    pPacketInfo->firstPortionData = slot->data;
+    pPacketInfo->lastPortionData = NULL;
+  }
+  taskEXIT_CRITICAL();
+  return slot;
+}
+
+RAIL_Status_t RAIL_GetRxPacketDetails(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle,
+                                      RAIL_RxPacketDetails_t *pPacketDetails)
+{
+  rx_slot_t *slot;
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  (void)railHandle;
+
+  taskENTER_CRITICAL();
+  slot = findSlot(packetHandle);
+  if (slot == NULL) {
+    status = RAIL_STATUS_INVALID_PARAMETER;
+  } else {
+    pPacketDetails->timeReceived.packetTime = slot->endTime;
+    pPacketDetails->timeReceived.timePosition = RAIL_PACKET_TIME_AT_PACKET_END;
+    pPacketDetails->timeReceived.totalPacketBytes = slot->length;
+    pPacketDetails->timeReceived.packetDurationUs = slot->durationUs;
+    pPacketDetails->crcPassed = true;
+    pPacketDetails->isAck = false;
+    pPacketDetails->rssi = -40;
+    pPacketDetails->lqi = 255;
+    pPacketDetails->syncWordId = 0;
+    pPacketDetails->subPhyId = 0;
+    pPacketDetails->channel = slot->channel;
+  }
+  taskEXIT_CRITICAL();
+  return status;
+}
+
+void RAIL_CopyRxPacket(uint8_t *pDest, const RAIL_RxPacketInfo_t *pPacketInfo)
+{
+  //Frames never wrap in the host fifo, the first portion is the whole frame
+  memcpy(pDest, pPacketInfo->firstPortionData, pPacketInfo->firstPortionBytes);
+}
+
+RAIL_RxPacketHandle_t RAIL_HoldRxPacket(RAIL_Handle_t railHandle)
+{
+  (void)railHandle;
+  for (uint32_t i = 0; i < RAIL_HOST_RX_SLOTS; i++) {
+    if (radio.rxSlots[i].state == SLOT_CURRENT) {
+      radio.rxSlots[i].state = SLOT_HELD;
+      return &radio.rxSlots[i];
+    }
+  }
+  return RAIL_RX_PACKET_HANDLE_INVALID;
+}
+
+RAIL_Status_t RAIL_ReleaseRxPacket(RAIL_Handle_t railHandle, RAIL_RxPacketHandle_t packetHandle)
+{
+  rx_slot_t *slot;
+  RAIL_Status_t status = RAIL_STATUS_NO_ERROR;
+  (void)railHandle;
+
+  taskENTER_CRITICAL();
+  slot = findSlot(packetHandle);
+  if (slot == NULL || slot->state != SLOT_HELD) {
+    status = RAIL_STATUS_INVALID_PARAMETER;
+  } else {
+    slot->state = SLOT_FREE;
+    radio.rxFifoUsed -= slot->length;
+  }
+  taskEXIT_CRITICAL();
+  return status;
+}
+
+RAIL_Time_t RAIL_StartRfSense(RAIL_Handle_t railHandle, RAIL_RfSenseBand_t band, RAIL_Time_t senseTime,
+                              RAIL_RfSense_CallbackPtr_t cb)
+{
+  (void)railHandle;
+  taskENTER_CRITICAL();
+  radio.rfSenseBand = band;
+  radio.rfSenseTimeUs = senseTime;
+  radio.rfSenseCallback = (band == RAIL_RFSENSE_OFF) ? NULL : cb;
+  radio.rfSensed = false;
+  taskEXIT_CRITICAL();
+  return (band == RAIL_RFSENSE_OFF) ? 0 : senseTime;
+}
+
+bool RAIL_IsRfSensed(RAIL_Handle_t railHandle)
+{
+  (void)railHandle;
+  return radio.rfSensed;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Called in a critical section with the frame in the TX fifo
+void startTransmit(uint16_t channel)
+{
+  const rail_host_medium_t *txMedium = medium;
+
+  radio.state = RADIO_TX;
+  radio.txChannel = channel;
+  radio.txStartUs = host_irq_now_us();
+  radio.txEndUs = radio.txStartUs + rail_host_airtime_us(channel, radio.txLength);
+  stats.txFrames[channel]++;
+  stats.txAirtimeUs[channel] += radio.txEndUs - radio.txStartUs;
+  if (txMedium != NULL) {
+    txMedium->transmit(txMedium->context, channel, radio.txFrame, radio.txLength,
+                       radio.txStartUs, radio.txEndUs);
+  }
+  host_irq_timer_start(&radio.txTimer, txTimerHandler, radio.txEndUs);
+}
+
+///Frame over: TX success auto transition and the completion event
+void txTimerHandler(host_irq_timer_t *timer)
+{
+  (void)timer;
+  radio.state = RADIO_IDLE;
+  radio.txDetailsValid = true;
+  sl_rail_util_on_event(&radio, RAIL_EVENT_TX_PACKET_SENT);
+  radio.txDetailsValid = false;
+  //The frame is consumed, the next one is written from an empty fifo
+  radio.txLength = 0;
+}
+
+void scheduledTxHandler(host_irq_timer_t *timer)
+{
+  (void)timer;
+  radio.txScheduled = false;
+  startTransmit(radio.txChannel);
+}
+
+void eventTimerHandler(host_irq_timer_t *timer)
+{
+  RAIL_Events_t events = radio.pendingEvents;
+  (void)timer;
+
+  radio.pendingEvents = 0;
+  if (events != 0) {
+    sl_rail_util_on_event(&radio, events);
+  }
+}
+
+///Events raised from task context are reported from interrupt context, as soon as possible
+void pendEvents(RAIL_Events_t events)
+{
+  radio.pendingEvents |= events;
+  host_irq_timer_start(&radio.eventTimer, eventTimerHandler, 0);
+}
+
+bool rfSenseHears(uint16_t channel)
+{
+  switch (radio.rfSenseBand) {
+    case RAIL_RFSENSE_2_4GHZ:
+    case RAIL_RFSENSE_2_4GHZ_LOW_SENSITIVITY:
+      return channel == RAIL_HOST_CHANNEL_2G4;
+    case RAIL_RFSENSE_SUBGHZ:
+    case RAIL_RFSENSE_SUBGHZ_LOW_SENSITIVITY:
+      return channel == RAIL_HOST_CHANNEL_SUBGHZ;
+    case RAIL_RFSENSE_ANY:
+    case RAIL_RFSENSE_ANY_LOW_SENSITIVITY:
+      return true;
+    default:
+      return false;
+  }
+}
+
+///Called in a critical section, only held or current packets are found
+rx_slot_t *findSlot(RAIL_RxPacketHandle_t packetHandle)
+{
+  rx_slot_t *found = NULL;
+
+  for (uint32_t i = 0; i < RAIL_HOST_RX_SLOTS; i++) {
+    rx_slot_t *slot = &radio.rxSlots[i];
+    if (slot->state == SLOT_FREE) {
+      continue;
+    }
+    if (packetHandle == slot) {
+      return slot;
+    }
+    if (packetHandle == RAIL_RX_PACKET_HANDLE_OLDEST
+        || packetHandle == RAIL_RX_PACKET_HANDLE_OLDEST_COMPLETE) {
+      if (found == NULL || (int32_t)(slot->order - found->order) < 0) {
+        found = slot;
+      }
+    } else if (packetHandle == RAIL_RX_PACKET_HANDLE_NEWEST) {
+      if (found == NULL || (int32_t)(slot->order - found->order) > 0) {
+        found = slot;
+      }
+    }
+  }
+  return found;
+}
@@ -0,0 +1,128 @@
+/***************************************************************************//**
+ * @file rail_host.h
+ * @brief Virtual radio behind the host rail.h
+ *
+ * One radio per process, with the state machine the sink relies on: a TX
+ * lasts the airtime of the frame, RX and TX end in IDLE as the auto
+ * transitions of config/sl_rail_util_init_inst0_config.h do, received frames
+ * stay in the RX fifo while held, and RFSense fires once on energy in its
+ * band. Events reach sl_rail_util_on_event() in interrupt context.
+ *
+ * Frames leave through a medium, none by default or the shared memory one of
+ * medium_shm.h when SINK_MEDIUM is set, and come back from it through
+ * rail_host_receive(). A frame is only received if the radio was
+ * listening on its channel for the whole frame.
+ *
+ * Channel 0 is the 2.4 GHz data channel and channel 1 the 868 MHz WUP
+ * channel, as in Protocol_Configuration_channels of the radio config.
+ ******************************************************************************/
+#ifndef RAIL_HOST_H
+#define RAIL_HOST_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rail.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RAIL_HOST_CHANNEL_COUNT     2
+#define RAIL_HOST_CHANNEL_2G4       0
+#define RAIL_HOST_CHANNEL_SUBGHZ    1
+
+/// Longest frame, the length byte counts up to 255 bytes after it
+#define RAIL_HOST_FRAME_MAX_LENGTH  256
+
+/// Frames the RX fifo holds at once, whatever their length
+#define RAIL_HOST_RX_SLOTS          16
+
+/// Default PHYs: 250 kbps on 2.4 GHz, 50 kbps on 868 MHz, both with a 40 bit
+/// preamble, 16 bit sync and 16 bit CRC. rail_host_set_phy() changes them at run time.
+#ifndef RAIL_HOST_2G4_BITRATE
+#define RAIL_HOST_2G4_BITRATE       250000
+#endif
+#ifndef RAIL_HOST_SUBGHZ_BITRATE
+#define RAIL_HOST_SUBGHZ_BITRATE    50000
+#endif
+#ifndef RAIL_HOST_OVERHEAD_BITS
+#define RAIL_HOST_OVERHEAD_BITS     (40 + 16 + 16)
+#endif
+#define RAIL_HOST_CRC_BITS          16
+
+typedef struct
+{
+  uint32_t bitrate;       //[bit/s]
+  uint32_t overheadBits;  //Preamble, sync word and CRC
+} rail_host_phy_t;
+
+/// Where transmitted frames go
+typedef struct
+{
+  /// Called when a TX starts, with the interrupts masked. startUs and endUs
+  /// are host_irq_now_us() times of the preamble start and the frame end.
+  void (*transmit)(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                   uint64_t startUs, uint64_t endUs);
+  void *context;
+} rail_host_medium_t;
+
+typedef struct
+{
+  uint32_t txFrames[RAIL_HOST_CHANNEL_COUNT];
+  uint64_t txAirtimeUs[RAIL_HOST_CHANNEL_COUNT];
+  uint32_t rxFrames[RAIL_HOST_CHANNEL_COUNT];
+  uint32_t rxMissed;        //On air while not listening on the channel for the whole frame
+  uint32_t rxOverflows;     //No room left in the RX fifo
+  uint32_t rfSenseWakeups;
+} rail_host_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets where transmitted frames go.
+ *
+ * @param medium Medium, kept by reference. NULL drops them.
+ *****************************************************************************/
+void rail_host_set_medium(const rail_host_medium_t *medium);
+
+/**************************************************************************//**
+ * Hands a frame on air to the radio, from interrupt context once it's over.
+ *
+ * RFSense wakes up on any frame of its band lasting at least its sense time.
+ *
+ * @param channel Channel the frame was sent on
+ * @param frame Frame, copied if it's received
+ * @param length Frame length
+ * @param startUs Preamble start
+ * @param endUs Frame end
+ *****************************************************************************/
+void rail_host_receive(uint16_t channel, const uint8_t *frame, uint16_t length,
+                       uint64_t startUs, uint64_t endUs);
+
+/**************************************************************************//**
+ * Sets the bitrate and the frame overhead of a channel.
+ *
+ * @param channel Channel
+ * @param phy PHY, copied
+ *****************************************************************************/
+void rail_host_set_phy(uint16_t channel, const rail_host_phy_t *phy);
+
+/**************************************************************************//**
+ * Tells how long a frame lasts on air.
+ *
+ * @param channel Channel
+ * @param length Frame length, length byte included
+ * @returns Airtime from the preamble start to the CRC end [us]
+ *****************************************************************************/
+uint32_t rail_host_airtime_us(uint16_t channel, uint16_t length);
+
+/**************************************************************************//**
+ * Gives the radio counters, updated in place.
+ *****************************************************************************/
+const rail_host_stats_t *rail_host_get_stats(void);
+
+#endif  // RAIL_HOST_H
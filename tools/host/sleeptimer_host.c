@@ -0,0 +1,205 @@
+/***************************************************************************//**
+ * @file sleeptimer_host.c
+ * @brief Host stand-in of the sleeptimer service, see sl_sleeptimer.h
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <time.h>
+
+#include "sl_sleeptimer.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SLEEPTIMER_FREQUENCY 32768UL
+
+#define US_TO_TICKS(us)    (((uint64_t)(us) * SLEEPTIMER_FREQUENCY) / 1000000ULL)
+/// First microsecond at which the tick count reaches ticks
+#define TICKS_TO_US(ticks) (((uint64_t)(ticks) * 1000000ULL + SLEEPTIMER_FREQUENCY - 1) / SLEEPTIMER_FREQUENCY)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static sl_status_t startTimer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout, uint32_t period,
+                              sl_sleeptimer_timer_callback_t callback, void *callback_data, bool restart);
+static void timerHandler(host_irq_timer_t *timer);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+sl_status_t sl_sleeptimer_start_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                      sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                      uint8_t priority, uint16_t option_flags)
+{
+  (void)priority;
+  (void)option_flags;
+  return startTimer(handle, timeout, 0, callback, callback_data, false);
+}
+
+sl_status_t sl_sleeptimer_restart_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                        sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                        uint8_t priority, uint16_t option_flags)
+{
+  (void)priority;
+  (void)option_flags;
+  return startTimer(handle, timeout, 0, callback, callback_data, true);
+}
+
+sl_status_t sl_sleeptimer_start_periodic_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                               sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                               uint8_t priority, uint16_t option_flags)
+{
+  (void)priority;
+  (void)option_flags;
+  return startTimer(handle, timeout, timeout, callback, callback_data, false);
+}
+
+sl_status_t sl_sleeptimer_start_timer_ms(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout_ms,
+                                         sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                         uint8_t priority, uint16_t option_flags)
+{
+  uint32_t ticks;
+
+  if (sl_sleeptimer_ms32_to_tick(timeout_ms, &ticks) != SL_STATUS_OK) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  return sl_sleeptimer_start_timer(handle, ticks, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_restart_timer_ms(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout_ms,
+                                           sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                           uint8_t priority, uint16_t option_flags)
+{
+  uint32_t ticks;
+
+  if (sl_sleeptimer_ms32_to_tick(timeout_ms, &ticks) != SL_STATUS_OK) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  return sl_sleeptimer_restart_timer(handle, ticks, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_start_periodic_timer_ms(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout_ms,
+                                                  sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                                  uint8_t priority, uint16_t option_flags)
+{
+  uint32_t ticks;
+
+  if (sl_sleeptimer_ms32_to_tick(timeout_ms, &ticks) != SL_STATUS_OK) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  return sl_sleeptimer_start_periodic_timer(handle, ticks, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  if (handle == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  host_irq_timer_stop(&handle->timer);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(sl_sleeptimer_timer_handle_t *handle, bool *running)
+{
+  if (handle == NULL || running == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  *running = handle->timer.running;
+  return SL_STATUS_OK;
+}
+
+void sl_sleeptimer_delay_millisecond(uint16_t time_ms)
+{
+  struct timespec delay = {
+    .tv_sec = time_ms / 1000,
+    .tv_nsec = (long)(time_ms % 1000) * 1000000L
+  };
+
+  nanosleep(&delay, NULL);
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return (uint32_t)sl_sleeptimer_get_tick_count64();
+}
+
+uint64_t sl_sleeptimer_get_tick_count64(void)
+{
+  return US_TO_TICKS(host_irq_now_us());
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return SLEEPTIMER_FREQUENCY;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return (uint32_t)(((uint64_t)tick * 1000) / SLEEPTIMER_FREQUENCY);
+}
+
+sl_status_t sl_sleeptimer_tick64_to_ms(uint64_t tick, uint64_t *ms)
+{
+  if (ms == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  *ms = (tick / SLEEPTIMER_FREQUENCY) * 1000 + ((tick % SLEEPTIMER_FREQUENCY) * 1000) / SLEEPTIMER_FREQUENCY;
+  return SL_STATUS_OK;
+}
+
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+  return (uint32_t)(((uint64_t)time_ms * SLEEPTIMER_FREQUENCY + 999) / 1000);
+}
+
+sl_status_t sl_sleeptimer_ms32_to_tick(uint32_t time_ms, uint32_t *tick)
+{
+  uint64_t ticks = ((uint64_t)time_ms * SLEEPTIMER_FREQUENCY + 999) / 1000;
+
+  if (tick == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (ticks > UINT32_MAX) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  *tick = (uint32_t)ticks;
+  return SL_STATUS_OK;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+sl_status_t startTimer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout, uint32_t period,
+                       sl_sleeptimer_timer_callback_t callback, void *callback_data, bool restart)
+{
+  if (handle == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  //Only a restart may replace a running timer
+  if (!restart && handle->timer.running) {
+    return SL_STATUS_NOT_READY;
+  }
+  handle->callback = callback;
+  handle->callback_data = callback_data;
+  handle->timeout_periodic = period;
+  //Due on a tick, as the RTCC compare is
+  host_irq_timer_start(&handle->timer, timerHandler,
+                       TICKS_TO_US(sl_sleeptimer_get_tick_count64() + timeout));
+  return SL_STATUS_OK;
+}
+
+void timerHandler(host_irq_timer_t *timer)
+{
+  sl_sleeptimer_timer_handle_t *handle = (sl_sleeptimer_timer_handle_t *)timer;
+
+  if (handle->timeout_periodic != 0) {
+    host_irq_timer_start(&handle->timer, timerHandler,
+                         TICKS_TO_US(US_TO_TICKS(timer->dueUs) + handle->timeout_periodic));
+  }
+  if (handle->callback != NULL) {
+    handle->callback(handle, handle->callback_data);
+  }
+}
@@ -0,0 +1,189 @@
+/***************************************************************************//**
+ * @file system_host.c
+ * @brief Host stand-in of the system initialization and kernel start
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "host_irq.h"
+#include "medium_shm.h"
+#include "rail_host.h"
+#include "sl_board_control_config.h"
+#include "sl_rail_util_init.h"
+#include "sl_simple_led_instances.h"
+#include "sl_system_init.h"
+#include "sl_system_kernel.h"
+#include "sl_uartdrv_instances.h"
+#include "sl_udelay.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void stopHandler(host_irq_timer_t *timer);
+static void attachMedium(const char *name);
+static void parsePair(const char *text, uint32_t values[MEDIUM_SHM_CHANNEL_COUNT]);
+static void mediumTransmit(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                           uint64_t startUs, uint64_t endUs);
+static void mediumPoll(void);
+static void mediumDeliver(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                          uint64_t startUs, uint64_t endUs);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static StaticTask_t idleTaskTCB;
+static StackType_t idleTaskStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t timerTaskTCB;
+static StackType_t timerTaskStack[configTIMER_TASK_STACK_DEPTH];
+
+static host_irq_timer_t stopTimer;
+
+static medium_shm_t medium;
+static const rail_host_medium_t shmMedium = {
+  .transmit = mediumTransmit,
+  .context = &medium
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sl_system_init(void)
+{
+  //Log lines go out as soon as they are written
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  host_irq_init();
+  sl_simple_led_init_instances();
+  sl_uartdrv_init_instances();
+  sl_rail_util_init();
+  if (getenv("SINK_MEDIUM") != NULL) {
+    attachMedium(getenv("SINK_MEDIUM"));
+  }
+  if (getenv("SINK_RUN_MS") != NULL) {
+    host_irq_timer_start(&stopTimer, stopHandler, strtoull(getenv("SINK_RUN_MS"), NULL, 0) * 1000ULL);
+  }
+}
+
+void sl_system_kernel_start(void)
+{
+  vTaskStartScheduler();
+  //Only reached if the scheduler couldn't start
+  fprintf(stderr, "scheduler failed to start\n");
+  exit(EXIT_FAILURE);
+}
+
+void sl_udelay_wait(unsigned us)
+{
+  uint64_t end = host_irq_now_us() + us;
+
+  //Busy, as on the target, short waits must not give the CPU away
+  while (host_irq_now_us() < end) {
+  }
+}
+
+void GPIO_PinOutSet(unsigned int port, unsigned int pin)
+{
+  (void)port;
+  (void)pin;
+}
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+  *ppxIdleTaskTCBBuffer = &idleTaskTCB;
+  *ppxIdleTaskStackBuffer = idleTaskStack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+  *ppxTimerTaskTCBBuffer = &timerTaskTCB;
+  *ppxTimerTaskStackBuffer = timerTaskStack;
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///SINK_RUN_MS is over. The other tasks are pthreads stopped wherever they
+///were, possibly inside libc, so the process leaves without running atexit
+///handlers or flushing stdio: stdout is unbuffered anyway.
+void stopHandler(host_irq_timer_t *timer)
+{
+  (void)timer;
+  _exit(EXIT_SUCCESS);
+}
+
+///Joins the shared medium, SINK_MEDIUM_BITRATE and SINK_MEDIUM_LOSS ("2.4 GHz[,868 MHz]",
+///loss per mille) only apply if this node creates it
+void attachMedium(const char *name)
+{
+  medium_shm_config_t config;
+  uint32_t bitrates[MEDIUM_SHM_CHANNEL_COUNT] = { RAIL_HOST_2G4_BITRATE, RAIL_HOST_SUBGHZ_BITRATE };
+  uint32_t losses[MEDIUM_SHM_CHANNEL_COUNT] = { 0, 0 };
+  const char *seed = getenv("SINK_SEED");
+
+  parsePair(getenv("SINK_MEDIUM_BITRATE"), bitrates);
+  parsePair(getenv("SINK_MEDIUM_LOSS"), losses);
+  for (uint16_t c = 0; c < MEDIUM_SHM_CHANNEL_COUNT; c++) {
+    config.channels[c].bitrate = bitrates[c];
+    config.channels[c].overheadBits = RAIL_HOST_OVERHEAD_BITS;
+    config.channels[c].lossPerMille = losses[c];
+  }
+  if (!medium_shm_open(&medium, name, &config, (seed != NULL) ? (uint32_t)strtoul(seed, NULL, 0) : 0)) {
+    perror(name);
+    exit(EXIT_FAILURE);
+  }
+  //The airtime is the one of the medium, whoever created it
+  for (uint16_t c = 0; c < MEDIUM_SHM_CHANNEL_COUNT; c++) {
+    const medium_shm_channel_config_t *channel = &medium_shm_get_config(&medium)->channels[c];
+    rail_host_phy_t phy = { channel->bitrate, channel->overheadBits };
+    rail_host_set_phy(c, &phy);
+  }
+  rail_host_set_medium(&shmMedium);
+  host_irq_set_poll(mediumPoll);
+}
+
+///"a" sets both channels, "a,b" each of them
+void parsePair(const char *text, uint32_t values[MEDIUM_SHM_CHANNEL_COUNT])
+{
+  char *end;
+
+  if (text == NULL || text[0] == '\0') {
+    return;
+  }
+  values[0] = (uint32_t)strtoul(text, &end, 0);
+  values[1] = (*end == ',') ? (uint32_t)strtoul(end + 1, NULL, 0) : values[0];
+}
+
+void mediumTransmit(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                    uint64_t startUs, uint64_t endUs)
+{
+  uint64_t epoch = host_irq_epoch_us();
+
+  medium_shm_transmit((medium_shm_t *)context, channel, frame, length, startUs + epoch, endUs + epoch);
+}
+
+void mediumPoll(void)
+{
+  medium_shm_poll(&medium, host_irq_epoch_us() + host_irq_now_us(), mediumDeliver, NULL);
+}
+
+void mediumDeliver(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                   uint64_t startUs, uint64_t endUs)
+{
+  uint64_t epoch = host_irq_epoch_us();
+  (void)context;
+
+  //Only frames started after we joined are read, they can't predate the epoch
+  rail_host_receive(channel, frame, length, startUs - epoch, endUs - epoch);
+}
@@ -0,0 +1,27 @@
+/***************************************************************************//**
+ * @file FreeRTOS.h
+ * @brief Kernel-less stand-in of the kernel types, for the host tests
+ *
+ * The tests link single firmware modules and the SDK stand-ins of the host
+ * build without the POSIX port: nothing preempts them, the kernel tick count
+ * is the one the test models, see task.h.
+ ******************************************************************************/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+#include "FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE               ((BaseType_t)0)
+#define pdTRUE                ((BaseType_t)1)
+#define pdPASS                pdTRUE
+#define pdFAIL                pdFALSE
+#define portMAX_DELAY         ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#endif // INC_FREERTOS_H
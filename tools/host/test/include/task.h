@@ -0,0 +1,17 @@
+/***************************************************************************//**
+ * @file task.h
+ * @brief Kernel-less stand-in of the task calls, for the host tests
+ ******************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+/// The test runs alone, there is nothing to mask
+#define taskENTER_CRITICAL()  do {} while (0)
+#define taskEXIT_CRITICAL()   do {} while (0)
+
+/// Kernel tick count, kept by the test
+TickType_t xTaskGetTickCount(void);
+
+#endif // INC_TASK_H
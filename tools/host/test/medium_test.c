@@ -0,0 +1,245 @@
+/***************************************************************************//**
+ * @file medium_test.c
+ * @brief Two processes exchanging a WUP and a data frame over medium_shm.c
+ *
+ * Runs without the kernel. A forked listener attaches to a fresh shared
+ * medium, then the sender puts a v2 data packet on air as the transmitter of
+ * main.c does: the frame on the sub GHz channel as the WUP, and the same
+ * frame on the 2.4 GHz channel TX_WUP_DATA_GAP_US after the WUP end, each
+ * for the airtime of its channel. The listener must hear the WUP, then the
+ * data frame, byte for byte and with the gap between them, and nothing
+ * else, before the sender reports its own side.
+ *
+ *   make check
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "medium_shm.h"
+#include "pkt.h"
+#include "rail_host.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define CHECK(condition, ...)                                         \
+  do {                                                                \
+    checks++;                                                         \
+    if (!(condition)) {                                               \
+      failures++;                                                     \
+      fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #condition); \
+      fprintf(stderr, __VA_ARGS__);                                   \
+      fprintf(stderr, "\n");                                          \
+    }                                                                 \
+  } while (0)
+
+/// Longest wait of the listener for both frames
+#define LISTEN_TIMEOUT_US 2000000ULL
+
+#define PAYLOAD_LENGTH 10
+
+typedef struct
+{
+  uint32_t count;
+  uint16_t channels[2];
+  uint8_t frames[2][MEDIUM_SHM_FRAME_MAX_LENGTH];
+  uint16_t lengths[2];
+  uint64_t startUs[2];
+  uint64_t endUs[2];
+} heard_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t checks;
+static uint32_t failures;
+
+static char mediumName[64];
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t monotonicUs(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+static void sleepUntil(uint64_t dueUs)
+{
+  uint64_t now;
+
+  while ((now = monotonicUs()) < dueUs) {
+    usleep((useconds_t)(dueUs - now));
+  }
+}
+
+static uint64_t airtimeUs(const medium_shm_t *medium, uint16_t channel, uint16_t length)
+{
+  const medium_shm_channel_config_t *config = &medium_shm_get_config(medium)->channels[channel];
+
+  return ((uint64_t)length * 8 + config->overheadBits) * 1000000ULL / config->bitrate;
+}
+
+///The frame both processes agree on, a generated packet of main.c
+static uint16_t buildFrame(uint8_t frame[PKT_FRAME_MAX_LENGTH])
+{
+  PKT_STORAGE(PAYLOAD_LENGTH) packet;
+
+  memset(&packet.header, 0, sizeof(packet.header));
+  packet.header.wupSeq = Wd;
+  packet.header.hopCount = 1;
+  packet.header.pktSeq = 0x123456;
+  packet.header.length = PAYLOAD_LENGTH;
+  for (uint32_t b = 0; b < PAYLOAD_LENGTH; b++) {
+    packet.payload[b] = (uint8_t)(0xC0 + b);
+  }
+  return pkt_encode((const pkt_t *)&packet, PKT_VERSION_2, frame);
+}
+
+static void record(void *context, uint16_t channel, const uint8_t *frame, uint16_t length,
+                   uint64_t startUs, uint64_t endUs)
+{
+  heard_t *heard = context;
+
+  if (heard->count < 2) {
+    heard->channels[heard->count] = channel;
+    memcpy(heard->frames[heard->count], frame, length);
+    heard->lengths[heard->count] = length;
+    heard->startUs[heard->count] = startUs;
+    heard->endUs[heard->count] = endUs;
+  }
+  heard->count++;
+}
+
+///Child process, its exit status is the number of failed checks
+static int listenFrames(int ready)
+{
+  medium_shm_t medium;
+  heard_t heard = { .count = 0 };
+  uint8_t expected[PKT_FRAME_MAX_LENGTH];
+  uint16_t expectedLength = buildFrame(expected);
+  uint64_t deadline;
+
+  if (!medium_shm_open(&medium, mediumName, NULL, 2)) {
+    perror(mediumName);
+    return 1;
+  }
+  //Only frames started after the open are heard, the sender waits for it
+  if (write(ready, "", 1) != 1) {
+    perror("ready");
+    return 1;
+  }
+  close(ready);
+
+  deadline = monotonicUs() + LISTEN_TIMEOUT_US;
+  while (heard.count < 2 && monotonicUs() < deadline) {
+    medium_shm_poll(&medium, monotonicUs(), record, &heard);
+    usleep(1000);
+  }
+  //Anything else on air would show up by now
+  usleep(50000);
+  medium_shm_poll(&medium, monotonicUs(), record, &heard);
+
+  CHECK(heard.count == 2, "%u frames heard", heard.count);
+  if (heard.count >= 2) {
+    CHECK(heard.channels[0] == RAIL_HOST_CHANNEL_SUBGHZ && heard.channels[1] == RAIL_HOST_CHANNEL_2G4,
+          "heard on channel %u then %u", heard.channels[0], heard.channels[1]);
+    for (uint32_t f = 0; f < 2; f++) {
+      CHECK(heard.lengths[f] == expectedLength && memcmp(heard.frames[f], expected, expectedLength) == 0,
+            "frame %u, %u bytes, differs from the %u bytes sent", f, heard.lengths[f], expectedLength);
+      CHECK(heard.endUs[f] - heard.startUs[f] == airtimeUs(&medium, heard.channels[f], expectedLength),
+            "frame %u on air for %llu us", f, (unsigned long long)(heard.endUs[f] - heard.startUs[f]));
+    }
+    CHECK(heard.startUs[1] - heard.endUs[0] == TX_WUP_DATA_GAP_US, "WUP end to data start %llu us",
+          (unsigned long long)(heard.startUs[1] - heard.endUs[0]));
+  }
+  for (uint16_t c = 0; c < MEDIUM_SHM_CHANNEL_COUNT; c++) {
+    const medium_shm_stats_t *stats = medium_shm_get_stats(&medium, c);
+
+    CHECK(stats->collided == 0 && stats->dropped == 0 && stats->overrun == 0,
+          "channel %u: %u collided, %u dropped, %u overrun", c, stats->collided, stats->dropped,
+          stats->overrun);
+  }
+  medium_shm_close(&medium);
+  printf("medium_test: listener heard %u frames, %u checks, %u failed\n", heard.count, checks, failures);
+  //Left with _exit(), stdio isn't flushed
+  fflush(stdout);
+  return (failures > 255) ? 255 : (int)failures;
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(void)
+{
+  medium_shm_config_t config = {
+    .channels = {
+      [RAIL_HOST_CHANNEL_2G4] = { RAIL_HOST_2G4_BITRATE, RAIL_HOST_OVERHEAD_BITS, 0 },
+      [RAIL_HOST_CHANNEL_SUBGHZ] = { RAIL_HOST_SUBGHZ_BITRATE, RAIL_HOST_OVERHEAD_BITS, 0 }
+    }
+  };
+  medium_shm_t medium;
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+  uint16_t length = buildFrame(frame);
+  int pipes[2];
+  char ready;
+  int status;
+  pid_t listener;
+  uint64_t wupStartUs;
+  uint64_t wupEndUs;
+  uint64_t dataStartUs;
+
+  snprintf(mediumName, sizeof(mediumName), "/flood_medium_test_%ld", (long)getpid());
+  medium_shm_unlink(mediumName);
+  if (!medium_shm_open(&medium, mediumName, &config, 1) || pipe(pipes) != 0) {
+    perror(mediumName);
+    return EXIT_FAILURE;
+  }
+
+  fflush(stdout);
+  listener = fork();
+  if (listener < 0) {
+    perror("fork");
+    medium_shm_unlink(mediumName);
+    return EXIT_FAILURE;
+  }
+  if (listener == 0) {
+    close(pipes[0]);
+    _exit(listenFrames(pipes[1]));
+  }
+  close(pipes[1]);
+  CHECK(read(pipes[0], &ready, 1) == 1, "listener didn't attach");
+  close(pipes[0]);
+
+  wupStartUs = monotonicUs();
+  wupEndUs = wupStartUs + airtimeUs(&medium, RAIL_HOST_CHANNEL_SUBGHZ, length);
+  dataStartUs = wupEndUs + TX_WUP_DATA_GAP_US;
+  CHECK(medium_shm_transmit(&medium, RAIL_HOST_CHANNEL_SUBGHZ, frame, length, wupStartUs, wupEndUs),
+        "WUP refused");
+  sleepUntil(dataStartUs);
+  CHECK(medium_shm_transmit(&medium, RAIL_HOST_CHANNEL_2G4, frame, length, dataStartUs,
+                            dataStartUs + airtimeUs(&medium, RAIL_HOST_CHANNEL_2G4, length)),
+        "data frame refused");
+
+  CHECK(waitpid(listener, &status, 0) == listener && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+        "listener failed");
+  CHECK(medium_shm_get_stats(&medium, RAIL_HOST_CHANNEL_SUBGHZ)->transmitted == 1
+        && medium_shm_get_stats(&medium, RAIL_HOST_CHANNEL_2G4)->transmitted == 1,
+        "one frame per channel counted as sent");
+  medium_shm_close(&medium);
+  medium_shm_unlink(mediumName);
+
+  printf("medium_test: %u checks, %u failed\n", checks, failures);
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
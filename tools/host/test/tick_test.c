@@ -0,0 +1,340 @@
+/***************************************************************************//**
+ * @file tick_test.c
+ * @brief Virtual time accuracy of the sleeptimer stand-in under tickless idle
+ *
+ * Runs without the kernel: sleeptimer_host.c, power_manager_host.c,
+ * sleep_monitor.c and wake_window.c are linked against the interrupt
+ * context below, on a virtual clock, and the kernel tick count is modelled
+ * as the Silicon Labs port keeps it under tickless idle: whole periods of
+ * 32768 / configTICK_RATE_HZ sleeptimer ticks, counted on every tick and
+ * stepped over the suppressed ones on wake-up, the remainder carried over.
+ *
+ * Over a virtual day of sleeps of up to 5 s, cut short at random as radio
+ * interrupts do, the test checks that the kernel time stays within 1 ms of
+ * the sleeptimer time (the drift sleep_monitor.c reports), that sleeptimer
+ * timers fire on the tick they are due and that wake windows last as long
+ * as asked and drop their EM1 requirement. The same run at 1000 Hz, the
+ * rate the firmware had before, is printed for reference.
+ *
+ *   make check
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "host_irq.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+#include "sleep_monitor.h"
+#include "wake_window.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define CHECK(condition, ...)                                         \
+  do {                                                                \
+    checks++;                                                         \
+    if (!(condition)) {                                               \
+      failures++;                                                     \
+      fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #condition); \
+      fprintf(stderr, __VA_ARGS__);                                   \
+      fprintf(stderr, "\n");                                          \
+    }                                                                 \
+  } while (0)
+
+#define DAY_US (86400ULL * 1000000ULL)
+
+/// Longest suppressed period and awake stretch [kernel ticks]
+#define SLEEP_TICKS_MAX 5000
+#define AWAKE_TICKS_MAX 50
+
+/// Window length that is no whole number of sleeptimer ticks
+#define WINDOW_MS 300
+
+typedef struct
+{
+  uint32_t rateHz;
+  uint32_t lpPerTick;    //Sleeptimer ticks per kernel tick, whole as the port takes them
+  TickType_t ticks;
+  uint64_t lastLp;       //Sleeptimer count at the last tick counted
+} kernel_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t checks;
+static uint32_t failures;
+
+///Virtual clock and the running timers of host_irq.h
+static uint64_t nowUs;
+static host_irq_timer_t *timers;
+static bool inContext;
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+///Kernel at the configured rate, xTaskGetTickCount(), and at 1000 Hz
+static kernel_t kernel;
+static kernel_t kernel1000;
+
+static sl_sleeptimer_timer_handle_t tickTimer;
+static bool tickTimerFired;
+static uint64_t tickTimerDueLp;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint32_t randomBelow(uint32_t bound)
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return (uint32_t)(((randomState * 0x2545F4914F6CDD1DULL) >> 32) % bound);
+}
+
+///Runs the timers due until untilUs, in order, in interrupt context
+static void advanceTo(uint64_t untilUs)
+{
+  while (true) {
+    host_irq_timer_t *soonest = NULL;
+
+    for (host_irq_timer_t *timer = timers; timer != NULL; timer = timer->next) {
+      if (timer->dueUs <= untilUs && (soonest == NULL || timer->dueUs < soonest->dueUs)) {
+        soonest = timer;
+      }
+    }
+    if (soonest == NULL) {
+      break;
+    }
+    host_irq_timer_stop(soonest);
+    if (soonest->dueUs > nowUs) {
+      nowUs = soonest->dueUs;
+    }
+    inContext = true;
+    soonest->handler(soonest);
+    inContext = false;
+  }
+  if (untilUs > nowUs) {
+    nowUs = untilUs;
+  }
+}
+
+static void kernelInit(kernel_t *model, uint32_t rateHz)
+{
+  model->rateHz = rateHz;
+  model->lpPerTick = sl_sleeptimer_get_timer_frequency() / rateHz;
+  model->ticks = 0;
+  model->lastLp = sl_sleeptimer_get_tick_count64();
+}
+
+///Counts the whole tick periods elapsed, as the tick interrupt and
+///vTaskStepTick() after a suppressed period do
+static void kernelUpdate(kernel_t *model)
+{
+  uint64_t periods = (sl_sleeptimer_get_tick_count64() - model->lastLp) / model->lpPerTick;
+
+  model->ticks += (TickType_t)periods;
+  model->lastLp += periods * model->lpPerTick;
+}
+
+///Kernel time minus sleeptimer time since the start [ms]
+static int64_t kernelDriftMs(const kernel_t *model, uint64_t startLp)
+{
+  uint64_t uptimeMs;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64() - startLp, &uptimeMs);
+  return (int64_t)((uint64_t)model->ticks * 1000 / model->rateHz) - (int64_t)uptimeMs;
+}
+
+static void tickTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  tickTimerFired = true;
+  CHECK(sl_sleeptimer_get_tick_count64() == tickTimerDueLp, "timer due at tick %llu fired at %llu",
+        (unsigned long long)tickTimerDueLp, (unsigned long long)sl_sleeptimer_get_tick_count64());
+}
+
+static void checkConversions(void)
+{
+  uint32_t frequency = sl_sleeptimer_get_timer_frequency();
+  uint32_t wrong = 0;
+  uint32_t ticks;
+  uint64_t ms;
+
+  CHECK(frequency % configTICK_RATE_HZ == 0, "%u Hz kernel tick isn't a whole number of sleeptimer ticks",
+        configTICK_RATE_HZ);
+  CHECK(pdMS_TO_TICKS(1000) == configTICK_RATE_HZ, "pdMS_TO_TICKS(1000) is %u", pdMS_TO_TICKS(1000));
+  for (uint32_t i = 0; i <= UINT16_MAX; i++) {
+    //Timeouts round up to the next tick, and back down to the same ms
+    if (sl_sleeptimer_tick_to_ms(sl_sleeptimer_ms_to_tick((uint16_t)i)) != i
+        || sl_sleeptimer_ms32_to_tick(i, &ticks) != SL_STATUS_OK || ticks != sl_sleeptimer_ms_to_tick((uint16_t)i)
+        || (uint64_t)ticks * 1000 < (uint64_t)i * frequency) {
+      wrong++;
+    }
+  }
+  CHECK(wrong == 0, "%u ms values convert wrong", wrong);
+  for (uint64_t i = 0; i <= 86400000; i += 7919) {
+    sl_sleeptimer_ms32_to_tick((uint32_t)i, &ticks);
+    sl_sleeptimer_tick64_to_ms(ticks, &ms);
+    if (ms != i) {
+      wrong++;
+    }
+    //A kernel delay of whole 125 ms is exact at 1024 Hz
+    if (i % 125 == 0 && (uint64_t)pdMS_TO_TICKS(i) * (frequency / configTICK_RATE_HZ) != ticks) {
+      wrong++;
+    }
+  }
+  CHECK(wrong == 0, "%u day long values convert wrong", wrong);
+}
+
+static void checkDay(void)
+{
+  uint32_t windowTicks;
+  uint64_t startLp;
+  uint64_t windowOpenLp = 0;
+  uint64_t windowRestartLp = 0;
+  bool windowWasOpen = false;
+  int64_t driftMaxMs = 0;
+  uint32_t sleeps = 0;
+  uint32_t interrupted = 0;
+  uint32_t windows = 0;
+  const sleep_monitor_stats_t *monitor;
+
+  sl_sleeptimer_ms32_to_tick(WINDOW_MS, &windowTicks);
+  wake_window_init(WINDOW_MS);
+  //Start off the tick grid, as a reset would
+  advanceTo(12345);
+  startLp = sl_sleeptimer_get_tick_count64();
+  kernelInit(&kernel, configTICK_RATE_HZ);
+  kernelInit(&kernel1000, 1000);
+  sleep_monitor_init();
+
+  while (nowUs < DAY_US) {
+    uint32_t expected = 1 + randomBelow(SLEEP_TICKS_MAX);
+    uint32_t awake = 1 + randomBelow(AWAKE_TICKS_MAX);
+    uint64_t lpNow;
+    uint64_t dueUs;
+
+    //Awake, every tick counted as it comes
+    for (uint32_t i = 0; i < awake; i++) {
+      uint64_t nextLp = kernel.lastLp + kernel.lpPerTick;
+      advanceTo((nextLp * 1000000ULL + sl_sleeptimer_get_timer_frequency() - 1) / sl_sleeptimer_get_timer_frequency());
+      kernelUpdate(&kernel);
+      kernelUpdate(&kernel1000);
+    }
+
+    //Idle, the tick suppressed until the expected wake-up or an interrupt
+    lpNow = sl_sleeptimer_get_tick_count64();
+    tickTimerDueLp = kernel.lastLp + (uint64_t)expected * kernel.lpPerTick;
+    tickTimerFired = false;
+    sl_sleeptimer_start_timer(&tickTimer, (uint32_t)(tickTimerDueLp - lpNow), tickTimerCallback, NULL, 0, 0);
+    dueUs = tickTimer.timer.dueUs;
+    if (randomBelow(3) == 0) {
+      advanceTo(nowUs + randomBelow((uint32_t)(dueUs - nowUs)));
+      if (!tickTimerFired) {
+        sl_sleeptimer_stop_timer(&tickTimer);
+        interrupted++;
+        //RFSense or a radio event, opens or extends a wake window
+        if (wake_window_is_open()) {
+          wake_window_extend();
+        } else {
+          wake_window_open();
+          windowOpenLp = sl_sleeptimer_get_tick_count64();
+        }
+        windowRestartLp = sl_sleeptimer_get_tick_count64();
+      }
+    } else {
+      advanceTo(dueUs);
+      CHECK(tickTimerFired, "tick timer due at %llu us didn't fire", (unsigned long long)dueUs);
+    }
+    sleeps++;
+    kernelUpdate(&kernel);
+    kernelUpdate(&kernel1000);
+
+    CHECK((uint64_t)kernel.ticks * kernel.lpPerTick <= sl_sleeptimer_get_tick_count64() - startLp
+          && sl_sleeptimer_get_tick_count64() - startLp < ((uint64_t)kernel.ticks + 1) * kernel.lpPerTick,
+          "%u kernel ticks at sleeptimer tick %llu", kernel.ticks,
+          (unsigned long long)(sl_sleeptimer_get_tick_count64() - startLp));
+    monitor = sleep_monitor_get_stats();
+    if (llabs(monitor->driftMs) > driftMaxMs) {
+      driftMaxMs = llabs(monitor->driftMs);
+    }
+
+    if (windowWasOpen && !wake_window_is_open()) {
+      const wake_window_stats_t *window = wake_window_get_stats();
+      windows++;
+      CHECK(window->lastLengthMs == sl_sleeptimer_tick_to_ms((uint32_t)(windowRestartLp + windowTicks - windowOpenLp)),
+            "window of %u ms, opened at tick %llu and last restarted at %llu", window->lastLengthMs,
+            (unsigned long long)windowOpenLp, (unsigned long long)windowRestartLp);
+    }
+    windowWasOpen = wake_window_is_open();
+    CHECK(sl_power_manager_host_get_requirements(SL_POWER_MANAGER_EM1) == (windowWasOpen ? 1u : 0u),
+          "%u EM1 requirements with the window %s", sl_power_manager_host_get_requirements(SL_POWER_MANAGER_EM1),
+          windowWasOpen ? "open" : "closed");
+  }
+
+  monitor = sleep_monitor_get_stats();
+  CHECK(driftMaxMs <= 1, "kernel time drifted up to %lld ms from the sleeptimer", (long long)driftMaxMs);
+  CHECK(windows > 0 && wake_window_get_stats()->windows >= windows, "%u windows closed", windows);
+  printf("tick_test: %u sleeps over %llu s, %u cut short, %u wake windows\n", sleeps,
+         (unsigned long long)(monitor->uptimeMs / 1000), interrupted, windows);
+  printf("tick_test: drift at %u Hz %d ms (at most %lld ms), at 1000 Hz %lld ms\n", configTICK_RATE_HZ,
+         monitor->driftMs, (long long)driftMaxMs, (long long)kernelDriftMs(&kernel1000, startLp));
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+uint64_t host_irq_now_us(void)
+{
+  return nowUs;
+}
+
+void host_irq_timer_start(host_irq_timer_t *timer, host_irq_handler_t handler, uint64_t dueUs)
+{
+  host_irq_timer_stop(timer);
+  timer->handler = handler;
+  timer->dueUs = dueUs;
+  timer->running = true;
+  timer->next = timers;
+  timers = timer;
+}
+
+void host_irq_timer_stop(host_irq_timer_t *timer)
+{
+  host_irq_timer_t **link;
+
+  if (!timer->running) {
+    return;
+  }
+  for (link = &timers; *link != NULL; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      break;
+    }
+  }
+  timer->running = false;
+}
+
+bool host_irq_in_context(void)
+{
+  return inContext;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+  return kernel.ticks;
+}
+
+int main(void)
+{
+  checkConversions();
+  checkDay();
+  printf("tick_test: %u checks, %u failed\n", checks, failures);
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
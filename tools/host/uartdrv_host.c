@@ -0,0 +1,121 @@
+/***************************************************************************//**
+ * @file uartdrv_host.c
+ * @brief Host stand-in of the vcom UARTDRV instance, see sl_uartdrv_instances.h
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sl_uartdrv_instances.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static Ecode_t writeAll(int fd, const uint8_t *data, UARTDRV_Count_t count);
+static void doneHandler(host_irq_timer_t *timer);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static UARTDRV_HandleData_t vcomHandleData = { .fd = STDOUT_FILENO };
+
+UARTDRV_Handle_t sl_uartdrv_usart_vcom_handle = &vcomHandleData;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sl_uartdrv_init_instances(void)
+{
+  const char *vcom = getenv("SINK_VCOM");
+  int fd;
+
+  if (vcom == NULL || vcom[0] == '\0') {
+    return;
+  }
+  if (strcmp(vcom, "pty") == 0) {
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+      perror("vcom pty");
+      exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "vcom on %s\n", ptsname(fd));
+  } else {
+    fd = open(vcom, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      perror(vcom);
+      exit(EXIT_FAILURE);
+    }
+  }
+  vcomHandleData.fd = fd;
+}
+
+Ecode_t UARTDRV_Transmit(UARTDRV_Handle_t handle, uint8_t *data, UARTDRV_Count_t count,
+                         UARTDRV_Callback_t callback)
+{
+  if (handle == NULL) {
+    return ECODE_EMDRV_UARTDRV_ILLEGAL_HANDLE;
+  }
+  if (data == NULL || count == 0) {
+    return ECODE_EMDRV_UARTDRV_PARAM_ERROR;
+  }
+  //One transfer at a time, the firmware waits for its callback anyway
+  if (handle->busy) {
+    return ECODE_EMDRV_UARTDRV_QUEUE_FULL;
+  }
+  handle->busy = true;
+  handle->status = writeAll(handle->fd, data, count);
+  handle->callback = callback;
+  handle->data = data;
+  handle->count = count;
+  //Completion is reported from interrupt context, as the DMA would
+  host_irq_timer_start(&handle->done, doneHandler, 0);
+  return ECODE_OK;
+}
+
+Ecode_t UARTDRV_TransmitB(UARTDRV_Handle_t handle, uint8_t *data, UARTDRV_Count_t count)
+{
+  if (handle == NULL) {
+    return ECODE_EMDRV_UARTDRV_ILLEGAL_HANDLE;
+  }
+  if (data == NULL || count == 0) {
+    return ECODE_EMDRV_UARTDRV_PARAM_ERROR;
+  }
+  return writeAll(handle->fd, data, count);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+Ecode_t writeAll(int fd, const uint8_t *data, UARTDRV_Count_t count)
+{
+  while (count > 0) {
+    ssize_t written = write(fd, data, count);
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return ECODE_EMDRV_UARTDRV_ABORTED;
+    }
+    data += written;
+    count -= (UARTDRV_Count_t)written;
+  }
+  return ECODE_OK;
+}
+
+void doneHandler(host_irq_timer_t *timer)
+{
+  UARTDRV_Handle_t handle = (UARTDRV_Handle_t)timer;
+
+  handle->busy = false;
+  if (handle->callback != NULL) {
+    handle->callback(handle, handle->status, handle->data, handle->count);
+  }
+}
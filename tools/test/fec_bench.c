@@ -0,0 +1,172 @@
+/***************************************************************************//**
+ * @file fec_bench.c
+ * @brief Cost of the FEC encoding and of the recovery of pkt_fec.c
+ *
+ * Blocks of full length payloads are encoded, the parity packets built and
+ * one packet per group rebuilt with pkt_fec_recover(). The times are given
+ * per data packet for the encoding and per rebuilt packet for the recovery,
+ * on the host, next to the same encoding XORing a byte at a time: the word
+ * loop of pkt_fec_xor_payload() is what they compare, the figures on the
+ * Cortex-M4 are not the same.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pkt_fec.h"
+#include "test_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) bench_packet_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static bench_packet_t packets[FEC_BLOCK_LENGTH];
+static bench_packet_t parities[FEC_PARITY_COUNT];
+static bench_packet_t rebuilt;
+static pkt_fec_encoder_t encoder;
+static uint32_t dropped;
+
+///Keeps the compiler from dropping the timed loops
+static volatile uint8_t sink;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-b blocks] [-s seed]\n"
+          "  -b blocks  blocks timed per column (default 1000000)\n"
+          "  -s seed    seed of the payloads (default 1)\n",
+          program);
+}
+
+static double wallSeconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static const pkt_t *lookup(pkt_seq_t pktSeq, void *context)
+{
+  uint32_t i = (uint32_t)pkt_seq_diff(pktSeq, packets[0].header.pktSeq);
+  (void)context;
+
+  return (i == dropped) ? NULL : (const pkt_t *)&packets[i];
+}
+
+static void encodeBlock(void)
+{
+  pkt_fec_encoder_reset(&encoder);
+  for (uint32_t i = 0; i < FEC_BLOCK_LENGTH; i++) {
+    pkt_fec_encoder_add(&encoder, (const pkt_t *)&packets[i]);
+  }
+  for (uint32_t group = 0; group < FEC_PARITY_COUNT; group++) {
+    pkt_fec_encoder_build(&encoder, group, (pkt_t *)&parities[group]);
+  }
+}
+
+///The block XORed a byte at a time, for reference
+static void encodeBlockBytewise(void)
+{
+  memset(encoder.parity, 0, sizeof(encoder.parity));
+  for (uint32_t i = 0; i < FEC_BLOCK_LENGTH; i++) {
+    uint8_t *parity = encoder.parity[i % FEC_PARITY_COUNT];
+    for (uint32_t b = 0; b < packets[i].header.length; b++) {
+      parity[b] ^= packets[i].payload[b];
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  uint64_t blocks = 1000000;
+  uint64_t seed = 1;
+  test_random_t bytes;
+  double started;
+  double encodeNs;
+  double bytewiseNs;
+  double recoverNs;
+  int option;
+
+  while ((option = getopt(argc, argv, "b:s:h")) != -1) {
+    switch (option) {
+      case 'b':
+        blocks = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (blocks == 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  test_random_seed(&bytes, seed, 0);
+  for (uint32_t i = 0; i < FEC_BLOCK_LENGTH; i++) {
+    packets[i].header.wupSeq = Wd;
+    packets[i].header.pktSeq = i;
+    packets[i].header.length = PKT_DATA_PAYLOAD_MAX_LENGTH;
+    for (uint32_t b = 0; b < PKT_DATA_PAYLOAD_MAX_LENGTH; b++) {
+      packets[i].payload[b] = (uint8_t)test_random_next(&bytes);
+    }
+  }
+
+  started = wallSeconds();
+  for (uint64_t n = 0; n < blocks; n++) {
+    packets[0].payload[0] = (uint8_t)n;
+    encodeBlock();
+    sink = parities[0].payload[0];
+  }
+  encodeNs = (wallSeconds() - started) * 1e9 / ((double)blocks * FEC_BLOCK_LENGTH);
+
+  started = wallSeconds();
+  for (uint64_t n = 0; n < blocks; n++) {
+    packets[0].payload[0] = (uint8_t)n;
+    encodeBlockBytewise();
+    sink = encoder.parity[0][0];
+  }
+  bytewiseNs = (wallSeconds() - started) * 1e9 / ((double)blocks * FEC_BLOCK_LENGTH);
+
+  encodeBlock();
+  started = wallSeconds();
+  for (uint64_t n = 0; n < blocks; n++) {
+    uint32_t group = (uint32_t)(n % FEC_PARITY_COUNT);
+
+    dropped = group;
+    if (!pkt_fec_recover((const pkt_t *)&parities[group], lookup, NULL, (pkt_t *)&rebuilt)) {
+      fprintf(stderr, "packet %u not rebuilt\n", dropped);
+      return EXIT_FAILURE;
+    }
+    sink = rebuilt.payload[0];
+  }
+  recoverNs = (wallSeconds() - started) * 1e9 / (double)blocks;
+  if (memcmp(rebuilt.payload, packets[dropped].payload, PKT_DATA_PAYLOAD_MAX_LENGTH) != 0) {
+    fprintf(stderr, "packet %u rebuilt wrong\n", dropped);
+    return EXIT_FAILURE;
+  }
+
+  printf("fec, %u packets of %u bytes per block, %u parity: encode %.1f ns per packet "
+         "(bytewise %.1f), recover %.1f ns per packet\n", FEC_BLOCK_LENGTH, PKT_DATA_PAYLOAD_MAX_LENGTH,
+         FEC_PARITY_COUNT, encodeNs, bytewiseNs, recoverNs);
+  return EXIT_SUCCESS;
+}
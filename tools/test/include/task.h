@@ -0,0 +1,17 @@
+/***************************************************************************//**
+ * @file task.h
+ * @brief Host test stand-in of the task calls the firmware modules use
+ ******************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+/// One thread, there is nothing to mask
+#define taskENTER_CRITICAL()  do {} while (0)
+#define taskEXIT_CRITICAL()   do {} while (0)
+
+/// The tests don't keep time, every packet is queued and sent at tick 0
+#define xTaskGetTickCount()   ((TickType_t)0)
+
+#endif // INC_TASK_H
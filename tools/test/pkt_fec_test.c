@@ -0,0 +1,268 @@
+/***************************************************************************//**
+ * @file pkt_fec_test.c
+ * @brief Rebuilding of lost data packets from the parity of pkt_fec.c
+ *
+ * Blocks of random payloads, of random lengths, are encoded and one packet
+ * of every parity group is dropped. pkt_fec_recover() must give it back byte
+ * for byte, zero padded up to the parity length, and must refuse the groups
+ * missing nothing or more than one packet. The blocks run across the
+ * sequence number wrap. A relay then gets blocks missing one or two packets
+ * and must rebuild the single ones without asking upstream.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <string.h>
+
+#include "pkt_fec.h"
+#include "relay.h"
+#include "test_check.h"
+#include "test_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Blocks the relay gets, the last one misses two packets of a group if the
+/// groups have two
+#define RELAY_CHECK_BLOCKS 8
+#define RELAY_CHECK_TWICE  (FEC_BLOCK_LENGTH >= 2 * FEC_PARITY_COUNT)
+
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) test_packet_t;
+
+typedef struct
+{
+  test_packet_t packets[FEC_BLOCK_LENGTH];
+  bool dropped[FEC_BLOCK_LENGTH];
+} test_block_t;
+
+typedef struct
+{
+  uint32_t requests;
+  uint32_t parities;
+  const test_packet_t *expected;  //Packet the relay must deliver next, NULL for any
+  uint32_t mismatches;
+} relay_probe_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static test_random_t payloads;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n blocks] [-s seed]\n"
+          "  -n blocks  blocks encoded (default 100000)\n"
+          "  -s seed    seed of the payloads (default 1)\n",
+          program);
+}
+
+static const pkt_t *lookup(pkt_seq_t pktSeq, void *context)
+{
+  test_block_t *block = context;
+  uint32_t i = (uint32_t)pkt_seq_diff(pktSeq, block->packets[0].header.pktSeq);
+
+  if (i >= FEC_BLOCK_LENGTH || block->dropped[i]) {
+    return NULL;
+  }
+  return (const pkt_t *)&block->packets[i];
+}
+
+static void fill(test_block_t *block, pkt_seq_t firstSeq, pkt_fec_encoder_t *encoder)
+{
+  pkt_fec_encoder_reset(encoder);
+  for (uint32_t i = 0; i < FEC_BLOCK_LENGTH; i++) {
+    test_packet_t *packet = &block->packets[i];
+
+    packet->header.wupSeq = Wd;
+    packet->header.hopCount = 1;
+    packet->header.pktSeq = pkt_seq_add(firstSeq, i);
+    packet->header.length = (uint8_t)test_random_below(&payloads, PKT_DATA_PAYLOAD_MAX_LENGTH + 1);
+    for (uint32_t b = 0; b < packet->header.length; b++) {
+      packet->payload[b] = (uint8_t)test_random_next(&payloads);
+    }
+    block->dropped[i] = false;
+    TEST_CHECK(pkt_fec_encoder_add(encoder, (const pkt_t *)packet) == (i == FEC_BLOCK_LENGTH - 1),
+               "block complete after %u packets", i + 1);
+  }
+}
+
+static void checkGroup(test_block_t *block, const pkt_t *parity)
+{
+  uint32_t group = (uint32_t)pkt_seq_diff(parity->header.pktSeq, block->packets[0].header.pktSeq);
+  uint32_t drop = group + FEC_PARITY_COUNT * test_random_below(&payloads, FEC_GROUP_LENGTH);
+  const test_packet_t *original = &block->packets[drop];
+  test_packet_t rebuilt;
+  bool rebuiltOk;
+
+  TEST_CHECK(!pkt_fec_recover(parity, lookup, block, (pkt_t *)&rebuilt), "group %u misses nothing", group);
+
+  block->dropped[drop] = true;
+  memset(&rebuilt, 0xA5, sizeof(rebuilt));
+  rebuiltOk = pkt_fec_recover(parity, lookup, block, (pkt_t *)&rebuilt);
+  TEST_CHECK(rebuiltOk && rebuilt.header.wupSeq == Wd && rebuilt.header.pktSeq == original->header.pktSeq
+             && rebuilt.header.hopCount == parity->header.hopCount,
+             "packet %u of group %u rebuilt as 0x%06X", drop, group, (unsigned)rebuilt.header.pktSeq);
+  if (rebuiltOk) {
+    bool padded = true;
+
+    for (uint32_t b = original->header.length; b < rebuilt.header.length; b++) {
+      padded = padded && rebuilt.payload[b] == 0;
+    }
+    TEST_CHECK(rebuilt.header.length == parity->header.length
+               && memcmp(rebuilt.payload, original->payload, original->header.length) == 0 && padded,
+               "payload of packet %u, %u bytes, rebuilt as %u bytes", drop, original->header.length,
+               rebuilt.header.length);
+  }
+
+  if (FEC_GROUP_LENGTH > 1) {
+    uint32_t other = (drop + FEC_PARITY_COUNT < FEC_BLOCK_LENGTH) ? drop + FEC_PARITY_COUNT : group;
+
+    block->dropped[other] = true;
+    TEST_CHECK(!pkt_fec_recover(parity, lookup, block, (pkt_t *)&rebuilt),
+               "group %u misses two packets", group);
+    block->dropped[other] = false;
+  }
+  block->dropped[drop] = false;
+}
+
+static bool probeSend(const pkt_t *packet, void *context)
+{
+  relay_probe_t *probe = context;
+
+  if (packet->header.wupSeq == Wr) {
+    probe->requests++;
+  } else if (packet->header.wupSeq == Wp) {
+    probe->parities++;
+  }
+  return true;
+}
+
+static void probeDeliver(const pkt_t *packet, void *context)
+{
+  relay_probe_t *probe = context;
+
+  if (probe->expected != NULL
+      && (packet->header.pktSeq != probe->expected->header.pktSeq
+          || memcmp(packet->payload, probe->expected->payload, probe->expected->header.length) != 0)) {
+    probe->mismatches++;
+  }
+}
+
+static uint32_t relayFrame(relay_t *relay, const pkt_t *packet)
+{
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+
+  return relay_handle_frame(relay, frame, pkt_encode(packet, PKT_VERSION_2, frame));
+}
+
+///Blocks missing one packet are rebuilt from the parity without a Wr, the
+///last block may miss two packets of a group and then asks for them
+static void checkRelay(test_block_t *block, pkt_fec_encoder_t *encoder)
+{
+  relay_probe_t probe = { 0 };
+  pkt_seq_t firstSeq = PKT_SEQ_MAX - 2 * FEC_BLOCK_LENGTH;
+  relay_t relay;
+
+  relay_init(&relay, 1, probeSend, probeDeliver, &probe);
+  for (uint32_t n = 0; n < RELAY_CHECK_BLOCKS; n++) {
+    //The first packet of the flood syncs the relay, it isn't missed
+    uint32_t drop = (n == 0) ? 1 + test_random_below(&payloads, FEC_BLOCK_LENGTH - 1)
+                    : test_random_below(&payloads, FEC_BLOCK_LENGTH);
+    bool twice = RELAY_CHECK_TWICE && n == RELAY_CHECK_BLOCKS - 1;
+    uint32_t due = RELAY_NO_REQUEST;
+
+    fill(block, firstSeq, encoder);
+    block->dropped[drop] = true;
+    if (twice) {
+      //Same group, the one before or after in the block
+      block->dropped[(drop >= FEC_PARITY_COUNT) ? drop - FEC_PARITY_COUNT : drop + FEC_PARITY_COUNT] = true;
+    }
+    probe.expected = NULL;
+    for (uint32_t i = 0; i < FEC_BLOCK_LENGTH; i++) {
+      if (!block->dropped[i] && relayFrame(&relay, (const pkt_t *)&block->packets[i]) != RELAY_NO_REQUEST) {
+        due = RELAY_WR_DELAY_MS;
+      }
+    }
+    for (uint32_t group = 0; group < FEC_PARITY_COUNT; group++) {
+      test_packet_t parity;
+
+      pkt_fec_encoder_build(encoder, group, (pkt_t *)&parity);
+      parity.header.hopCount = 1;
+      probe.expected = (drop % FEC_PARITY_COUNT == group) ? &block->packets[drop] : NULL;
+      if (relayFrame(&relay, (const pkt_t *)&parity) != RELAY_NO_REQUEST) {
+        due = RELAY_WR_DELAY_MS;
+      }
+    }
+    probe.expected = NULL;
+    if (twice) {
+      //The first packet of the next block shows the gap even at the end of this one
+      block->packets[0].header.pktSeq = pkt_seq_add(firstSeq, FEC_BLOCK_LENGTH);
+      if (relayFrame(&relay, (const pkt_t *)&block->packets[0]) != RELAY_NO_REQUEST) {
+        due = RELAY_WR_DELAY_MS;
+      }
+    }
+    while (due != RELAY_NO_REQUEST) {
+      due = relay_request(&relay);
+    }
+    TEST_CHECK(relay.stats.rebuilt == (twice ? n : n + 1), "block %u: %u packets rebuilt", n,
+               relay.stats.rebuilt);
+    TEST_CHECK((probe.requests == 0) == !twice, "block %u: %u Wr sent", n, probe.requests);
+    firstSeq = pkt_seq_add(firstSeq, FEC_BLOCK_LENGTH);
+  }
+  TEST_CHECK(probe.mismatches == 0, "%u packets rebuilt wrong", probe.mismatches);
+  TEST_CHECK(probe.parities == RELAY_CHECK_BLOCKS * FEC_PARITY_COUNT, "%u parity packets passed on",
+             probe.parities);
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  static test_block_t block;
+  static pkt_fec_encoder_t encoder;
+  uint64_t blocks = 100000;
+  uint64_t seed = 1;
+  pkt_seq_t firstSeq = PKT_SEQ_MAX - 50 * FEC_BLOCK_LENGTH;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:s:h")) != -1) {
+    switch (option) {
+      case 'n':
+        blocks = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  test_random_seed(&payloads, seed, 0);
+
+  for (uint64_t n = 0; n < blocks; n++) {
+    fill(&block, firstSeq, &encoder);
+    for (uint32_t group = 0; group < FEC_PARITY_COUNT; group++) {
+      test_packet_t parity;
+
+      pkt_fec_encoder_build(&encoder, group, (pkt_t *)&parity);
+      parity.header.hopCount = 1;
+      TEST_CHECK(parity.header.wupSeq == Wp && parity.header.pktSeq == pkt_seq_add(firstSeq, group),
+                 "parity %u of 0x%06X", group, (unsigned)firstSeq);
+      checkGroup(&block, (const pkt_t *)&parity);
+    }
+    firstSeq = pkt_seq_add(firstSeq, FEC_BLOCK_LENGTH);
+  }
+  checkRelay(&block, &encoder);
+
+  printf("pkt_fec_test: %llu blocks of %u packets, %u parity each\n", (unsigned long long)blocks,
+         FEC_BLOCK_LENGTH, FEC_PARITY_COUNT);
+  return test_check_result("pkt_fec_test");
+}
@@ -0,0 +1,277 @@
+/***************************************************************************//**
+ * @file pkt_pool_test.c
+ * @brief Reference counting of pkt_pool.c under a storm of retransmission requests
+ *
+ * The packets are shared as on the sink: the generator allocates them,
+ * the retransmission buffer and the transmit queues each hold a reference,
+ * bursts of selective Wr put the stored ones in the resend set and every
+ * flush queues them again. Against a count of the references each owner
+ * holds, the test checks that no slot in use is handed out again, that every
+ * slot nobody holds is back in the pool, and that the classes don't mix.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <string.h>
+
+#include "pkt_pool.h"
+#include "resend_set.h"
+#include "retransmission_buffer.h"
+#include "test_check.h"
+#include "test_random.h"
+#include "tx_scheduler.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Steps between two counts of the free slots
+#define CHECK_PERIOD 997
+
+/// Most Wr in a burst, and most packets the transmitter sends per step
+#define BURST_MAX 24
+#define SEND_MAX  4
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static test_random_t steps;
+
+///References held per slot by the transmit queues
+static uint32_t queued[PKT_POOL_TOTAL_LENGTH];
+static pkt_seq_t pktSequenceNumber;
+static bool generated;
+
+static uint32_t allocFailures;
+static uint32_t queueDrops;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n steps] [-s seed]\n"
+          "  -n steps  storm steps (default 1000000)\n"
+          "  -s seed   seed of the storm (default 1)\n",
+          program);
+}
+
+static bool inBuffer(pkt_pool_index_t index)
+{
+  for (uint32_t i = 0; generated && i < RETRANSMISSION_BUFFER_DEFAULT_LENGTH; i++) {
+    if (retransmission_buffer_lookup(pkt_seq_add(pktSequenceNumber, PKT_SEQ_MAX + 1 - i)) == index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool inUse(pkt_pool_index_t index)
+{
+  return queued[index] > 0 || inBuffer(index);
+}
+
+///enqueue() of sink.c
+static void enqueue(tx_class_t txClass, pkt_pool_index_t index)
+{
+  if (tx_scheduler_enqueue(txClass, index)) {
+    queued[index]++;
+  } else {
+    queueDrops++;
+    pkt_pool_unref(index);
+  }
+}
+
+///Allocates every free slot of a class, then gives them back
+static uint32_t countFree(pkt_class_t slotClass)
+{
+  pkt_pool_index_t taken[PKT_POOL_TOTAL_LENGTH];
+  uint32_t count = 0;
+  pkt_pool_index_t index;
+
+  while ((index = pkt_pool_alloc(slotClass)) != PKT_POOL_INVALID_INDEX) {
+    TEST_CHECK(count < PKT_POOL_TOTAL_LENGTH, "more slots handed out than the pool has");
+    TEST_CHECK(!inUse(index), "slot %u handed out while in use", index);
+    TEST_CHECK((index < PKT_POOL_CONTROL_LENGTH) == (slotClass == PKT_CLASS_CONTROL),
+               "slot %u handed out for the wrong class", index);
+    if (count == PKT_POOL_TOTAL_LENGTH) {
+      break;
+    }
+    taken[count++] = index;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    pkt_pool_unref(taken[i]);
+  }
+  return count;
+}
+
+static void checkFree(void)
+{
+  uint32_t used[PKT_CLASS_DATA + 1] = { 0 };
+
+  for (pkt_pool_index_t index = 0; index < PKT_POOL_TOTAL_LENGTH; index++) {
+    used[(index < PKT_POOL_CONTROL_LENGTH) ? PKT_CLASS_CONTROL : PKT_CLASS_DATA] += inUse(index);
+  }
+  TEST_CHECK(countFree(PKT_CLASS_DATA) + used[PKT_CLASS_DATA] == PKT_POOL_DEFAULT_LENGTH,
+             "%u data slots in use, the rest isn't free", used[PKT_CLASS_DATA]);
+  TEST_CHECK(countFree(PKT_CLASS_CONTROL) + used[PKT_CLASS_CONTROL] == PKT_POOL_CONTROL_LENGTH,
+             "%u control slots in use, the rest isn't free", used[PKT_CLASS_CONTROL]);
+}
+
+static void generate(void)
+{
+  pkt_pool_index_t index = pkt_pool_alloc(PKT_CLASS_DATA);
+  pkt_t *packet;
+
+  if (index == PKT_POOL_INVALID_INDEX) {
+    allocFailures++;
+    return;
+  }
+  TEST_CHECK(!inUse(index), "slot %u allocated while in use", index);
+  pktSequenceNumber = generated ? pkt_seq_add(pktSequenceNumber, 1) : 0;
+  generated = true;
+  packet = pkt_pool_get(index);
+  packet->header.wupSeq = Wd;
+  packet->header.pktSeq = pktSequenceNumber;
+  packet->header.length = (uint8_t)pkt_pool_capacity(index);
+  memset(packet->payload, (int)pktSequenceNumber, packet->header.length);
+  retransmission_buffer_insert(index);
+  enqueue(TX_CLASS_DATA, index);
+}
+
+///A beacon in a control slot, shares the queues with the data
+static void beacon(void)
+{
+  pkt_pool_index_t index = pkt_pool_alloc(PKT_CLASS_CONTROL);
+
+  if (index == PKT_POOL_INVALID_INDEX) {
+    allocFailures++;
+    return;
+  }
+  pkt_pool_get(index)->header.wupSeq = Wb;
+  enqueue(TX_CLASS_BEACON, index);
+}
+
+///retransmit() of sink.c
+static void retransmit(pkt_pool_index_t index, void *context)
+{
+  (void)context;
+  pkt_pool_ref(index);
+  enqueue(TX_CLASS_RETRANSMISSION, index);
+}
+
+///Selective Wr from several relays, each missing a few of the stored packets
+static void requestBurst(void)
+{
+  uint32_t requests = 1 + test_random_below(&steps, BURST_MAX);
+
+  for (uint32_t r = 0; generated && r < requests; r++) {
+    uint8_t lost[PKT_WR_BITMAP_BITS / 8] = { 0 };
+    uint32_t back = test_random_below(&steps, RETRANSMISSION_BUFFER_DEFAULT_LENGTH + 4);
+    uint32_t bits = test_random_below(&steps, ((back < PKT_WR_BITMAP_BITS) ? back : PKT_WR_BITMAP_BITS) + 1);
+
+    for (uint32_t i = 0; i < bits; i++) {
+      if (test_random_below(&steps, 4) == 0) {
+        lost[i / 8] |= (uint8_t)(1u << (i % 8));
+      }
+    }
+    retransmission_buffer_for_each_in_bitmap(pkt_seq_add(pktSequenceNumber, PKT_SEQ_MAX + 1 - back),
+                                             lost, bits, resend_set_add, NULL);
+  }
+}
+
+static void send(void)
+{
+  uint32_t count = 1 + test_random_below(&steps, SEND_MAX);
+  pkt_pool_index_t index;
+
+  for (uint32_t i = 0; i < count && tx_scheduler_dequeue(&index, 0); i++) {
+    const pkt_t *packet = pkt_pool_get(index);
+
+    TEST_CHECK(queued[index] > 0, "slot %u dequeued but not queued", index);
+    queued[index]--;
+    if (packet->header.wupSeq == Wd) {
+      TEST_CHECK(packet->header.length == 0 || packet->payload[packet->header.length - 1]
+                 == (uint8_t)packet->header.pktSeq, "slot %u overwritten while queued", index);
+    }
+    pkt_pool_unref(index);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  uint64_t stepCount = 1000000;
+  uint64_t seed = 1;
+  pkt_pool_index_t index;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:s:h")) != -1) {
+    switch (option) {
+      case 'n':
+        stepCount = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  test_random_seed(&steps, seed, 0);
+  pkt_pool_init();
+  retransmission_buffer_init();
+  resend_set_init();
+  tx_scheduler_init();
+
+  checkFree();
+  for (uint64_t step = 1; step <= stepCount; step++) {
+    switch (test_random_below(&steps, 16)) {
+      case 0:
+      case 1:
+      case 2:
+        generate();
+        break;
+      case 3:
+        beacon();
+        break;
+      case 4:
+      case 5:
+      case 6:
+        requestBurst();
+        break;
+      case 7:
+        resend_set_flush(retransmit, NULL);
+        break;
+      default:
+        send();
+        break;
+    }
+    if (step % CHECK_PERIOD == 0) {
+      checkFree();
+    }
+  }
+
+  //Drain, only the retransmission buffer keeps its references
+  resend_set_flush(retransmit, NULL);
+  while (tx_scheduler_dequeue(&index, 0)) {
+    queued[index]--;
+    pkt_pool_unref(index);
+  }
+  for (uint32_t i = 0; i < PKT_POOL_TOTAL_LENGTH; i++) {
+    TEST_CHECK(queued[i] == 0, "slot %u still counted as queued", i);
+  }
+  checkFree();
+  TEST_CHECK(countFree(PKT_CLASS_DATA) == PKT_POOL_DEFAULT_LENGTH - RETRANSMISSION_BUFFER_DEFAULT_LENGTH,
+             "the retransmission buffer holds more than its length");
+
+  printf("pkt_pool_test: %llu steps, %u packets, %u allocations and %u enqueues refused, %u resent\n",
+         (unsigned long long)stepCount, (unsigned)pktSequenceNumber + 1, allocFailures, queueDrops,
+         resend_set_get_stats()->resent);
+  return test_check_result("pkt_pool_test");
+}
@@ -0,0 +1,200 @@
+/***************************************************************************//**
+ * @file pkt_seq_test.c
+ * @brief Sequence number wraparound of pkt.c and of the modules keyed on it
+ *
+ * Sequence numbers wrap at PKT_SEQ_MAX on air in v2 frames and at 16 bits in
+ * v1 frames. The helpers, the frame layouts, the retransmission buffer and
+ * a relay are run across both wraps.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+
+#include "pkt.h"
+#include "pkt_pool.h"
+#include "relay.h"
+#include "retransmission_buffer.h"
+#include "test_check.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define HALF (1L << (PKT_SEQ_BITS - 1))
+
+/// Sequence number count steps before pktSeq
+#define SEQ_BACK(pktSeq, count) pkt_seq_add((pktSeq), PKT_SEQ_MAX + 1 - (count))
+
+typedef struct
+{
+  uint32_t sent;
+  uint32_t requests;
+  pkt_seq_t requestSeq;
+} relay_probe_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void checkHelpers(void)
+{
+  TEST_CHECK(pkt_seq_add(PKT_SEQ_MAX, 1) == 0, "wraps to 0");
+  TEST_CHECK(pkt_seq_add(PKT_SEQ_MAX - 2, 5) == 2, "steps over the wrap");
+  TEST_CHECK(SEQ_BACK(1, 3) == PKT_SEQ_MAX - 1, "steps back over the wrap");
+  TEST_CHECK(pkt_seq_diff(0, PKT_SEQ_MAX) == 1, "0 is newer than PKT_SEQ_MAX");
+  TEST_CHECK(pkt_seq_diff(PKT_SEQ_MAX, 0) == -1, "PKT_SEQ_MAX is older than 0");
+  TEST_CHECK(pkt_seq_diff(5, PKT_SEQ_MAX - 4) == 10, "distance over the wrap");
+  TEST_CHECK(pkt_seq_diff(HALF - 1, 0) == HALF - 1, "newest distance taken as newer");
+  TEST_CHECK(pkt_seq_diff(HALF, 0) == -HALF, "half the space apart is older");
+
+  //Every 16 bit value within half the v1 space of the reference, around both wraps
+  const pkt_seq_t references[] = { 0, 1, 0x7FFF, 0xFFFF, 0x10000, PKT_SEQ_MAX - 0x7FFF, PKT_SEQ_MAX };
+  for (uint32_t r = 0; r < sizeof(references) / sizeof(references[0]); r++) {
+    uint32_t failures = 0;
+    for (int32_t delta = -0x8000; delta < 0x8000; delta++) {
+      pkt_seq_t expected = pkt_seq_add(references[r], (uint32_t)delta & PKT_SEQ_MAX);
+      if (pkt_seq_extend(references[r], expected & 0xFFFF, PKT_V1_SEQ_BITS) != expected) {
+        failures++;
+      }
+    }
+    TEST_CHECK(failures == 0, "%u wrong extensions around 0x%06X", failures, (unsigned)references[r]);
+  }
+}
+
+static void checkFrames(void)
+{
+  const pkt_seq_t sequences[] = { 0, 0xFFFF, 0x10000, PKT_SEQ_MAX };
+  PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) packet = { 0 };
+  PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) decoded;
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+
+  packet.header.wupSeq = Wd;
+  packet.header.hopCount = 1;
+  packet.header.length = 4;
+  for (uint32_t s = 0; s < sizeof(sequences) / sizeof(sequences[0]); s++) {
+    uint16_t length;
+
+    packet.header.pktSeq = sequences[s];
+    length = pkt_encode((pkt_t *)&packet, PKT_VERSION_2, frame);
+    TEST_CHECK(pkt_decode(frame, length, (pkt_t *)&decoded, sizeof(decoded.payload)) == PKT_VERSION_2
+               && decoded.header.pktSeq == sequences[s], "v2 keeps 0x%06X", (unsigned)sequences[s]);
+    length = pkt_encode((pkt_t *)&packet, PKT_VERSION_1, frame);
+    TEST_CHECK(pkt_decode(frame, length, (pkt_t *)&decoded, sizeof(decoded.payload)) == PKT_VERSION_1
+               && decoded.header.pktSeq == (sequences[s] & 0xFFFF), "v1 keeps the low bits of 0x%06X",
+               (unsigned)sequences[s]);
+  }
+}
+
+static void countVisit(pkt_pool_index_t index, void *context)
+{
+  (void)index;
+  (*(uint32_t *)context)++;
+}
+
+static void checkRetransmissionBuffer(void)
+{
+  pkt_seq_t first = SEQ_BACK(0, RETRANSMISSION_BUFFER_DEFAULT_LENGTH / 2);
+  pkt_seq_t newest = pkt_seq_add(first, RETRANSMISSION_BUFFER_DEFAULT_LENGTH - 1);
+  uint8_t lost[1] = { 0x05 };
+  uint32_t visited = 0;
+  pkt_pool_index_t index;
+
+  pkt_pool_init();
+  retransmission_buffer_init();
+  for (uint32_t i = 0; i <= RETRANSMISSION_BUFFER_DEFAULT_LENGTH; i++) {
+    index = pkt_pool_alloc(PKT_CLASS_DATA);
+    pkt_pool_get(index)->header.pktSeq = pkt_seq_add(first, i);
+    retransmission_buffer_insert(index);
+    pkt_pool_unref(index);
+  }
+  newest = pkt_seq_add(newest, 1);
+  TEST_CHECK(retransmission_buffer_lookup(first) == PKT_POOL_INVALID_INDEX, "oldest evicted");
+  for (uint32_t i = 1; i <= RETRANSMISSION_BUFFER_DEFAULT_LENGTH; i++) {
+    pkt_seq_t pktSeq = pkt_seq_add(first, i);
+    index = retransmission_buffer_lookup(pktSeq);
+    TEST_CHECK(index != PKT_POOL_INVALID_INDEX && pkt_pool_get(index)->header.pktSeq == pktSeq,
+               "0x%06X stored", (unsigned)pktSeq);
+  }
+
+  TEST_CHECK(retransmission_buffer_for_each_from(SEQ_BACK(0, 2), countVisit, &visited)
+             == RETRANSMISSION_BUFFER_DEFAULT_LENGTH / 2 + 1 + 2, "range walk over the wrap");
+  visited = 0;
+  TEST_CHECK(retransmission_buffer_for_each_from(pkt_seq_add(newest, 1), countVisit, &visited) == 0
+             && visited == 0, "nothing newer than the newest");
+  TEST_CHECK(retransmission_buffer_for_each_in_bitmap(PKT_SEQ_MAX, lost, 8, countVisit, &visited) == 3,
+             "bitmap walk over the wrap");
+}
+
+static bool probeSend(const pkt_t *packet, void *context)
+{
+  relay_probe_t *probe = context;
+
+  probe->sent++;
+  if (packet->header.wupSeq == Wr) {
+    probe->requests++;
+    probe->requestSeq = packet->header.pktSeq;
+  }
+  return true;
+}
+
+static uint32_t relayData(relay_t *relay, pkt_seq_t pktSeq, uint8_t version)
+{
+  PKT_STORAGE(PKT_V1_PAYLOAD_LENGTH) packet = { 0 };
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+
+  packet.header.wupSeq = Wd;
+  packet.header.hopCount = 1;
+  packet.header.length = PKT_V1_PAYLOAD_LENGTH;
+  packet.header.pktSeq = pktSeq;
+  return relay_handle_frame(relay, frame, pkt_encode((pkt_t *)&packet, version, frame));
+}
+
+static void checkRelay(void)
+{
+  relay_probe_t probe = { 0 };
+  relay_t relay;
+
+  //24 bit wrap, 0 skipped then asked for
+  relay_init(&relay, 1, probeSend, NULL, &probe);
+  for (pkt_seq_t pktSeq = PKT_SEQ_MAX - 3; pktSeq != 0; pktSeq = pkt_seq_add(pktSeq, 1)) {
+    TEST_CHECK(relayData(&relay, pktSeq, PKT_VERSION_2) == RELAY_NO_REQUEST, "no gap at 0x%06X",
+               (unsigned)pktSeq);
+  }
+  TEST_CHECK(relayData(&relay, 1, PKT_VERSION_2) == RELAY_WR_DELAY_MS, "gap at 0");
+  TEST_CHECK(relay_request(&relay) == RELAY_WR_RETRY_MS && probe.requests == 1 && probe.requestSeq == 0,
+             "Wr asks for 0, got 0x%06X", (unsigned)probe.requestSeq);
+  relayData(&relay, 0, PKT_VERSION_2);
+  relayData(&relay, PKT_SEQ_MAX, PKT_VERSION_2);
+  TEST_CHECK(relay.stats.received == 6 && relay.stats.gaps == 1 && relay.stats.recovered == 1
+             && relay.stats.duplicates == 1 && relay.stats.abandoned == 0,
+             "received %u gaps %u recovered %u duplicates %u abandoned %u", relay.stats.received,
+             relay.stats.gaps, relay.stats.recovered, relay.stats.duplicates, relay.stats.abandoned);
+  TEST_CHECK(relay_request(&relay) == RELAY_NO_REQUEST, "nothing left to ask for");
+
+  //v1 frames extended over their 16 bit wrap and the 24 bit one
+  const pkt_seq_t starts[] = { 0xFFF0, PKT_SEQ_MAX - 0x10 };
+  for (uint32_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+    relay_init(&relay, 1, probeSend, NULL, &probe);
+    relayData(&relay, starts[s], PKT_VERSION_2);
+    for (uint32_t i = 1; i < 0x40; i++) {
+      relayData(&relay, pkt_seq_add(starts[s], i), PKT_VERSION_1);
+    }
+    relayData(&relay, pkt_seq_add(starts[s], 0x20), PKT_VERSION_1);
+    TEST_CHECK(relay.highest == pkt_seq_add(starts[s], 0x3F) && relay.stats.received == 0x40
+               && relay.stats.gaps == 0 && relay.stats.duplicates == 1,
+               "v1 from 0x%06X: highest 0x%06X received %u gaps %u duplicates %u", (unsigned)starts[s],
+               (unsigned)relay.highest, relay.stats.received, relay.stats.gaps, relay.stats.duplicates);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(void)
+{
+  checkHelpers();
+  checkFrames();
+  checkRetransmissionBuffer();
+  checkRelay();
+  return test_check_result("pkt_seq_test");
+}
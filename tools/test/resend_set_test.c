@@ -0,0 +1,234 @@
+/***************************************************************************//**
+ * @file resend_set_test.c
+ * @brief Coalescing of resend_set.c under bursts of retransmission requests
+ *
+ * Bursts of selective and legacy Wr land between flushes while new packets
+ * push the oldest ones out of the retransmission buffer, as on the sink
+ * while the coalescing window is open. Every flush is checked against a
+ * model of the set: each packet requested in the window is handed over
+ * once, in the order it was first asked for, unless it left the buffer in
+ * the meantime or came after the set ran full.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <string.h>
+
+#include "pkt_pool.h"
+#include "resend_set.h"
+#include "retransmission_buffer.h"
+#include "test_check.h"
+#include "test_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define LENGTH RETRANSMISSION_BUFFER_DEFAULT_LENGTH
+
+/// Most Wr between two flushes, and how far back they may ask
+#define BURST_MAX 12
+#define REACH     (LENGTH + 8)
+
+typedef struct
+{
+  pkt_seq_t sequences[LENGTH];
+  uint32_t count;
+} visit_list_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static test_random_t steps;
+static pkt_seq_t newest;
+
+///The set as it should be: distinct sequence numbers in first request order
+static pkt_seq_t model[LENGTH];
+static uint32_t modelCount;
+static uint32_t modelDuplicates;
+static uint32_t modelRefused;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n windows] [-s seed]\n"
+          "  -n windows  coalescing windows (default 200000)\n"
+          "  -s seed     seed of the requests (default 1)\n",
+          program);
+}
+
+static void generate(void)
+{
+  pkt_pool_index_t index = pkt_pool_alloc(PKT_CLASS_DATA);
+
+  newest = pkt_seq_add(newest, 1);
+  pkt_pool_get(index)->header.wupSeq = Wd;
+  pkt_pool_get(index)->header.pktSeq = newest;
+  retransmission_buffer_insert(index);
+  pkt_pool_unref(index);
+}
+
+static bool stored(pkt_seq_t pktSeq)
+{
+  return retransmission_buffer_lookup(pktSeq) != PKT_POOL_INVALID_INDEX;
+}
+
+static void modelAdd(pkt_seq_t pktSeq)
+{
+  for (uint32_t i = 0; i < modelCount; i++) {
+    if (model[i] == pktSeq) {
+      modelDuplicates++;
+      return;
+    }
+  }
+  if (modelCount == LENGTH) {
+    modelRefused++;
+    return;
+  }
+  model[modelCount++] = pktSeq;
+}
+
+static void record(pkt_pool_index_t index, void *context)
+{
+  visit_list_t *visits = context;
+
+  TEST_CHECK(visits->count < LENGTH, "more packets flushed than the set holds");
+  if (visits->count < LENGTH) {
+    visits->sequences[visits->count++] = pkt_pool_get(index)->header.pktSeq;
+  }
+}
+
+///A selective Wr, or a legacy one
+static void request(void)
+{
+  pkt_seq_t base = pkt_seq_add(newest, PKT_SEQ_MAX + 1 - test_random_below(&steps, REACH));
+
+  if (test_random_below(&steps, 4) == 0) {
+    //The packet and every newer one, if the packet is still stored
+    if (stored(base)) {
+      for (pkt_seq_t pktSeq = base; pkt_seq_diff(pktSeq, newest) <= 0; pktSeq = pkt_seq_add(pktSeq, 1)) {
+        modelAdd(pktSeq);
+      }
+      retransmission_buffer_for_each_from(base, resend_set_add, NULL);
+    }
+  } else {
+    uint8_t lost[PKT_WR_BITMAP_BITS / 8] = { 0 };
+    uint32_t bits = test_random_below(&steps, PKT_WR_BITMAP_BITS + 1);
+
+    if (stored(base)) {
+      modelAdd(base);
+    }
+    for (uint32_t i = 0; i < bits; i++) {
+      pkt_seq_t pktSeq = pkt_seq_add(base, 1 + i);
+      if (test_random_below(&steps, 3) == 0) {
+        lost[i / 8] |= (uint8_t)(1u << (i % 8));
+        if (pkt_seq_diff(pktSeq, newest) <= 0 && stored(pktSeq)) {
+          modelAdd(pktSeq);
+        }
+      }
+    }
+    retransmission_buffer_for_each_in_bitmap(base, lost, bits, resend_set_add, NULL);
+  }
+}
+
+static void flush(void)
+{
+  visit_list_t visits = { .count = 0 };
+  uint32_t expected = 0;
+  uint32_t visited = resend_set_flush(record, &visits);
+
+  TEST_CHECK(visited == visits.count, "flush returned %u for %u packets", visited, visits.count);
+  for (uint32_t i = 0; i < modelCount; i++) {
+    if (!stored(model[i])) {
+      continue;
+    }
+    TEST_CHECK(expected < visits.count && visits.sequences[expected] == model[i],
+               "flushed packet %u is 0x%06X, 0x%06X expected", expected,
+               (expected < visits.count) ? (unsigned)visits.sequences[expected] : 0u, (unsigned)model[i]);
+    expected++;
+  }
+  TEST_CHECK(expected == visits.count, "%u packets flushed, %u expected", visits.count, expected);
+  TEST_CHECK(resend_set_is_empty(), "set not empty after a flush");
+  modelCount = 0;
+}
+
+///The set fills up with packets pushed out of the buffer before the flush
+static void checkExpiry(void)
+{
+  visit_list_t visits = { .count = 0 };
+  resend_set_stats_t before = *resend_set_get_stats();
+  pkt_seq_t oldest = pkt_seq_add(newest, PKT_SEQ_MAX + 2 - LENGTH);
+
+  retransmission_buffer_for_each_from(oldest, resend_set_add, NULL);
+  for (uint32_t i = 0; i < LENGTH / 2; i++) {
+    generate();
+  }
+  retransmission_buffer_for_each_from(pkt_seq_add(newest, PKT_SEQ_MAX + 2 - LENGTH / 2), resend_set_add, NULL);
+  TEST_CHECK(resend_set_get_stats()->added - before.added == LENGTH
+             && resend_set_get_stats()->expired - before.expired == LENGTH / 2,
+             "%u added and %u refused, the set holds %u", resend_set_get_stats()->added - before.added,
+             resend_set_get_stats()->expired - before.expired, LENGTH);
+  resend_set_flush(record, &visits);
+  TEST_CHECK(visits.count == LENGTH / 2 && visits.sequences[0] == pkt_seq_add(oldest, LENGTH / 2),
+             "%u packets still stored flushed", visits.count);
+  TEST_CHECK(resend_set_get_stats()->expired - before.expired == LENGTH,
+             "the overwritten packets count as expired");
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  uint64_t windows = 200000;
+  uint64_t seed = 1;
+  uint32_t added = 0;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:s:h")) != -1) {
+    switch (option) {
+      case 'n':
+        windows = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  test_random_seed(&steps, seed, 0);
+  pkt_pool_init();
+  retransmission_buffer_init();
+  resend_set_init();
+  newest = PKT_SEQ_MAX - 1000;
+  for (uint32_t i = 0; i < LENGTH; i++) {
+    generate();
+  }
+
+  for (uint64_t w = 0; w < windows; w++) {
+    uint32_t burst = test_random_below(&steps, BURST_MAX + 1);
+
+    for (uint32_t r = 0; r < burst; r++) {
+      request();
+      //Data keeps flowing while the window is open
+      if (test_random_below(&steps, 3) == 0) {
+        generate();
+      }
+    }
+    flush();
+  }
+  TEST_CHECK(resend_set_get_stats()->duplicates == modelDuplicates, "%u duplicates counted, %u expected",
+             resend_set_get_stats()->duplicates, modelDuplicates);
+  added = resend_set_get_stats()->added;
+  checkExpiry();
+
+  printf("resend_set_test: %llu windows, %u packets added, %u duplicates merged, %u refused as full\n",
+         (unsigned long long)windows, added, modelDuplicates, modelRefused);
+  return test_check_result("resend_set_test");
+}
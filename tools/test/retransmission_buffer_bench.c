@@ -0,0 +1,241 @@
+/***************************************************************************//**
+ * @file retransmission_buffer_bench.c
+ * @brief Cost of the retransmission buffer operations against its length
+ *
+ * retransmission_buffer.c sizes its ring at build time, the Makefile builds
+ * one binary per RETRANSMISSION_BUFFER_DEFAULT_LENGTH of RB_BENCH_LENGTHS and
+ * make bench runs them all. The packet pool is replaced by the stand-in below
+ * so only the ring is timed: the ring holds many more packets than the pool
+ * has slots, every pool slot is stored under many sequence numbers.
+ *
+ * For reference, the shift-on-full array with a linear search the ring
+ * replaced is timed on the same sequence numbers.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "retransmission_buffer.h"
+#include "test_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define LENGTH RETRANSMISSION_BUFFER_DEFAULT_LENGTH
+
+/// Packets a Wr asks for, as the range walk and in the bitmap
+#define REQUEST_SPAN 8
+
+typedef PKT_STORAGE(PKT_DATA_PAYLOAD_MAX_LENGTH) bench_packet_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static bench_packet_t packets[PKT_POOL_TOTAL_LENGTH];
+static uint32_t refCount[PKT_POOL_TOTAL_LENGTH];
+
+static uint32_t visited;
+static test_random_t offsets;
+
+///Replaced layout: oldest first, shifted down by one when full
+static bench_packet_t linear[LENGTH];
+static uint32_t linearCount;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-o operations] [-s seed]\n"
+          "  -o operations  operations timed per column (default 10000000)\n"
+          "  -s seed        seed of the looked up sequence numbers (default 1)\n",
+          program);
+}
+
+static double wallSeconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void count(pkt_pool_index_t index, void *context)
+{
+  (void)context;
+  visited += index;
+}
+
+///Stores pktSeq in the next pool slot and inserts it
+static void insert(pkt_seq_t pktSeq)
+{
+  pkt_pool_index_t index = (pkt_pool_index_t)(pktSeq % PKT_POOL_TOTAL_LENGTH);
+
+  packets[index].header.pktSeq = pktSeq;
+  retransmission_buffer_insert(index);
+}
+
+///Fills the ring up to newest
+static void fill(pkt_seq_t newest)
+{
+  retransmission_buffer_init();
+  for (uint32_t i = 0; i < LENGTH; i++) {
+    insert(pkt_seq_add(newest, PKT_SEQ_MAX + 2 - LENGTH + i));
+  }
+}
+
+static void linearInsert(pkt_seq_t pktSeq)
+{
+  if (linearCount == LENGTH) {
+    memmove(&linear[0], &linear[1], (LENGTH - 1) * sizeof(linear[0]));
+    linearCount--;
+  }
+  linear[linearCount].header.pktSeq = pktSeq;
+  linearCount++;
+}
+
+static uint32_t linearLookup(pkt_seq_t pktSeq)
+{
+  for (uint32_t i = 0; i < linearCount; i++) {
+    if (linear[i].header.pktSeq == pktSeq) {
+      return i;
+    }
+  }
+  return LENGTH;
+}
+
+///A sequence number in the ring, the newer ones asked for more often
+static pkt_seq_t recent(pkt_seq_t newest)
+{
+  uint32_t back = (uint32_t)test_random_below(&offsets, LENGTH);
+
+  back = (uint32_t)test_random_below(&offsets, back + 1);
+  return pkt_seq_add(newest, PKT_SEQ_MAX + 1 - back);
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void pkt_pool_ref(pkt_pool_index_t index)
+{
+  refCount[index]++;
+}
+
+void pkt_pool_unref(pkt_pool_index_t index)
+{
+  configASSERT(refCount[index] > 0);
+  refCount[index]--;
+}
+
+pkt_t *pkt_pool_get(pkt_pool_index_t index)
+{
+  return (pkt_t *)&packets[index];
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t operations = 10000000;
+  uint64_t seed = 1;
+  uint8_t lost[(REQUEST_SPAN + 7) / 8] = { 0 };
+  pkt_seq_t newest;
+  double started;
+  double insertNs;
+  double lookupNs;
+  double missNs;
+  double rangeNs;
+  double bitmapNs;
+  double shiftNs;
+  double scanNs;
+  int option;
+
+  while ((option = getopt(argc, argv, "o:s:h")) != -1) {
+    switch (option) {
+      case 'o':
+        operations = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (operations == 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  test_random_seed(&offsets, seed, LENGTH);
+  for (uint32_t i = 0; i < REQUEST_SPAN; i += 3) {
+    lost[i / 8] |= (uint8_t)(1u << (i % 8));
+  }
+
+  //Steady state, every insert evicts the oldest packet, across the wrap
+  newest = (pkt_seq_t)(PKT_SEQ_MAX - (operations / 2) % PKT_SEQ_MAX);
+  fill(newest);
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    newest = pkt_seq_add(newest, 1);
+    insert(newest);
+  }
+  insertNs = (wallSeconds() - started) * 1e9 / operations;
+
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    visited += retransmission_buffer_lookup(recent(newest));
+  }
+  lookupNs = (wallSeconds() - started) * 1e9 / operations;
+
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    visited += retransmission_buffer_lookup(pkt_seq_add(recent(newest), PKT_SEQ_MAX + 1 - LENGTH));
+  }
+  missNs = (wallSeconds() - started) * 1e9 / operations;
+
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    retransmission_buffer_for_each_from(pkt_seq_add(newest, PKT_SEQ_MAX + 2 - REQUEST_SPAN), count, NULL);
+  }
+  rangeNs = (wallSeconds() - started) * 1e9 / operations;
+
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    retransmission_buffer_for_each_in_bitmap(pkt_seq_add(newest, PKT_SEQ_MAX + 1 - REQUEST_SPAN),
+                                             lost, REQUEST_SPAN, count, NULL);
+  }
+  bitmapNs = (wallSeconds() - started) * 1e9 / operations;
+
+  //The replaced array, over fewer operations once it gets slow
+  if (LENGTH > 16) {
+    operations = operations * 16 / LENGTH + 1;
+  }
+  for (uint32_t i = 0; i < LENGTH; i++) {
+    linearInsert(pkt_seq_add(newest, PKT_SEQ_MAX + 2 - LENGTH + i));
+  }
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    newest = pkt_seq_add(newest, 1);
+    linearInsert(newest);
+  }
+  shiftNs = (wallSeconds() - started) * 1e9 / operations;
+
+  started = wallSeconds();
+  for (uint64_t i = 0; i < operations; i++) {
+    visited += linearLookup(recent(newest));
+  }
+  scanNs = (wallSeconds() - started) * 1e9 / operations;
+
+  printf("%8u %8.1f %8.1f %8.1f %8.1f %8.1f %10.1f %10.1f\n", LENGTH, insertNs, lookupNs, missNs,
+         rangeNs, bitmapNs, shiftNs, scanNs);
+  //Keeps the loops from being optimized out
+  return (visited == 1) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @file test_check.h
+ * @brief Checks of the host tests of the firmware modules
+ *
+ * A failed check prints where it is and the test goes on, the test ends
+ * with test_check_result() as the exit status of main(), see make check.
+ ******************************************************************************/
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Checks a condition, the failure message takes printf arguments
+#define TEST_CHECK(condition, ...)                                    \
+  do {                                                                \
+    test_checks++;                                                    \
+    if (!(condition)) {                                               \
+      test_check_failures++;                                          \
+      fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #condition); \
+      fprintf(stderr, __VA_ARGS__);                                   \
+      fprintf(stderr, "\n");                                          \
+    }                                                                 \
+  } while (0)
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t test_checks;
+static uint32_t test_check_failures;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/// Prints the count of checks and failures, returns the exit status
+static inline int test_check_result(const char *test)
+{
+  printf("%s: %u checks, %u failed\n", test, test_checks, test_check_failures);
+  return (test_check_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif // TEST_CHECK_H
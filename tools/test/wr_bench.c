@@ -0,0 +1,317 @@
+/***************************************************************************//**
+ * @file wr_bench.c
+ * @brief Retransmitted frames per recovered loss, selective against legacy Wr
+ *
+ * The relays of relay.c listen to a sink over links losing frames at random,
+ * either independently or in bursts. They ask for what they miss with the
+ * selective Wr relay_request() builds, or with the same Wr stripped of its
+ * bitmap, the legacy request asking for a packet and every newer one. The
+ * sink answers as sink.c does, from its retransmission buffer through
+ * the resend set, merging the requests of a coalescing window or flushing
+ * after each one. Every retransmission is one broadcast frame heard by all
+ * the relays, losses included.
+ *
+ * Time advances in 1 ms steps, the radio itself takes no time.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pkt_pool.h"
+#include "relay.h"
+#include "resend_set.h"
+#include "retransmission_buffer.h"
+#include "test_random.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RELAYS_MAX 64
+
+/// Longest random wait of a relay before its Wr, as the jitter of flood_sim
+#define WR_JITTER_MS 20
+
+/// Mean length of a loss burst, in frames
+#define BURST_MEAN 4
+
+#define PAYLOAD_LENGTH 16
+
+typedef struct
+{
+  bool selective;
+  bool coalesced;
+  bool bursty;
+  uint32_t lossPerMille;
+} bench_case_t;
+
+typedef struct
+{
+  relay_t relay;
+  uint64_t requestMs;   //Next relay_request() call, UINT64_MAX if none is due
+  bool inBurst;
+} bench_relay_t;
+
+typedef struct
+{
+  uint64_t frames;      //Retransmissions sent by the sink
+  uint64_t wr;          //Wr heard by the sink
+  uint64_t recovered;   //First copies heard in a retransmission
+  uint64_t abandoned;
+} bench_result_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static bench_relay_t relays[RELAYS_MAX];
+static uint32_t relayCount = 20;
+static test_random_t losses;
+static test_random_t jitter;
+
+static bench_case_t benchCase;
+static bench_result_t result;
+static uint64_t nowMs;
+static uint64_t coalesceEndMs;
+static pkt_seq_t pktSequenceNumber;
+
+static PKT_STORAGE(sizeof(pkt_wr_bitmap_t)) request;
+static bool requestHeard;
+static bool retransmitting;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n relays] [-p packets] [-g period_ms] [-s seed]\n"
+          "  -n relays     relays one hop from the sink (default 20, at most %u)\n"
+          "  -p packets    data packets per case (default 2000)\n"
+          "  -g period_ms  data generation period of the sink (default 1000)\n"
+          "  -s seed       seed of the losses (default 1)\n",
+          program, RELAYS_MAX);
+}
+
+///Loss on the link of a relay, a two state chain with bursts of BURST_MEAN frames
+static bool linkLoses(bench_relay_t *bench)
+{
+  uint32_t p = benchCase.lossPerMille;
+
+  if (!benchCase.bursty) {
+    return test_random_below(&losses, 1000) < p;
+  }
+  if (bench->inBurst) {
+    bench->inBurst = test_random_below(&losses, BURST_MEAN) != 0;
+  } else {
+    //Entered with p / (BURST_MEAN * (1 - p)) for a long run loss of p
+    bench->inBurst = test_random_below(&losses, BURST_MEAN * (1000 - p)) < p;
+  }
+  return bench->inBurst;
+}
+
+static void broadcast(const pkt_t *packet)
+{
+  uint8_t frame[PKT_FRAME_MAX_LENGTH];
+  uint16_t length = pkt_encode(packet, PKT_VERSION_2, frame);
+
+  for (uint32_t r = 0; r < relayCount; r++) {
+    uint32_t delayMs;
+
+    if (linkLoses(&relays[r])) {
+      continue;
+    }
+    delayMs = relay_handle_frame(&relays[r].relay, frame, length);
+    if (delayMs != RELAY_NO_REQUEST) {
+      relays[r].requestMs = nowMs + delayMs + test_random_below(&jitter, WR_JITTER_MS + 1);
+    }
+  }
+}
+
+static void retransmit(pkt_pool_index_t index, void *context)
+{
+  (void)context;
+  result.frames++;
+  retransmitting = true;
+  broadcast(pkt_pool_get(index));
+  retransmitting = false;
+}
+
+///serveRequest() of sink.c
+static void serve(const pkt_t *packet)
+{
+  pkt_wr_bitmap_t bitmap;
+  bool selective = false;
+  bool windowOpen = !resend_set_is_empty();
+
+  result.wr++;
+  //Header only requests are legacy ones
+  if (packet->header.length >= sizeof(bitmap)) {
+    memcpy(&bitmap, packet->payload, sizeof(bitmap));
+    selective = bitmap.marker == PKT_WR_BITMAP_MARKER && bitmap.bits <= PKT_WR_BITMAP_BITS;
+  }
+  if (selective) {
+    retransmission_buffer_for_each_in_bitmap(packet->header.pktSeq, bitmap.lost, bitmap.bits,
+                                             resend_set_add, NULL);
+  } else if (retransmission_buffer_lookup(packet->header.pktSeq) != PKT_POOL_INVALID_INDEX) {
+    retransmission_buffer_for_each_from(packet->header.pktSeq, resend_set_add, NULL);
+  }
+
+  if (!benchCase.coalesced) {
+    resend_set_flush(retransmit, NULL);
+  } else if (!windowOpen && !resend_set_is_empty()) {
+    coalesceEndMs = nowMs + RETRANSMISSION_COALESCE_MS;
+  }
+}
+
+///Keeps the Wr of a relay, on its uplink, until relay_request() returns
+static bool relaySend(const pkt_t *packet, void *context)
+{
+  bench_relay_t *bench = context;
+
+  if (packet->header.wupSeq != Wr || linkLoses(bench)) {
+    return true;
+  }
+  request.header = packet->header;
+  memcpy(request.payload, packet->payload, packet->header.length);
+  if (!benchCase.selective) {
+    request.header.length = 0;
+  }
+  requestHeard = true;
+  return true;
+}
+
+///A legacy Wr also brings packets a relay didn't know it missed yet, they
+///count as recovered as well
+static void relayDeliver(const pkt_t *packet, void *context)
+{
+  (void)packet;
+  (void)context;
+  if (retransmitting) {
+    result.recovered++;
+  }
+}
+
+static void generate(void)
+{
+  pkt_pool_index_t index = pkt_pool_alloc(PKT_CLASS_DATA);
+  pkt_t *packet = pkt_pool_get(index);
+
+  pktSequenceNumber = pkt_seq_add(pktSequenceNumber, 1);
+  packet->header.wupSeq = Wd;
+  packet->header.hopCount = 1;
+  packet->header.pktSeq = pktSequenceNumber;
+  packet->header.length = PAYLOAD_LENGTH;
+  memset(packet->payload, (int)pktSequenceNumber, PAYLOAD_LENGTH);
+  retransmission_buffer_insert(index);
+  broadcast(packet);
+  pkt_pool_unref(index);
+}
+
+static void runCase(uint32_t packets, uint32_t periodMs, uint64_t seed)
+{
+  uint64_t endMs = (uint64_t)packets * periodMs;
+
+  test_random_seed(&losses, seed, 0);
+  test_random_seed(&jitter, seed, 1);
+  pkt_pool_init();
+  retransmission_buffer_init();
+  resend_set_init();
+  memset(&result, 0, sizeof(result));
+  for (uint32_t r = 0; r < relayCount; r++) {
+    relays[r].requestMs = UINT64_MAX;
+    relays[r].inBurst = false;
+    relay_init(&relays[r].relay, 1, relaySend, relayDeliver, &relays[r]);
+  }
+  coalesceEndMs = UINT64_MAX;
+  pktSequenceNumber = 0;
+  requestHeard = false;
+
+  for (nowMs = 0; nowMs < endMs; nowMs++) {
+    if (nowMs % periodMs == 0) {
+      generate();
+    }
+    for (uint32_t r = 0; r < relayCount; r++) {
+      if (relays[r].requestMs == nowMs) {
+        uint32_t delayMs = relay_request(&relays[r].relay);
+        relays[r].requestMs = (delayMs == RELAY_NO_REQUEST) ? UINT64_MAX : nowMs + delayMs;
+        if (requestHeard) {
+          requestHeard = false;
+          serve((const pkt_t *)&request);
+        }
+      }
+    }
+    if (coalesceEndMs == nowMs) {
+      coalesceEndMs = UINT64_MAX;
+      resend_set_flush(retransmit, NULL);
+    }
+  }
+
+  for (uint32_t r = 0; r < relayCount; r++) {
+    result.abandoned += relays[r].relay.stats.abandoned;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  static const uint32_t lossRates[] = { 10, 50, 100, 200 };
+  uint32_t packets = 2000;
+  uint32_t periodMs = 1000;
+  uint64_t seed = 1;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:p:g:s:h")) != -1) {
+    switch (option) {
+      case 'n':
+        relayCount = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        packets = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'g':
+        periodMs = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (relayCount == 0 || relayCount > RELAYS_MAX || packets == 0 || periodMs <= RELAY_WR_RETRY_MS) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  printf("%u relays, %u packets every %u ms, coalescing window %u ms\n", relayCount, packets, periodMs,
+         RETRANSMISSION_COALESCE_MS);
+  printf("%-7s %5s %-9s %-9s %8s %8s %9s %9s %8s\n", "pattern", "loss", "request", "window", "wr", "resent",
+         "recovered", "abandoned", "per loss");
+  for (uint32_t bursty = 0; bursty <= 1; bursty++) {
+    for (uint32_t l = 0; l < sizeof(lossRates) / sizeof(lossRates[0]); l++) {
+      for (uint32_t mode = 0; mode < 4; mode++) {
+        benchCase = (bench_case_t){
+          .selective = (mode & 1) != 0,
+          .coalesced = (mode & 2) != 0,
+          .bursty = bursty != 0,
+          .lossPerMille = lossRates[l]
+        };
+        runCase(packets, periodMs, seed);
+        printf("%-7s %5u %-9s %-9s %8llu %8llu %9llu %9llu %8.2f\n", bursty ? "bursty" : "random",
+               lossRates[l], benchCase.selective ? "selective" : "legacy",
+               benchCase.coalesced ? "merged" : "per wr", (unsigned long long)result.wr,
+               (unsigned long long)result.frames, (unsigned long long)result.recovered,
+               (unsigned long long)result.abandoned,
+               (result.recovered != 0) ? (double)result.frames / (double)result.recovered : 0.0);
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
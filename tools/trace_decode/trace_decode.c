@@ -0,0 +1,297 @@
+/***************************************************************************//**
+ * @file trace_decode.c
+ * @brief Host decoder of the binary trace records sent on the VCOM
+ *
+ * Reads the raw byte stream of a sink built with TRACE_BINARY_ENABLE, from a
+ * capture file, stdin or the VCOM tty itself, and prints the events either
+ * the way the firmware would have formatted them or as CSV.
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "trace_events.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define DEFAULT_TICK_HZ 32768
+#define DEFAULT_BAUD B115200
+
+typedef struct
+{
+  bool csv;
+  uint32_t tickHz;
+} options_t;
+
+typedef struct
+{
+  uint64_t records;
+  uint64_t bytes;
+  uint64_t badChecksum;
+  uint64_t badRecord;
+  uint64_t skipped; //Bytes discarded while looking for TRACE_SYNC
+} decode_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const char *const traceNames[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, argc, format) #id,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+};
+
+static const uint8_t traceArgc[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, argc, format) argc,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+};
+
+static const char *const traceFormats[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, argc, format) format,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+};
+
+static decode_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-c] [-t tick_hz] [file|tty|-]\n"
+          "  -c          print CSV (time_s,event,args...) instead of text\n"
+          "  -t tick_hz  sleeptimer frequency of the sink (default %u)\n"
+          "A tty is switched to raw mode at 115200 baud, '-' or no argument reads stdin.\n",
+          program, DEFAULT_TICK_HZ);
+}
+
+///Reads an unsigned LEB128 varint, returns the bytes used or 0 if malformed
+static uint32_t getVarint(const uint8_t *buffer, uint32_t length, uint32_t *value)
+{
+  uint32_t result = 0;
+
+  for (uint32_t i = 0; i < length && i < 5; i++) {
+    result |= (uint32_t)(buffer[i] & 0x7F) << (7 * i);
+    if (!(buffer[i] & 0x80)) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+///Decodes the body of a record (id to last argument), false if it's malformed
+static bool printRecord(const uint8_t *body, uint32_t length, const options_t *options)
+{
+  uint32_t args[TRACE_MAX_ARGS] = { 0 };
+  uint32_t timestamp;
+  uint32_t offset = 1;
+  uint32_t used;
+  uint8_t id;
+  double seconds;
+
+  if (length < 2 || body[0] >= TRACE_EVENT_COUNT) {
+    return false;
+  }
+  id = body[0];
+  used = getVarint(&body[offset], length - offset, &timestamp);
+  if (used == 0) {
+    return false;
+  }
+  offset += used;
+  for (uint32_t i = 0; i < traceArgc[id]; i++) {
+    used = getVarint(&body[offset], length - offset, &args[i]);
+    if (used == 0) {
+      return false;
+    }
+    offset += used;
+  }
+  if (offset != length) {
+    return false;
+  }
+
+  seconds = (double)timestamp / options->tickHz;
+  if (options->csv) {
+    printf("%.6f,%s", seconds, traceNames[id]);
+    for (uint32_t i = 0; i < traceArgc[id]; i++) {
+      printf(",%u", args[i]);
+    }
+    printf("\n");
+  } else {
+    char text[256];
+    char *start = text;
+    snprintf(text, sizeof(text), traceFormats[id], args[0], args[1], args[2], args[3]);
+    printf("[%12.6f] ", seconds);
+    //Drop the blank lines and carriage returns meant for the terminal on the VCOM
+    while (*start == '\r' || *start == '\n') {
+      start++;
+    }
+    for (char *c = start; *c != '\0'; c++) {
+      if (*c != '\r') {
+        putchar(*c);
+      }
+    }
+    if (text[0] != '\0' && text[strlen(text) - 1] != '\n') {
+      putchar('\n');
+    }
+  }
+  stats.records++;
+  return true;
+}
+
+///Decodes every complete record in buffer, returns the number of bytes consumed
+static size_t decode(const uint8_t *buffer, size_t length, const options_t *options)
+{
+  size_t offset = 0;
+
+  while (offset < length) {
+    uint8_t checksum;
+    size_t recordLength;
+
+    if (buffer[offset] != TRACE_SYNC) {
+      stats.skipped++;
+      offset++;
+      continue;
+    }
+    if (offset + 2 > length) {
+      break;
+    }
+    recordLength = 3 + (size_t)buffer[offset + 1];
+    if (recordLength > TRACE_RECORD_MAX_SIZE) {
+      stats.badRecord++;
+      offset++;
+      continue;
+    }
+    if (offset + recordLength > length) {
+      break;
+    }
+
+    checksum = 0;
+    for (size_t i = 1; i < recordLength - 1; i++) {
+      checksum ^= buffer[offset + i];
+    }
+    if (checksum != buffer[offset + recordLength - 1]) {
+      //Probably a TRACE_SYNC value inside another record, resync on the next byte
+      stats.badChecksum++;
+      offset++;
+      continue;
+    }
+    if (!printRecord(&buffer[offset + 2], (uint32_t)(recordLength - 3), options)) {
+      stats.badRecord++;
+      offset++;
+      continue;
+    }
+    offset += recordLength;
+  }
+  return offset;
+}
+
+static int openInput(const char *path)
+{
+  struct termios tty;
+  int fd;
+
+  if (path == NULL || strcmp(path, "-") == 0) {
+    return STDIN_FILENO;
+  }
+  fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (isatty(fd) && tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, DEFAULT_BAUD);
+    cfsetospeed(&tty, DEFAULT_BAUD);
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+  return fd;
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  options_t options = { .csv = false, .tickHz = DEFAULT_TICK_HZ };
+  uint8_t buffer[4096];
+  size_t pending = 0;
+  int opt;
+  int fd;
+
+  while ((opt = getopt(argc, argv, "ct:h")) != -1) {
+    switch (opt) {
+      case 'c':
+        options.csv = true;
+        break;
+      case 't':
+        options.tickHz = (uint32_t)strtoul(optarg, NULL, 0);
+        if (options.tickHz == 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (argc - optind > 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fd = openInput((optind < argc) ? argv[optind] : NULL);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+    return EXIT_FAILURE;
+  }
+  if (options.csv) {
+    printf("time_s,event");
+    for (uint32_t i = 0; i < TRACE_MAX_ARGS; i++) {
+      printf(",arg%u", i);
+    }
+    printf("\n");
+  }
+
+  while (true) {
+    ssize_t count = read(fd, &buffer[pending], sizeof(buffer) - pending);
+    size_t consumed;
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    stats.bytes += (uint64_t)count;
+    pending += (size_t)count;
+    consumed = decode(buffer, pending, &options);
+    memmove(buffer, &buffer[consumed], pending - consumed);
+    pending -= consumed;
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "%llu records from %llu bytes (%.1f bytes/record), %llu bad checksums, %llu bad records, %llu bytes skipped\n",
+          (unsigned long long)stats.records, (unsigned long long)stats.bytes,
+          stats.records ? (double)stats.bytes / stats.records : 0.0,
+          (unsigned long long)stats.badChecksum, (unsigned long long)stats.badRecord,
+          (unsigned long long)stats.skipped);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/***************************************************************************//**
+ * @file trace.c
+ * @brief Trace events, sent as text or as compact binary records
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdarg.h>
+
+#include "sl_sleeptimer.h"
+
+#include "trace.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if TRACE_BINARY_ENABLE && (TRACE_RECORD_MAX_SIZE > ASYNC_LOG_RECORD_SIZE - 1)
+#error "ASYNC_LOG_RECORD_SIZE is too small for binary trace records"
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+#if TRACE_BINARY_ENABLE
+static uint32_t putVarint(uint8_t *buffer, uint32_t value);
+#endif
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const uint8_t traceArgc[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, argc, format) argc,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+};
+
+#if !TRACE_BINARY_ENABLE
+static const char *const traceFormats[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, argc, format) format,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+};
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+#if TRACE_BINARY_ENABLE
+void trace_event(async_log_producer_t producer, trace_id_t id, ...)
+{
+  uint8_t record[TRACE_RECORD_MAX_SIZE];
+  uint32_t length = 2;
+  uint8_t checksum = 0;
+  va_list args;
+
+  record[length++] = (uint8_t)id;
+  length += putVarint(&record[length], sl_sleeptimer_get_tick_count());
+  va_start(args, id);
+  for (uint32_t i = 0; i < traceArgc[id]; i++) {
+    length += putVarint(&record[length], va_arg(args, unsigned int));
+  }
+  va_end(args);
+
+  record[0] = TRACE_SYNC;
+  record[1] = (uint8_t)(length - 2);
+  for (uint32_t i = 1; i < length; i++) {
+    checksum ^= record[i];
+  }
+  record[length++] = checksum;
+
+  async_log_write(producer, record, length);
+}
+#else
+void trace_event(async_log_producer_t producer, trace_id_t id, ...)
+{
+  va_list args;
+
+  va_start(args, id);
+  async_log_vprintf(producer, traceFormats[id], args);
+  va_end(args);
+  (void)traceArgc;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+#if TRACE_BINARY_ENABLE
+///Unsigned LEB128, 7 bits per byte, least significant group first
+uint32_t putVarint(uint8_t *buffer, uint32_t value)
+{
+  uint32_t length = 0;
+
+  while (value >= 0x80) {
+    buffer[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buffer[length++] = (uint8_t)value;
+  return length;
+}
+#endif
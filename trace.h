@@ -0,0 +1,31 @@
+/***************************************************************************//**
+ * @file trace.h
+ * @brief Trace events, sent as text or as compact binary records
+ ******************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "async_log.h"
+#include "trace_events.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Queues a trace event on the asynchronous log.
+ *
+ * @param producer Ring of the calling context
+ * @param id Event, see TRACE_EVENTS
+ * @param ... The event arguments, unsigned integers of at most 32 bits
+ *
+ * With TRACE_BINARY_ENABLE the arguments are sent raw together with a
+ * timestamp and tools/trace_decode formats them on the host, otherwise the
+ * event format is printed here.
+ *****************************************************************************/
+void trace_event(async_log_producer_t producer, trace_id_t id, ...);
+
+#endif  // TRACE_H
@@ -0,0 +1,80 @@
+/***************************************************************************//**
+ * @file trace_events.h
+ * @brief Trace event table, shared by the firmware and the host decoder
+ ******************************************************************************/
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Largest number of arguments of an event
+#define TRACE_MAX_ARGS 4
+
+/// TRACE_EVENT(id, number of arguments, format)
+/// The position in the table is the id sent on the wire: only append new
+/// events, the decoder of an older build would misread the reordered ones.
+/// Formats only take unsigned integer arguments (%u, %x).
+#define TRACE_EVENTS                                                                                \
+  TRACE_EVENT(TRACE_BEACON_SENT, 0, "\r\nBeacon update sent!\r\n")                                  \
+  TRACE_EVENT(TRACE_PACKET_SENT, 3, "Packet sent:\r\nSequence number: %u\r\nWUP Sequence: %u\r\nHop Count: %u\r\n") \
+  TRACE_EVENT(TRACE_RETRANSMIT_REQUEST, 1, "\r\nRetransmit Packet received:\r\nPacket Sequence: %u\r\n") \
+  TRACE_EVENT(TRACE_STATS, 4, "Stats %u.%u: %u %u\r\n")                                             \
+  TRACE_EVENT(TRACE_RAIL_EVENT, 2, "RAIL events: 0x%08x%08x\r\n")
+
+typedef enum
+{
+#define TRACE_EVENT(id, argc, format) id,
+  TRACE_EVENTS
+#undef TRACE_EVENT
+  TRACE_EVENT_COUNT
+} trace_id_t;
+
+/// Counter blocks of TRACE_STATS, its first argument. The second one is the
+/// index of the first of the two counters carried, in the order of the
+/// block, a block of odd length ends with a 0. Only append new blocks.
+///   TX           sink_tx_stats_t
+///   RX           rx_stats_t of main.c
+///   WR           sink_wr_stats_t
+///   RAIL_EVENT   isr_stats_t of the RAIL event handler of main.c
+///   AIRTIME      sink_airtime_stats_t, per wupSeq then aggregates
+///   GOODPUT      sink_goodput_stats_t
+///   TX_SCHEDULER tx_scheduler_stats_t, per tx_class_t
+///   RESEND_SET   resend_set_stats_t
+///   WAKE_WINDOW  wake_window_stats_t
+///   RADIO_POWER  radio_power_stats_t
+///   SLEEP        sleep_monitor_stats_t, the 64 bit times truncated
+///   ASYNC_LOG    async_log_stats_t
+///   FEC          parityDropped of sink_stats_t
+typedef enum
+{
+  TRACE_STATS_TX,
+  TRACE_STATS_RX,
+  TRACE_STATS_WR,
+  TRACE_STATS_RAIL_EVENT,
+  TRACE_STATS_AIRTIME,
+  TRACE_STATS_GOODPUT,
+  TRACE_STATS_TX_SCHEDULER,
+  TRACE_STATS_RESEND_SET,
+  TRACE_STATS_WAKE_WINDOW,
+  TRACE_STATS_RADIO_POWER,
+  TRACE_STATS_SLEEP,
+  TRACE_STATS_ASYNC_LOG,
+  TRACE_STATS_FEC,
+  TRACE_STATS_BLOCK_COUNT
+} trace_stats_block_t;
+
+/// Most counters in one block
+#define TRACE_STATS_VALUES_MAX 24
+
+/// Binary record layout:
+///   TRACE_SYNC, length, id, timestamp, arguments..., checksum
+/// length counts the bytes from id to the last argument. The timestamp
+/// (sleeptimer ticks) and the arguments are unsigned LEB128 varints. The
+/// checksum is the XOR of every byte from length to the last argument.
+#define TRACE_SYNC 0xA5
+
+/// Longest encoded record
+#define TRACE_RECORD_MAX_SIZE (3 + 1 + 5 * (1 + TRACE_MAX_ARGS))
+
+#endif  // TRACE_EVENTS_H
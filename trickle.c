@@ -0,0 +1,101 @@
+/***************************************************************************//**
+ * @file trickle.c
+ * @brief Trickle timer (RFC 6206) deciding when a beacon is worth sending
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "trickle.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void startInterval(trickle_t *trickle);
+static uint32_t nextRandom(trickle_t *trickle);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void trickle_init(trickle_t *trickle, uint32_t iminMs, uint8_t doublings, uint8_t k, uint32_t seed)
+{
+  trickle->iminMs = iminMs;
+  trickle->imaxMs = iminMs << doublings;
+  trickle->k = k;
+  trickle->intervalMs = iminMs;
+  trickle->random = (seed != 0) ? seed : 1;
+  trickle->stats = (trickle_stats_t){ 0 };
+  startInterval(trickle);
+}
+
+void trickle_hear_consistent(trickle_t *trickle)
+{
+  trickle->stats.consistent++;
+  if (trickle->counter < UINT8_MAX) {
+    trickle->counter++;
+  }
+}
+
+bool trickle_hear_inconsistent(trickle_t *trickle)
+{
+  if (trickle->intervalMs == trickle->iminMs) {
+    return false;
+  }
+  trickle->stats.resets++;
+  trickle->intervalMs = trickle->iminMs;
+  startInterval(trickle);
+  return true;
+}
+
+bool trickle_fire(trickle_t *trickle)
+{
+  if (trickle->k == 0 || trickle->counter < trickle->k) {
+    trickle->stats.transmissions++;
+    return true;
+  }
+  trickle->stats.suppressed++;
+  return false;
+}
+
+void trickle_next_interval(trickle_t *trickle)
+{
+  if (trickle->intervalMs <= trickle->imaxMs / 2) {
+    trickle->intervalMs *= 2;
+  } else {
+    trickle->intervalMs = trickle->imaxMs;
+  }
+  startInterval(trickle);
+}
+
+uint32_t trickle_get_fire_ms(const trickle_t *trickle)
+{
+  return trickle->fireMs;
+}
+
+uint32_t trickle_get_interval_ms(const trickle_t *trickle)
+{
+  return trickle->intervalMs;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+void startInterval(trickle_t *trickle)
+{
+  uint32_t half = trickle->intervalMs / 2;
+
+  trickle->counter = 0;
+  trickle->fireMs = half + ((half > 0) ? nextRandom(trickle) % half : 0);
+  trickle->stats.intervals++;
+}
+
+uint32_t nextRandom(trickle_t *trickle)
+{
+  uint32_t x = trickle->random;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  trickle->random = x;
+  return x;
+}
@@ -0,0 +1,105 @@
+/***************************************************************************//**
+ * @file trickle.h
+ * @brief Trickle timer (RFC 6206) deciding when a beacon is worth sending
+ *
+ * The timer only keeps the interval state, the caller does the waiting: it
+ * waits trickle_get_fire_ms() from the interval start, calls trickle_fire(),
+ * waits for the end of the interval and calls trickle_next_interval().
+ * No locking is done, callers sharing a timer between tasks serialize the
+ * calls themselves.
+ ******************************************************************************/
+#ifndef TRICKLE_H
+#define TRICKLE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint32_t intervals;     //Intervals started
+  uint32_t transmissions; //trickle_fire() calls that allowed a beacon
+  uint32_t suppressed;    //trickle_fire() calls that heard enough consistent packets
+  uint32_t consistent;
+  uint32_t resets;        //Inconsistencies that brought the interval back to the minimum
+} trickle_stats_t;
+
+typedef struct
+{
+  uint32_t iminMs;
+  uint32_t imaxMs;
+  uint8_t k;            //Redundancy constant
+  uint8_t counter;      //Consistent packets heard in this interval
+  uint32_t intervalMs;  //Current interval length
+  uint32_t fireMs;      //Offset of the transmission point in the interval
+  uint32_t random;      //xorshift32 state
+  trickle_stats_t stats;
+} trickle_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets the timer up and starts the first interval at the minimum length.
+ *
+ * @param trickle Timer
+ * @param iminMs Minimum interval
+ * @param doublings Times the interval can double, Imax = Imin * 2^doublings
+ * @param k Redundancy constant, 0 never suppresses
+ * @param seed Seed for the transmission point, must not be 0
+ *****************************************************************************/
+void trickle_init(trickle_t *trickle, uint32_t iminMs, uint8_t doublings, uint8_t k, uint32_t seed);
+
+/**************************************************************************//**
+ * Counts a packet that agrees with our state.
+ *
+ * @param trickle Timer
+ *****************************************************************************/
+void trickle_hear_consistent(trickle_t *trickle);
+
+/**************************************************************************//**
+ * Brings the interval back to the minimum after an inconsistency.
+ *
+ * @param trickle Timer
+ * @returns true if a new interval was started, the caller must restart
+ *          its wait from now; false if the interval was already minimal
+ *****************************************************************************/
+bool trickle_hear_inconsistent(trickle_t *trickle);
+
+/**************************************************************************//**
+ * Decides whether to transmit at the transmission point.
+ *
+ * @param trickle Timer
+ * @returns true if fewer than k consistent packets were heard
+ *****************************************************************************/
+bool trickle_fire(trickle_t *trickle);
+
+/**************************************************************************//**
+ * Doubles the interval, up to the maximum, and starts the next one.
+ *
+ * @param trickle Timer
+ *****************************************************************************/
+void trickle_next_interval(trickle_t *trickle);
+
+/**************************************************************************//**
+ * Gives the transmission point of the current interval.
+ *
+ * @param trickle Timer
+ * @returns Offset from the interval start, in [I/2, I)
+ *****************************************************************************/
+uint32_t trickle_get_fire_ms(const trickle_t *trickle);
+
+/**************************************************************************//**
+ * Gives the length of the current interval.
+ *
+ * @param trickle Timer
+ * @returns Interval length
+ *****************************************************************************/
+uint32_t trickle_get_interval_ms(const trickle_t *trickle);
+
+#endif  // TRICKLE_H
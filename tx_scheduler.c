@@ -0,0 +1,210 @@
+/***************************************************************************//**
+ * @file tx_scheduler.c
+ * @brief Transmit queues per packet class, served by priority or by weight
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "tx_scheduler.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#if (TX_SCHEDULER_MODE != 0) && (TX_SCHEDULER_MODE != 1)
+#error "TX_SCHEDULER_MODE must be 0 (strict priority) or 1 (weighted fair)"
+#endif
+
+#define TX_TICKS_TO_MS(ticks) ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+typedef struct
+{
+  pkt_pool_index_t index;
+  TickType_t queuedTick;
+} tx_entry_t;
+
+typedef struct
+{
+  tx_entry_t entries[QUEUE_DEFAULT_LENGTH];
+  uint32_t head;   //Oldest entry
+  uint32_t count;
+  int32_t current; //Smooth weighted round robin credit
+} tx_queue_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static tx_class_t pickClass(void);
+static bool takeEntry(pkt_pool_index_t *index, uint32_t maxLength);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static tx_queue_t queues[TX_CLASS_COUNT];
+static tx_scheduler_stats_t stats[TX_CLASS_COUNT];
+
+#if TX_SCHEDULER_MODE == 1
+static const int32_t weights[TX_CLASS_COUNT] = {
+  [TX_CLASS_BEACON] = TX_WEIGHT_BEACON,
+  [TX_CLASS_DATA] = TX_WEIGHT_DATA,
+  [TX_CLASS_RETRANSMISSION] = TX_WEIGHT_RETRANSMISSION
+};
+#endif
+
+///Counts the packets queued across the classes, the transmitter blocks on it
+static SemaphoreHandle_t queuedSemaphore;
+static StaticSemaphore_t queuedSemaphoreBuffer;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void tx_scheduler_init(void)
+{
+  for (uint32_t c = 0; c < TX_CLASS_COUNT; c++) {
+    queues[c].head = 0;
+    queues[c].count = 0;
+    queues[c].current = 0;
+  }
+  queuedSemaphore = xSemaphoreCreateCountingStatic(TX_CLASS_COUNT * QUEUE_DEFAULT_LENGTH, 0, &queuedSemaphoreBuffer);
+}
+
+bool tx_scheduler_enqueue(tx_class_t txClass, pkt_pool_index_t index)
+{
+  tx_queue_t *queue = &queues[txClass];
+  bool accepted = false;
+
+  taskENTER_CRITICAL();
+  if (queue->count < QUEUE_DEFAULT_LENGTH) {
+    tx_entry_t *entry = &queue->entries[(queue->head + queue->count) % QUEUE_DEFAULT_LENGTH];
+    entry->index = index;
+    entry->queuedTick = xTaskGetTickCount();
+    queue->count++;
+    stats[txClass].enqueued++;
+    accepted = true;
+  } else {
+    stats[txClass].dropped++;
+  }
+  taskEXIT_CRITICAL();
+
+  if (accepted) {
+    xSemaphoreGive(queuedSemaphore);
+  }
+  return accepted;
+}
+
+bool tx_scheduler_dequeue(pkt_pool_index_t *index, TickType_t timeout)
+{
+  //One semaphore count per queued packet, a packet is there once it's taken
+  if (xSemaphoreTake(queuedSemaphore, timeout) != pdTRUE) {
+    return false;
+  }
+  return takeEntry(index, UINT32_MAX);
+}
+
+bool tx_scheduler_dequeue_fitting(pkt_pool_index_t *index, uint32_t maxLength)
+{
+  if (xSemaphoreTake(queuedSemaphore, 0) != pdTRUE) {
+    return false;
+  }
+  if (!takeEntry(index, maxLength)) {
+    xSemaphoreGive(queuedSemaphore);
+    return false;
+  }
+  return true;
+}
+
+uint32_t tx_scheduler_count(void)
+{
+  uint32_t count = 0;
+
+  taskENTER_CRITICAL();
+  for (uint32_t c = 0; c < TX_CLASS_COUNT; c++) {
+    count += queues[c].count;
+  }
+  taskEXIT_CRITICAL();
+  return count;
+}
+
+const tx_scheduler_stats_t *tx_scheduler_get_stats(tx_class_t txClass)
+{
+  return &stats[txClass];
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+///Called with a semaphore count taken, so at least one packet is queued
+bool takeEntry(pkt_pool_index_t *index, uint32_t maxLength)
+{
+  int32_t credits[TX_CLASS_COUNT];
+  tx_class_t txClass;
+  tx_queue_t *queue;
+  tx_entry_t entry;
+  uint32_t delayMs;
+
+  taskENTER_CRITICAL();
+  for (uint32_t c = 0; c < TX_CLASS_COUNT; c++) {
+    credits[c] = queues[c].current;
+  }
+  txClass = pickClass();
+  queue = &queues[txClass];
+  entry = queue->entries[queue->head];
+  if (pkt_pool_get(entry.index)->header.length > maxLength) {
+    //Left where it is, as if it hadn't been picked
+    for (uint32_t c = 0; c < TX_CLASS_COUNT; c++) {
+      queues[c].current = credits[c];
+    }
+    taskEXIT_CRITICAL();
+    return false;
+  }
+  queue->head = (queue->head + 1) % QUEUE_DEFAULT_LENGTH;
+  queue->count--;
+  taskEXIT_CRITICAL();
+
+  delayMs = TX_TICKS_TO_MS(xTaskGetTickCount() - entry.queuedTick);
+  stats[txClass].sent++;
+  stats[txClass].lastDelayMs = delayMs;
+  stats[txClass].totalDelayMs += delayMs;
+  if (delayMs > stats[txClass].maxDelayMs) {
+    stats[txClass].maxDelayMs = delayMs;
+  }
+
+  *index = entry.index;
+  return true;
+}
+
+///Called in a critical section with at least one packet queued
+tx_class_t pickClass(void)
+{
+#if TX_SCHEDULER_MODE == 0
+  tx_class_t txClass = TX_CLASS_BEACON;
+
+  while (queues[txClass].count == 0) {
+    txClass++;
+  }
+  return txClass;
+#else
+  //Every backlogged class earns its weight, the richest one is served and pays
+  //the sum of the weights earned. Classes with nothing queued don't build credit.
+  tx_class_t best = TX_CLASS_COUNT;
+  int32_t total = 0;
+
+  for (tx_class_t c = TX_CLASS_BEACON; c < TX_CLASS_COUNT; c++) {
+    if (queues[c].count == 0) {
+      queues[c].current = 0;
+      continue;
+    }
+    queues[c].current += weights[c];
+    total += weights[c];
+    if (best == TX_CLASS_COUNT || queues[c].current > queues[best].current) {
+      best = c;
+    }
+  }
+  queues[best].current -= total;
+  return best;
+#endif
+}
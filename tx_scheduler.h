@@ -0,0 +1,102 @@
+/***************************************************************************//**
+ * @file tx_scheduler.h
+ * @brief Transmit queues per packet class, served by priority or by weight
+ *
+ * Each class has its own queue of QUEUE_DEFAULT_LENGTH packets, so a burst of
+ * retransmissions can't hold fresh data and beacons back. The transmitter
+ * picks the next packet across the classes: in strict priority mode
+ * (TX_SCHEDULER_MODE 0) the lowest class with packets queued wins, in weighted
+ * fair mode (1) the classes with packets queued share the transmissions in
+ * the ratio of their TX_WEIGHT_* settings (smooth weighted round robin).
+ *
+ * Any task can enqueue, only one task dequeues.
+ ******************************************************************************/
+#ifndef TX_SCHEDULER_H
+#define TX_SCHEDULER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "pkt_pool.h"
+#include "flood_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Packet classes, in strict priority order
+typedef enum
+{
+  TX_CLASS_BEACON,
+  TX_CLASS_DATA,          //New data and its FEC parity
+  TX_CLASS_RETRANSMISSION,
+  TX_CLASS_COUNT
+} tx_class_t;
+
+typedef struct
+{
+  uint32_t enqueued;
+  uint32_t dropped;      //Queue of the class full
+  uint32_t sent;         //Handed to the transmitter
+  uint32_t lastDelayMs;  //Time the last packet spent queued
+  uint32_t maxDelayMs;
+  uint32_t totalDelayMs; //Divided by sent gives the average
+} tx_scheduler_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the queues.
+ *****************************************************************************/
+void tx_scheduler_init(void);
+
+/**************************************************************************//**
+ * Queues a packet, never blocks.
+ *
+ * @param txClass Class of the packet
+ * @param index Pool slot, the queue owns its reference if it's accepted
+ * @returns false if the queue of the class is full, the caller keeps the
+ *          reference
+ *****************************************************************************/
+bool tx_scheduler_enqueue(tx_class_t txClass, pkt_pool_index_t index);
+
+/**************************************************************************//**
+ * Takes the next packet to send.
+ *
+ * @param index Pool slot of the packet, the caller gets its reference
+ * @param timeout Ticks to wait for a packet, portMAX_DELAY waits forever
+ * @returns false if no packet was queued within the timeout
+ *****************************************************************************/
+bool tx_scheduler_dequeue(pkt_pool_index_t *index, TickType_t timeout);
+
+/**************************************************************************//**
+ * Takes the next packet to send if its payload is short enough, never blocks.
+ *
+ * The packet is the one tx_scheduler_dequeue() would return, a longer one
+ * stays at the head of its queue.
+ *
+ * @param index Pool slot of the packet, the caller gets its reference
+ * @param maxLength Longest payload accepted
+ * @returns false if no packet is queued or the next one is too long
+ *****************************************************************************/
+bool tx_scheduler_dequeue_fitting(pkt_pool_index_t *index, uint32_t maxLength);
+
+/**************************************************************************//**
+ * Tells how many packets are queued across the classes.
+ *****************************************************************************/
+uint32_t tx_scheduler_count(void);
+
+/**************************************************************************//**
+ * Gives the counters of a class.
+ *
+ * @param txClass Class
+ * @returns Counters, updated in place
+ *****************************************************************************/
+const tx_scheduler_stats_t *tx_scheduler_get_stats(tx_class_t txClass);
+
+#endif  // TX_SCHEDULER_H
@@ -0,0 +1,140 @@
+/***************************************************************************//**
+ * @file wake_window.c
+ * @brief Receive window kept open after a wake up, without a busy task
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "em_core.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+
+#include "wake_window.h"
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void restartTimer(void);
+static void windowTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data);
+static void emTransitionCallback(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t windowLengthMs;
+static volatile bool windowOpen;
+static sl_sleeptimer_timer_handle_t windowTimer;
+static wake_window_stats_t stats;
+
+///Sleeptimer ticks at the window opening and spent in EM0 since then
+static uint32_t openTick;
+static uint32_t em0EnterTick;
+static uint32_t activeTicks;
+
+static sl_power_manager_em_transition_event_handle_t emTransitionHandle;
+static const sl_power_manager_em_transition_event_info_t emTransitionInfo = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM0,
+  .on_event = emTransitionCallback
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void wake_window_init(uint32_t lengthMs)
+{
+  windowLengthMs = lengthMs;
+  sl_power_manager_subscribe_em_transition_event(&emTransitionHandle, &emTransitionInfo);
+}
+
+void wake_window_open(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (!windowOpen) {
+    windowOpen = true;
+    openTick = sl_sleeptimer_get_tick_count();
+    //We are running, so the EM0 time starts counting now
+    em0EnterTick = openTick;
+    activeTicks = 0;
+    stats.windows++;
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  } else {
+    stats.extensions++;
+  }
+  //Restarted before the callback can close the window again
+  restartTimer();
+  CORE_EXIT_ATOMIC();
+}
+
+void wake_window_extend(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  //Checked and restarted at once, or the timer could be armed on a window
+  //its callback just closed
+  CORE_ENTER_ATOMIC();
+  if (windowOpen) {
+    stats.extensions++;
+    restartTimer();
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+bool wake_window_is_open(void)
+{
+  return windowOpen;
+}
+
+const wake_window_stats_t *wake_window_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+void restartTimer(void)
+{
+  sl_sleeptimer_restart_timer_ms(&windowTimer, windowLengthMs, windowTimerCallback, NULL, 0, 0);
+}
+
+void windowTimerCallback(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  uint32_t now;
+  (void)handle;
+  (void)data;
+
+  //Only one callback may remove the requirement of a window
+  if (!windowOpen) {
+    return;
+  }
+  now = sl_sleeptimer_get_tick_count();
+  //Running the callback, the current EM0 stretch is part of the window
+  activeTicks += now - em0EnterTick;
+  stats.lastLengthMs = sl_sleeptimer_tick_to_ms(now - openTick);
+  stats.lastActiveMs = sl_sleeptimer_tick_to_ms(activeTicks);
+  stats.totalActiveMs += stats.lastActiveMs;
+
+  windowOpen = false;
+  sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+}
+
+void emTransitionCallback(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint32_t now;
+
+  if (!windowOpen) {
+    return;
+  }
+  now = sl_sleeptimer_get_tick_count();
+  if (to == SL_POWER_MANAGER_EM0) {
+    em0EnterTick = now;
+  } else if (from == SL_POWER_MANAGER_EM0) {
+    activeTicks += now - em0EnterTick;
+  }
+}
@@ -0,0 +1,65 @@
+/***************************************************************************//**
+ * @file wake_window.h
+ * @brief Receive window kept open after a wake up, without a busy task
+ ******************************************************************************/
+#ifndef WAKE_WINDOW_H
+#define WAKE_WINDOW_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef struct
+{
+  uint32_t windows;      //Windows opened
+  uint32_t extensions;   //Restarts of an open window
+  uint32_t lastLengthMs; //Length of the last closed window
+  uint32_t lastActiveMs; //Time spent in EM0 during the last closed window
+  uint32_t totalActiveMs;
+} wake_window_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sets the window length and starts tracking the EM0 time.
+ *
+ * @param lengthMs How long a window stays open after the last activity
+ *****************************************************************************/
+void wake_window_init(uint32_t lengthMs);
+
+/**************************************************************************//**
+ * Opens the window, or restarts it if it's already open.
+ *
+ * Can be called from interrupt context. While the window is open the
+ * device is kept in EM1 or above, so the radio can stay in RX.
+ *****************************************************************************/
+void wake_window_open(void);
+
+/**************************************************************************//**
+ * Restarts the window if it's open, does nothing otherwise.
+ *
+ * Can be called from interrupt context.
+ *****************************************************************************/
+void wake_window_extend(void);
+
+/**************************************************************************//**
+ * Tells whether a window is open.
+ *
+ * @returns true if the window is open
+ *****************************************************************************/
+bool wake_window_is_open(void);
+
+/**************************************************************************//**
+ * Gives access to the window counters.
+ *
+ * @returns Pointer to the counters
+ *****************************************************************************/
+const wake_window_stats_t *wake_window_get_stats(void);
+
+#endif  // WAKE_WINDOW_H